@@ -0,0 +1,230 @@
+clear all;
+
+%% 앵커 자동 측량
+% 모든 앵커에서 14.Anchor_Survey 예제가 보내는 "보낸 앵커|상대 앵커|중앙값|분산|교환 수" 라인을 모아
+% 앵커 쌍 사이 거리를 구하고, 고전적 MDS로 초기 배치를 만든 뒤 비선형 최소제곱(Levenberg-Marquardt)으로 다듬는다.
+% 좌표계: 첫 번째 앵커가 원점, 두 번째 앵커가 +x 축, 세 번째 앵커가 y > 0, (3D) 네 번째 앵커가 z > 0
+% 거리만으로는 거울상을 구분할 수 없으므로 마지막 두 조건은 방향을 정하는 약속이다.
+
+%% 앵커 연결 포트와 주소 (환경에 맞게 변경, 스케치의 SURVEY_ANCHORS 순서와 같게)
+portNames = {'/dev/ttyUSB0', '/dev/ttyUSB1', '/dev/ttyUSB2', '/dev/ttyUSB3'};
+anchorAddresses = [1, 2, 3, 4];
+baudRate = 115200;
+samplesPerPair = 160; % 스케치의 SAMPLES_PER_PAIR
+surveyTimeout = 600; % 최대 수집 시간 [s]
+dim = 3; % 3이면 MultiSerialCommPoint_final.m의 AP_coords, 2이면 평면 배치
+numAnchors = numel(portNames);
+
+%% 시리얼 포트 열기
+serialObjects = [];
+for i = 1:numAnchors
+    serialObjects{i} = serialport(portNames{i}, baudRate);
+    configureTerminator(serialObjects{i}, "LF");
+    flush(serialObjects{i});
+    disp(['Opened serial port: ', portNames{i}]);
+end
+
+%% 쌍 별 burst 중앙값과 교환 수 수집 (i < j 만 사용)
+burstMedians = cell(numAnchors);
+counts = zeros(numAnchors);
+pairMask = triu(true(numAnchors), 1);
+
+disp('Start surveying...');
+tic;
+
+while any(counts(pairMask) < samplesPerPair) && toc < surveyTimeout
+    for k = 1:numAnchors
+        if serialObjects{k}.NumBytesAvailable == 0
+            continue;
+        end
+        rawData = readline(serialObjects{k});
+        data = split(strtrim(rawData), '|');
+        if numel(data) ~= 5
+            continue; % 측량 결과가 아닌 라인
+        end
+
+        i = find(anchorAddresses == str2double(data{1}), 1);
+        j = find(anchorAddresses == str2double(data{2}), 1);
+        if isempty(i) || isempty(j) || i == j
+            continue;
+        end
+        if i > j
+            [i, j] = deal(j, i);
+        end
+        burstMedians{i, j}(end+1) = str2double(data{3});
+        counts(i, j) = counts(i, j) + str2double(data{5});
+        fprintf('Anchor %d - %d: %.3f m (%d/%d)\n', anchorAddresses(i), anchorAddresses(j), ...
+            str2double(data{3}), counts(i, j), samplesPerPair);
+    end
+    pause(0.0001);
+end
+
+fprintf('Survey complete in %.1f s\n', toc);
+
+%% 시리얼 포트 닫기
+for i = 1:numAnchors
+    clear serialObjects{i};
+    disp(['Closed serial port: ', portNames{i}]);
+end
+
+%% 쌍 별 거리와 가중치 (burst 중앙값의 중앙값, 흩어짐이 작을수록 큰 가중치)
+distances = nan(numAnchors);
+weights = zeros(numAnchors);
+for i = 1:numAnchors
+    for j = i+1:numAnchors
+        if isempty(burstMedians{i, j})
+            fprintf('Anchor %d - %d: no range, left out\n', anchorAddresses(i), anchorAddresses(j));
+            continue;
+        end
+        values = burstMedians{i, j};
+        distances(i, j) = median(values);
+        spread = max(1.4826 * median(abs(values - distances(i, j))), 0.01); % MAD, 최소 1 cm
+        weights(i, j) = numel(values) / spread^2;
+    end
+end
+distances = min(distances, distances'); % nan은 무시하고 대칭으로
+weights = weights + weights';
+
+%% 고전적 MDS로 초기 배치, 측정 안 된 쌍은 최단 경로 거리로 채움
+X = classicalMds(fillMissing(distances), dim);
+
+%% 비선형 최소제곱으로 측정 거리에 맞춤
+[X, residuals] = refineLayout(X, distances, weights);
+AP_coords = fixFrame(X);
+if dim == 2
+    AP_coords = [AP_coords, zeros(numAnchors, 1)];
+end
+
+%% 결과
+disp('Pair residuals [m]:');
+for i = 1:numAnchors
+    for j = i+1:numAnchors
+        if ~isnan(residuals(i, j))
+            fprintf('  %d - %d: measured %.3f, residual %+.3f\n', anchorAddresses(i), anchorAddresses(j), ...
+                distances(i, j), residuals(i, j));
+        end
+    end
+end
+fprintf('RMS residual: %.3f m\n', sqrt(mean(residuals(~isnan(residuals)).^2)));
+
+disp('AP_coords = [');
+for i = 1:numAnchors
+    fprintf('    %.3f, %.3f, %.3f; %% anchor %d\n', AP_coords(i, 1), AP_coords(i, 2), AP_coords(i, 3), anchorAddresses(i));
+end
+disp('];');
+disp('5.Triangulation_Tag:');
+for i = 1:min(numAnchors, 3)
+    fprintf('Position position_%c = {%.3f,%.3f};\n', 'A' + i - 1, AP_coords(i, 1), AP_coords(i, 2));
+end
+
+save('anchor_survey.mat', 'AP_coords', 'anchorAddresses', 'distances', 'weights');
+
+%% 플롯
+figure;
+plot3(AP_coords(:,1), AP_coords(:,2), AP_coords(:,3), 'r^', 'MarkerFaceColor', 'r');
+hold on;
+for i = 1:numAnchors
+    text(AP_coords(i,1), AP_coords(i,2), AP_coords(i,3), ['  ', num2str(anchorAddresses(i))]);
+end
+grid on;
+axis equal;
+title('Surveyed Anchor Coordinates');
+xlabel('X [m]');
+ylabel('Y [m]');
+zlabel('Z [m]');
+
+%% 측정 안 된 쌍을 최단 경로 거리로 채움 (Floyd-Warshall)
+function D = fillMissing(D)
+    n = size(D, 1);
+    D(isnan(D)) = inf;
+    D(1:n+1:end) = 0;
+    for k = 1:n
+        D = min(D, D(:, k) + D(k, :));
+    end
+    if any(isinf(D(:)))
+        error('Anchor survey: some anchors were never ranged');
+    end
+end
+
+%% 고전적 MDS: 이중 중심화한 거리 제곱 행렬의 상위 고유벡터
+function X = classicalMds(D, dim)
+    n = size(D, 1);
+    J = eye(n) - ones(n) / n;
+    B = -0.5 * J * (D.^2) * J;
+    [V, L] = eig((B + B') / 2);
+    [L, order] = sort(diag(L), 'descend');
+    V = V(:, order);
+    X = V(:, 1:dim) .* sqrt(max(L(1:dim), 0))';
+end
+
+%% Levenberg-Marquardt, residuals = 맞춘 거리 - 측정 거리
+function [X, residuals] = refineLayout(X, D, W)
+    [n, dim] = size(X);
+    [I, J] = find(triu(~isnan(D), 1));
+    d = D(sub2ind([n, n], I, J));
+    w = sqrt(W(sub2ind([n, n], I, J)));
+    lambda = 1e-3;
+
+    cost = layoutCost(X, I, J, d, w);
+    for iteration = 1:100
+        delta = X(I, :) - X(J, :);
+        len = max(sqrt(sum(delta.^2, 2)), 1e-9);
+        r = w .* (len - d);
+        u = w .* delta ./ len;
+
+        A = zeros(numel(d), n * dim);
+        for k = 1:numel(d)
+            A(k, I(k) + (0:dim-1) * n) = u(k, :);
+            A(k, J(k) + (0:dim-1) * n) = -u(k, :);
+        end
+
+        % 이동과 회전은 거리를 바꾸지 않아 J'J가 특이 행렬이므로 감쇠로 풀어냄
+        H = A' * A;
+        step = -(H + lambda * diag(diag(H) + 1e-9)) \ (A' * r);
+        candidate = X + reshape(step, n, dim);
+        candidateCost = layoutCost(candidate, I, J, d, w);
+        if candidateCost < cost
+            X = candidate;
+            lambda = max(lambda / 10, 1e-9);
+            if cost - candidateCost < 1e-12 * max(cost, 1)
+                break;
+            end
+            cost = candidateCost;
+        else
+            lambda = lambda * 10;
+            if lambda > 1e9
+                break;
+            end
+        end
+    end
+
+    residuals = nan(n);
+    fitted = sqrt(sum((X(I, :) - X(J, :)).^2, 2));
+    residuals(sub2ind([n, n], I, J)) = fitted - d;
+end
+
+function cost = layoutCost(X, I, J, d, w)
+    len = sqrt(sum((X(I, :) - X(J, :)).^2, 2));
+    cost = sum((w .* (len - d)).^2);
+end
+
+%% 첫 번째 앵커를 원점, 두 번째를 +x 축, 세 번째를 y > 0, 네 번째를 z > 0 으로 옮김
+function X = fixFrame(X)
+    [n, dim] = size(X);
+    X = X - X(1, :);
+    e1 = X(2, :) / norm(X(2, :));
+    if dim == 2
+        R = [e1', [-e1(2); e1(1)]];
+    else
+        v = X(3, :) - dot(X(3, :), e1) * e1;
+        e2 = v / norm(v);
+        R = [e1', e2', cross(e1, e2)'];
+    end
+    X = X * R;
+    if X(3, 2) < 0
+        X(:, 2) = -X(:, 2);
+    end
+    if dim == 3 && n >= 4 && X(4, 3) < 0
+        X(:, 3) = -X(:, 3);
+    end
+end
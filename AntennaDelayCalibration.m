@@ -0,0 +1,123 @@
+clear all;
+
+%% 안테나 지연 보정 (3대 이상, 거리를 아는 배치)
+% 모든 장치에서 15.Antenna_Delay_Calibration 예제가 보내는
+% "보낸 장치|상대 장치|중앙값|분산|교환 수|EUI|tx 지연|rx 지연|칩 온도" 라인을 모아
+% 장치 별 지연 오차를 최소제곱으로 구한다.
+% DS-TWR 거리 오차 = (e_i + e_j), e_i = 장치 i의 (tx + rx 지연 오차) / 2 를 거리로 바꾼 값
+% 왕복 측정으로는 tx와 rx 지연의 합만 알 수 있으므로, 합을 txShare 비율로 나누어 tx/rx에 준다.
+
+%% 장치 연결 포트, 주소, 실제 거리 (환경에 맞게 변경)
+portNames = {'/dev/ttyUSB0', '/dev/ttyUSB1', '/dev/ttyUSB2'};
+deviceAddresses = [1, 2, 3];
+trueDistances = [0.0, 3.0, 4.0;
+                 3.0, 0.0, 5.0;
+                 4.0, 5.0, 0.0]; % 장치 사이 실제 거리 [m]
+baudRate = 115200;
+samplesPerPair = 160; % 스케치의 SAMPLES_PER_PAIR, 방향마다
+collectTimeout = 600; % 최대 수집 시간 [s]
+txShare = 0.5; % 지연 합 중 tx 지연의 비율
+numDevices = numel(portNames);
+
+%% DW1000 시간 상수
+DISTANCE_OF_RADIO = 0.0046917639786159; % 1 tick 동안 전파가 이동하는 거리 [m]
+
+%% 시리얼 포트 열기
+serialObjects = [];
+for i = 1:numDevices
+    serialObjects{i} = serialport(portNames{i}, baudRate);
+    configureTerminator(serialObjects{i}, "LF");
+    flush(serialObjects{i});
+    disp(['Opened serial port: ', portNames{i}]);
+end
+
+%% burst 수집 (방향 별로 교환 수를 셈)
+bursts = zeros(0, 4); % [보낸 장치, 상대 장치, 중앙값, 교환 수]
+counts = zeros(numDevices);
+euis = strings(1, numDevices);
+txDelays = nan(1, numDevices);
+rxDelays = nan(1, numDevices);
+temperatures = cell(1, numDevices);
+pairMask = ~eye(numDevices);
+
+disp('Start calibration ranging...');
+tic;
+
+while any(counts(pairMask) < samplesPerPair) && toc < collectTimeout
+    for k = 1:numDevices
+        if serialObjects{k}.NumBytesAvailable == 0
+            continue;
+        end
+        rawData = readline(serialObjects{k});
+        data = split(strtrim(rawData), '|');
+        if numel(data) ~= 9
+            continue; % 보정 결과가 아닌 라인
+        end
+
+        i = find(deviceAddresses == str2double(data{1}), 1);
+        j = find(deviceAddresses == str2double(data{2}), 1);
+        if isempty(i) || isempty(j) || i == j
+            continue;
+        end
+        exchanges = str2double(data{5});
+        bursts(end+1, :) = [i, j, str2double(data{3}), exchanges];
+        counts(i, j) = counts(i, j) + exchanges;
+        euis(i) = erase(string(data{6}), ':');
+        txDelays(i) = str2double(data{7});
+        rxDelays(i) = str2double(data{8});
+        temperatures{i}(end+1) = str2double(data{9});
+        fprintf('Device %d -> %d: %.3f m (%d/%d)\n', deviceAddresses(i), deviceAddresses(j), ...
+            str2double(data{3}), counts(i, j), samplesPerPair);
+    end
+    pause(0.0001);
+end
+
+fprintf('Collection complete in %.1f s, %d bursts\n', toc, size(bursts, 1));
+
+%% 시리얼 포트 닫기
+for i = 1:numDevices
+    clear serialObjects{i};
+    disp(['Closed serial port: ', portNames{i}]);
+end
+
+if any(isnan(txDelays))
+    error('Antenna delay calibration: some devices never reported a burst');
+end
+
+%% 가중 최소제곱: 각 burst 중앙값 - 실제 거리 = e_i + e_j, 가중치는 교환 수
+numBursts = size(bursts, 1);
+A = zeros(numBursts, numDevices);
+A(sub2ind(size(A), (1:numBursts)', bursts(:, 1))) = 1;
+A(sub2ind(size(A), (1:numBursts)', bursts(:, 2))) = 1;
+b = bursts(:, 3) - trueDistances(sub2ind([numDevices, numDevices], bursts(:, 1), bursts(:, 2)));
+W = bursts(:, 4);
+
+% 장치가 2대뿐이거나 쌍이 부족하면 e_i를 나눌 수 없음
+if rank(A) < numDevices
+    error('Antenna delay calibration: the pairs do not determine every device, use at least three devices');
+end
+rangeErrors = (A' * (W .* A)) \ (A' * (W .* b));
+residuals = b - A * rangeErrors;
+
+%% 거리 오차를 지연 tick으로 바꿈 (거리가 길게 나오면 지연을 늘림)
+delayCorrections = 2 * rangeErrors' / DISTANCE_OF_RADIO;
+totalDelays = round(txDelays + rxDelays + delayCorrections);
+newTxDelays = round(totalDelays * txShare);
+newRxDelays = totalDelays - newTxDelays;
+calibrationTemperatures = cellfun(@mean, temperatures); % 온도 보정의 기준 온도
+
+%% 결과
+for i = 1:numDevices
+    fprintf('Device %d (%s): range error %+.3f m, delay %d/%d -> %d/%d\n', deviceAddresses(i), euis(i), ...
+        rangeErrors(i), txDelays(i), rxDelays(i), newTxDelays(i), newRxDelays(i));
+end
+fprintf('RMS residual after correction: %.3f m\n', sqrt(sum(W .* residuals.^2) / sum(W)));
+
+disp('ANTENNA_DELAYS entries (온도 기울기 delay_slope, bias_slope는 장치 별로 측정해서 채움):');
+for i = 1:numDevices
+    fprintf('    {0x%sULL, %d, %d, %.1f, 0, 0}, // device %d\n', euis(i), newTxDelays(i), newRxDelays(i), ...
+        calibrationTemperatures(i), deviceAddresses(i));
+end
+
+save('antenna_delays.mat', 'euis', 'newTxDelays', 'newRxDelays', 'rangeErrors', 'deviceAddresses', ...
+    'calibrationTemperatures');
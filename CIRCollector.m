@@ -0,0 +1,183 @@
+clear all;
+
+%% 압축 CIR 수집기
+% 6.CIR_Receiver_Binary 예제가 보내는 압축 CIR 프레임을 받아 복원한다.
+% 프레임: 0xA5 0x5A | 시퀀스(1) | 첫 인덱스(2) | FP_INDEX 10.6(2) | 샘플 수(2) | 블록들 | 체크섬(1)
+% 블록(최대 16 샘플): 지수<<4 | Rice 파라미터(1) | 비트 길이(1) | 비트열
+% 정수는 리틀 엔디언, 비트열은 MSB부터, 체크섬은 동기 바이트 이후 바이트 합 (mod 256)
+
+%% 설정 (환경에 맞게 변경)
+portName = '/dev/ttyUSB0';
+baudRate = 1000000;
+numCIRs = 1000; % 수집할 CIR 개수
+COMPRESSION_BLOCK = 16;
+
+%% 시리얼 포트 열기
+serialObject = serialport(portName, baudRate);
+flush(serialObject);
+disp(['Opened serial port: ', portName]);
+
+cirs = {};
+fpIndices = zeros(1, numCIRs);
+firstIndices = zeros(1, numCIRs);
+sequences = zeros(1, numCIRs);
+buffer = uint8([]);
+received = 0;
+lost = 0;
+lastSequence = -1;
+
+disp('Start receiving CIRs...');
+tic;
+
+while received < numCIRs
+    if serialObject.NumBytesAvailable > 0
+        buffer = [buffer; read(serialObject, serialObject.NumBytesAvailable, "uint8")'];
+    end
+
+    while true
+        [frame, used] = decodeFrame(buffer, COMPRESSION_BLOCK);
+        if used == 0
+            break; % 프레임이 아직 다 도착하지 않음
+        end
+        buffer = buffer(used+1:end);
+        if isempty(frame)
+            continue; % 깨진 프레임은 버림
+        end
+
+        received = received + 1;
+        cirs{received} = frame.samples;
+        fpIndices(received) = frame.fpIndex;
+        firstIndices(received) = frame.firstIndex;
+        sequences(received) = frame.sequence;
+        if lastSequence >= 0
+            lost = lost + mod(frame.sequence - lastSequence - 1, 256);
+        end
+        lastSequence = frame.sequence;
+        if received >= numCIRs
+            break;
+        end
+    end
+    pause(0.0001);
+end
+
+elapsed = toc;
+fprintf('Data collection complete: %d CIRs in %.2f s (%.1f CIR/s), %d lost\n', received, elapsed, received / elapsed, lost);
+
+%% 시리얼 포트 닫기
+clear serialObject;
+disp(['Closed serial port: ', portName]);
+
+%% 저장
+save('cir_data.mat', 'cirs', 'fpIndices', 'firstIndices', 'sequences');
+
+%% 플롯 (마지막 CIR의 진폭과 첫 번째 경로 위치)
+samples = cirs{received};
+index = firstIndices(received) + (0:numel(samples)-1);
+figure;
+plot(index, abs(samples));
+hold on;
+xline(fpIndices(received), 'r--');
+grid on;
+title('Channel Impulse Response');
+xlabel('Accumulator index');
+ylabel('Amplitude');
+
+%% 버퍼 앞부분에서 프레임 하나를 찾아 복원
+% used: 소비한 바이트 수 (0이면 데이터가 더 필요), frame: 복원 결과 (깨진 프레임이면 빈 값)
+function [frame, used] = decodeFrame(buffer, blockSize)
+    frame = [];
+    used = 0;
+    n = numel(buffer);
+
+    % 동기 바이트 찾기
+    start = find(buffer(1:end-1) == 165 & buffer(2:end) == 90, 1);
+    if isempty(start)
+        used = max(n - 1, 0); % 마지막 바이트는 동기 바이트의 앞부분일 수 있음
+        return;
+    end
+    if start > 1
+        used = start - 1;
+        return;
+    end
+    if n < 9
+        return;
+    end
+
+    b = double(buffer);
+    sequence = b(3);
+    firstIndex = b(4) + 256 * b(5);
+    fpIndex = (b(6) + 256 * b(7)) / 64;
+    count = b(8) + 256 * b(9);
+    if count > 1016
+        used = 1; % 잘못 찾은 동기 바이트
+        return;
+    end
+
+    samples = zeros(1, count);
+    p = 10;
+    for done = 0:blockSize:count-1
+        if p + 1 > n
+            return;
+        end
+        exponent = bitshift(b(p), -4);
+        k = bitand(b(p), 15);
+        len = b(p + 1);
+        if p + 1 + len > n
+            return;
+        end
+        samplesInBlock = min(blockSize, count - done);
+        bits = reshape(dec2bin(b(p+2:p+1+len), 8)', 1, []) == '1';
+        values = decodeRice(bits, 2 * samplesInBlock, k);
+        % I, Q 각각 이전 값과의 차이로 저장되어 있음
+        re = cumsum(values(1:2:end)) * 2^exponent;
+        im = cumsum(values(2:2:end)) * 2^exponent;
+        samples(done+1:done+samplesInBlock) = re + 1i * im;
+        p = p + 2 + len;
+    end
+    if p > n
+        return;
+    end
+
+    used = p;
+    if mod(sum(b(3:p-1)), 256) ~= b(p)
+        disp('Checksum error, frame dropped');
+        return;
+    end
+    frame.sequence = sequence;
+    frame.firstIndex = firstIndex;
+    frame.fpIndex = fpIndex;
+    frame.samples = samples;
+end
+
+%% Rice 복호 (몫이 15면 18비트 원본 값), zigzag 역변환
+function values = decodeRice(bits, count, k)
+    values = zeros(1, count);
+    pos = 1;
+    for i = 1:count
+        q = 0;
+        while q < 15 && bits(pos)
+            q = q + 1;
+            pos = pos + 1;
+        end
+        if q == 15
+            m = bitsToValue(bits(pos:pos+17));
+            pos = pos + 18;
+        else
+            pos = pos + 1; % 종료 비트 0
+            m = q * 2^k + bitsToValue(bits(pos:pos+k-1));
+            pos = pos + k;
+        end
+        if mod(m, 2) == 1
+            values(i) = -(m + 1) / 2;
+        else
+            values(i) = m / 2;
+        end
+    end
+end
+
+function value = bitsToValue(bits)
+    value = 0;
+    for i = 1:numel(bits)
+        value = value * 2 + bits(i);
+    end
+end
@@ -61,6 +61,11 @@ AP_coords = [0, 0, 0;  % AP1
              1, 0, 0;  % AP2
              0, 1, 0;  % AP3
              0, 0, 1]; % AP4
+% AnchorSurvey.m로 측량한 좌표가 있으면 그것을 사용 (포트 순서와 측량 앵커 순서가 같아야 함)
+if isfile('anchor_survey.mat')
+    load('anchor_survey.mat', 'AP_coords');
+    disp('Using surveyed AP coordinates from anchor_survey.mat');
+end
          
 %% 평면 방정식 설정 (AP 평면 계산)
 % 법선 벡터 계산 (AP1, AP2, AP3 사용)
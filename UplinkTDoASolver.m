@@ -0,0 +1,128 @@
+clear all;
+
+%% Uplink TDoA 호스트 솔버
+% 각 앵커(8.UplinkTDoA_Anchor, 8.UplinkTDoA_Reference_Anchor)가 시리얼로 보내는
+% "태그 EUI|blink 시퀀스|기준 시간 상위 32비트|기준 시간 하위 32비트" 라인을 모아
+% 같은 blink를 받은 앵커들의 도착 시간 차이로 태그 위치를 계산한다.
+
+%% 앵커 연결 포트와 좌표 (환경에 맞게 변경, 첫 번째가 기준 앵커)
+portNames = {'/dev/ttyUSB0', '/dev/ttyUSB1', '/dev/ttyUSB2', '/dev/ttyUSB3'};
+anchorPos = [0.0, 0.0;
+             1.2, 0.0;
+             1.2, 1.2;
+             0.0, 1.2];
+baudRate = 1000000;
+numFixes = 1000; % 계산할 위치 개수
+numAnchors = numel(portNames);
+
+%% DW1000 시간 상수
+DISTANCE_OF_RADIO = 0.0046917639786159; % 1 tick 동안 전파가 이동하는 거리 [m]
+TIME_OVERFLOW = 2^40;
+
+%% 시리얼 포트 열기
+serialObjects = [];
+for i = 1:numAnchors
+    serialObjects{i} = serialport(portNames{i}, baudRate);
+    configureTerminator(serialObjects{i}, "LF");
+    flush(serialObjects{i});
+    disp(['Opened serial port: ', portNames{i}]);
+end
+
+%% blink 별로 앵커 타임스탬프를 모으는 테이블 (key = EUI_시퀀스)
+pending = containers.Map();
+arrivals = containers.Map(); % blink 별 첫 라인을 받은 호스트 시간 [s]
+positions = nan(2, numFixes);
+fix = 0;
+lastPos = mean(anchorPos, 1);
+
+disp('Start receiving blinks...');
+tic;
+
+while fix < numFixes
+    for i = 1:numAnchors
+        if serialObjects{i}.NumBytesAvailable == 0
+            continue;
+        end
+        rawData = readline(serialObjects{i});
+        data = split(strtrim(rawData), '|');
+        if numel(data) ~= 4
+            continue;
+        end
+
+        key = [char(data{1}), '_', char(data{2})];
+        t = str2double(data{3}) * 2^32 + str2double(data{4});
+
+        if ~isKey(pending, key)
+            pending(key) = nan(1, numAnchors);
+            arrivals(key) = toc;
+        end
+        times = pending(key);
+        times(i) = t;
+
+        if all(~isnan(times))
+            remove(pending, key);
+            remove(arrivals, key);
+            pos = solveTdoa(anchorPos, times, lastPos, DISTANCE_OF_RADIO, TIME_OVERFLOW);
+            if ~any(isnan(pos))
+                fix = fix + 1;
+                positions(:, fix) = pos;
+                lastPos = pos';
+                fprintf('Fix %d: x = %.3f, y = %.3f\n', fix, pos(1), pos(2));
+            end
+        else
+            pending(key) = times;
+        end
+    end
+
+    % blink를 일부 앵커만 받은 경우 테이블이 계속 커지지 않도록 가장 오래된 blink부터 정리
+    % (keys는 사전 순이라 EUI/시퀀스 순서일 뿐 도착 순서가 아님)
+    if pending.Count > 50
+        keysList = keys(arrivals);
+        [~, order] = sort(cell2mat(values(arrivals, keysList)));
+        stale = keysList(order(1:25));
+        remove(pending, stale);
+        remove(arrivals, stale);
+    end
+    pause(0.0001);
+end
+
+disp('Data collection complete.');
+
+%% 시리얼 포트 닫기
+for i = 1:numAnchors
+    clear serialObjects{i};
+    disp(['Closed serial port: ', portNames{i}]);
+end
+
+%% 플롯
+figure;
+plot(positions(1,:), positions(2,:), 'o');
+hold on;
+plot(anchorPos(:,1), anchorPos(:,2), 'r^', 'MarkerFaceColor', 'r');
+grid on;
+axis equal;
+title('Uplink TDoA Tag Positions');
+xlabel('X [m]');
+ylabel('Y [m]');
+
+%% 도착 시간 차이로 2D 위치 계산 (Gauss-Newton)
+function pos = solveTdoa(anchorPos, times, initial, distanceOfRadio, timeOverflow)
+    % 기준 앵커(첫 번째) 대비 거리 차이, 40비트 시간 wrap 처리
+    dt = mod(times - times(1), timeOverflow);
+    dt(dt > timeOverflow / 2) = dt(dt > timeOverflow / 2) - timeOverflow;
+    rangeDiff = dt * distanceOfRadio;
+
+    pos = initial(:);
+    for iteration = 1:20
+        d = sqrt(sum((anchorPos' - pos).^2, 1));
+        d(d < 1e-6) = 1e-6;
+        r = (d(2:end) - d(1)) - rangeDiff(2:end);
+        J = ((pos - anchorPos(2:end,:)') ./ d(2:end) - (pos - anchorPos(1,:)') / d(1))';
+        step = -(J' * J) \ (J' * r');
+        pos = pos + step;
+        if norm(step) < 1e-3
+            return;
+        end
+    end
+    pos = nan(2, 1);
+end
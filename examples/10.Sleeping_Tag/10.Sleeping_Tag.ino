@@ -0,0 +1,142 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 
+ * 10.Sleeping_Tag.ino
+ * 
+ * Keeps the DW1000 in deep sleep between range bursts. spiWakeup restores the configuration
+ * from the driver shadows, the sketch prints the wake up time, the latency from the wake up to the first poll
+ * on air (its RMARKER, timed by the DW1000 clock) with its minimum, mean and maximum so far,
+ * and the time from the wake up to the result.
+ * Any anchor running anchorRangeAcceptMultiTag (e.g. 5.Triangulation_B_Anchor) answers the burst.
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangTime.hpp>
+#include <DW1000JangConstants.hpp>
+#include <DW1000JangRanging.hpp>
+#include <DW1000JangRTLS.hpp>
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_SS = 10; // spi select pin
+const uint8_t PIN_RST = 7;
+#endif
+
+const uint16_t TARGET_ANCHOR = 2;
+const uint8_t BURST_EXCHANGES = 3;
+const uint32_t SLEEP_PERIOD_MS = 1000;
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t TAG_FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    false
+};
+
+sleep_configuration_t SLEEP_CONFIG = {
+    false,  // onWakeUpRunADC
+    false,  // onWakeUpReceive
+    false,  // onWakeUpLoadEUI
+    true,   // onWakeUpLoadL64Param
+    true,   // preserveSleep
+    true,   // enableSLP
+    false,  // enableWakePIN
+    true    // enableWakeSPI
+};
+
+void setup() {
+    // DEBUG monitoring
+    Serial.begin(115200);
+    Serial.println(F("### DW1000Jang-arduino-sleeping-tag ###"));
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println("DW1000Jang initialized ...");
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(TAG_FRAME_FILTER_CONFIG);
+
+    DW1000Jang::setDeviceAddress(14);
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+
+    DW1000Jang::setAntennaDelay(16436);
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(5000);
+
+    DW1000Jang::applySleepConfiguration(SLEEP_CONFIG);
+
+    Serial.println(F("Committed configuration ..."));
+}
+
+uint32_t latencyMin = UINT32_MAX;
+uint32_t latencyMax = 0;
+uint64_t latencySum = 0;
+uint32_t latencyCount = 0;
+
+void loop() {
+    DW1000Jang::deepSleep();
+    delay(SLEEP_PERIOD_MS);
+
+    uint32_t wakeStart = micros();
+    if(!DW1000Jang::spiWakeup()) {
+        Serial.println(F("wake up failed"));
+        return;
+    }
+    /* same instant in both clocks, the first poll is then timed by its TX timestamp */
+    uint64_t awakeTime = DW1000Jang::getSystemTimestamp();
+    uint32_t awakeMicros = micros();
+    RangeBurstResult burst = DW1000JangRTLS::tagRangeBurst(TARGET_ANCHOR, BURST_EXCHANGES);
+    uint32_t wakeToResult = micros() - wakeStart;
+
+    uint64_t pollTicks = (burst.first_poll_sent + TIME_OVERFLOW - awakeTime) % TIME_OVERFLOW;
+    uint32_t wakeToFirstPoll = (awakeMicros - wakeStart) + static_cast<uint32_t>(pollTicks * TIME_RES);
+    if(wakeToFirstPoll < latencyMin) latencyMin = wakeToFirstPoll;
+    if(wakeToFirstPoll > latencyMax) latencyMax = wakeToFirstPoll;
+    latencySum += wakeToFirstPoll;
+    latencyCount++;
+
+    Serial.print("wake up: "); Serial.print(DW1000Jang::getWakeupDuration());
+    Serial.print(" us, wake to first poll: "); Serial.print(wakeToFirstPoll);
+    Serial.print(" us (min "); Serial.print(latencyMin);
+    Serial.print(" mean "); Serial.print(static_cast<uint32_t>(latencySum / latencyCount));
+    Serial.print(" max "); Serial.print(latencyMax);
+    Serial.print("), wake to result: "); Serial.print(wakeToResult);
+    Serial.print(" us");
+    if(burst.success) {
+        Serial.print(", range: "); Serial.print(burst.mean, 3);
+        Serial.print(" std: "); Serial.print(sqrt(burst.variance), 3);
+    }
+    Serial.println();
+}
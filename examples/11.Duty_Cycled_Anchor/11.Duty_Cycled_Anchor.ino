@@ -0,0 +1,129 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 
+ * 11.Duty_Cycled_Anchor.ino
+ * 
+ * Answers the blinks of duty cycled tags (11.Duty_Cycled_Tag) with a ranging initiation, ranges with the tag
+ * and closes the exchange with ActivityFinished carrying the blink rate the tag has to sleep for.
+ * Blinks are awaited with the preamble sniff mode to cut the listening current of the anchor.
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangFrames.hpp>
+#include <DW1000JangRanging.hpp>
+#include <DW1000JangRTLS.hpp>
+
+using namespace DW1000JangFrames;
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_RST = 7;
+const uint8_t PIN_SS = 10; // spi select pin
+#endif
+
+/* Blink rate field of ActivityFinished: 14 bit value, bits 14-15 select the unit (0: ms, 1: 25 ms, 2: s) */
+const uint16_t BLINK_RATE = (0x02 << 14) | 2; // 2 s
+/* Short address given to the tag */
+const uint16_t TAG_SHORT_ADDRESS = 14;
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t ANCHOR_FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    true /* This allows blink frames */
+};
+
+void setup() {
+    // DEBUG monitoring
+    Serial.begin(115200);
+    Serial.println(F("### DW1000Jang-arduino-duty-cycled-anchor ###"));
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println(F("DW1000Jang initialized ..."));
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(ANCHOR_FRAME_FILTER_CONFIG);
+
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(8000);
+
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+    DW1000Jang::setDeviceAddress(1);
+	
+    DW1000Jang::setAntennaDelay(16436);
+
+    /* finalMessageDelay of 11.Duty_Cycled_Tag, the receiver opens just before the final */
+    DW1000JangRTLS::setFinalMessageDelay(1500);
+
+    /* the receiver waits for blinks with the preamble sniff mode, the exchange itself runs fully on */
+    if(!DW1000JangRTLS::setSniffListening(true)) {
+        Serial.println(F("Preamble too short for sniff mode, listening continuously"));
+    }
+    
+    Serial.println(F("Committed configuration ..."));
+    // DEBUG chip info and registers pretty printed
+    char msg[128];
+    DW1000Jang::getPrintableDeviceIdentifier(msg);
+    Serial.print("Device ID: "); Serial.println(msg);
+    DW1000Jang::getPrintableExtendedUniqueIdentifier(msg);
+    Serial.print("Unique ID: "); Serial.println(msg);
+    DW1000Jang::getPrintableNetworkIdAndShortAddress(msg);
+    Serial.print("Network ID & Device Address: "); Serial.println(msg);
+    DW1000Jang::getPrintableDeviceMode(msg);
+    Serial.print("Device mode: "); Serial.println(msg);    
+}
+
+void loop() {
+    if(!DW1000JangRTLS::receiveFrame()) {
+        return;
+    }
+
+    ReceivedFrame frame;
+    frame.read();
+    if(!frame.is<Blink>()) {
+        return;
+    }
+
+    byte tag_short_address[2];
+    DW1000JangUtils::writeValueToBytes(tag_short_address, TAG_SHORT_ADDRESS, 2);
+    DW1000JangRTLS::transmitRangingInitiation(frame.as<Blink>().at<Blink::TagEui>(), tag_short_address);
+    DW1000JangRTLS::waitForTransmission();
+
+    RangeAcceptResult result = DW1000JangRTLS::anchorRangeAccept(NextActivity::ACTIVITY_FINISHED, BLINK_RATE);
+    if(result.success) {
+        Serial.print("Range: "); Serial.print(result.range); Serial.println(" m");
+    }
+}
@@ -0,0 +1,114 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 
+ * 11.Duty_Cycled_Tag.ino
+ * 
+ * Localizes once per blink rate and keeps the DW1000 in deep sleep in between.
+ * The blink rate is dictated by the anchor (11.Duty_Cycled_Anchor) in its ActivityFinished message,
+ * the sketch prints the time awake and the estimated energy of each period.
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangTime.hpp>
+#include <DW1000JangConstants.hpp>
+#include <DW1000JangRanging.hpp>
+#include <DW1000JangRTLS.hpp>
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_SS = 10; // spi select pin
+const uint8_t PIN_RST = 7;
+#endif
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t TAG_FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    false
+};
+
+sleep_configuration_t SLEEP_CONFIG = {
+    false,  // onWakeUpRunADC
+    false,  // onWakeUpReceive
+    false,  // onWakeUpLoadEUI
+    true,   // onWakeUpLoadL64Param
+    true,   // preserveSleep
+    true,   // enableSLP
+    false,  // enableWakePIN
+    true    // enableWakeSPI
+};
+
+/* Set the MCU currents of the board (mA) to include them in the estimate, mcu_sleep can point to a low power sleep */
+DutyCycleTag tag = {
+    DEFAULT_BLINK_RATE_MS,  // blink_rate
+    0,                      // next_wake
+    nullptr,                // mcu_sleep
+    0,                      // mcu_active_current
+    0                       // mcu_sleep_current
+};
+
+void setup() {
+    // DEBUG monitoring
+    Serial.begin(115200);
+    Serial.println(F("### DW1000Jang-arduino-duty-cycled-tag ###"));
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println("DW1000Jang initialized ...");
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(TAG_FRAME_FILTER_CONFIG);
+
+    DW1000Jang::setDeviceAddress(14);
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+
+    DW1000Jang::setAntennaDelay(16436);
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(5000);
+
+    DW1000Jang::applySleepConfiguration(SLEEP_CONFIG);
+
+    Serial.println(F("Committed configuration ..."));
+}
+
+void loop() {
+    DutyCycleResult result = DW1000JangRTLS::tagDutyCycledLocalize(tag, 1500);
+
+    Serial.print(result.success ? "fix" : "no fix");
+    Serial.print(", awake: "); Serial.print(result.awake_time);
+    Serial.print(" us, energy: "); Serial.print(result.energy, 1);
+    Serial.print(" uJ, next in: "); Serial.print(result.blink_rate);
+    Serial.println(" ms");
+}
@@ -0,0 +1,143 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 
+ * 12.Adaptive_Rate_Tag.ino
+ * 
+ * Ranges each anchor at a rate that follows the motion of the tag: every 100 ms while it moves,
+ * down to every 5 s once it stands still, without using more than 10% of the channel.
+ * The anchors are found with discovery blinks every 10 s, those silent for 30 s leave the schedule.
+ * Anchors running anchorRangeAcceptMultiTag (5.Triangulation_A/B/C_Anchor) answer the blinks and the exchanges.
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangTime.hpp>
+#include <DW1000JangConstants.hpp>
+#include <DW1000JangRanging.hpp>
+#include <DW1000JangRTLS.hpp>
+#include <DW1000JangScheduler.hpp>
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_SS = 10; // spi select pin
+const uint8_t PIN_RST = 7;
+#endif
+
+/* discovery: replies in slots 1..DISCOVERY_SLOTS, matching setDiscoverySlot of the anchors */
+const byte DISCOVERY_SLOTS = 8;
+const uint16_t DISCOVERY_SLOT_US = 2000;
+const uint32_t DISCOVERY_PERIOD_MS = 10000;
+const uint32_t NEIGHBOR_MAX_AGE_MS = 30000;
+
+uint32_t lastDiscovery = 0;
+
+void discoverAnchors() {
+    DiscoveryResult discovery = DW1000JangRTLS::tagDiscoverAnchors(DISCOVERY_SLOTS, DISCOVERY_SLOT_US);
+    lastDiscovery = millis();
+    DW1000JangRTLS::scheduleNeighbors(NEIGHBOR_MAX_AGE_MS, lastDiscovery);
+
+    Serial.print("discovery: "); Serial.print(discovery.count); Serial.print(" anchors answered,");
+    for(uint8_t i = 0; i < DW1000JangRTLS::getNeighborCount(); i++) {
+        const Neighbor* neighbor = DW1000JangRTLS::getNeighbor(i);
+        Serial.print(" "); Serial.print(neighbor->address);
+        Serial.print(" ("); Serial.print(neighbor->rx_power, 1); Serial.print(" dBm)");
+    }
+    Serial.println();
+}
+
+DW1000JangScheduler::SchedulerConfiguration SCHEDULER_CONFIG = {
+    100,     // min_interval (ms)
+    5000,    // max_interval (ms)
+    2000,    // exchange_airtime (us), poll, response, final and report at 850 kbps
+    100000,  // airtime_budget (us per second)
+    0.1,     // range_step (m)
+    0.05     // range_noise (m)
+};
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t TAG_FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    false
+};
+
+void setup() {
+    // DEBUG monitoring
+    Serial.begin(115200);
+    Serial.println(F("### DW1000Jang-arduino-adaptive-rate-tag ###"));
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println("DW1000Jang initialized ...");
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(TAG_FRAME_FILTER_CONFIG);
+
+    DW1000Jang::setDeviceAddress(14);
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+
+    DW1000Jang::setAntennaDelay(16436);
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(5000);
+
+    DW1000JangScheduler::configure(SCHEDULER_CONFIG);
+    discoverAnchors();
+
+    Serial.println(F("Committed configuration ..."));
+}
+
+void loop() {
+    if(millis() - lastDiscovery >= DISCOVERY_PERIOD_MS) {
+        discoverAnchors();
+    }
+
+    DW1000JangScheduler::ScheduledRange scheduled = DW1000JangScheduler::next(millis());
+    if(!scheduled.due) {
+        delay(scheduled.wait);
+        return;
+    }
+
+    New_structure result = DW1000JangRTLS::Tag_Distance_Request(scheduled.address, 1500);
+    if(!result.success) {
+        DW1000JangScheduler::addFailure(scheduled.address, millis());
+        return;
+    }
+    DW1000JangScheduler::addRange(scheduled.address, result.distance, millis());
+
+    Serial.print("anchor "); Serial.print(scheduled.address);
+    Serial.print(": "); Serial.print(result.distance, 3);
+    Serial.print(" m, speed: "); Serial.print(DW1000JangScheduler::speed(), 2);
+    Serial.print(" m/s, next in: "); Serial.print(DW1000JangScheduler::find(scheduled.address)->interval);
+    Serial.println(" ms");
+}
@@ -0,0 +1,165 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 
+ * 13.Anchor_Selection_Tag.ino
+ * 
+ * Ranges only the 3 anchors with the best geometry (lowest GDOP) around the last position,
+ * at the rate of DW1000JangScheduler. Anchors running anchorRangeAcceptMultiTag flag the range report
+ * when they saw the previous exchange without line of sight, such an anchor is left out for 10 s.
+ * A lost exchange only counts as a failure for the scheduler.
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangTime.hpp>
+#include <DW1000JangConstants.hpp>
+#include <DW1000JangRanging.hpp>
+#include <DW1000JangRTLS.hpp>
+#include <DW1000JangScheduler.hpp>
+#include <DW1000JangAnchorSelection.hpp>
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_SS = 10; // spi select pin
+const uint8_t PIN_RST = 7;
+#endif
+
+const DW1000JangAnchorSelection::AnchorPosition ANCHORS[] = {
+    {1, 0.0, 0.0},
+    {2, 1.2, 0.0},
+    {3, 1.2, 1.2},
+    {4, 0.0, 1.2}
+};
+const uint8_t ANCHOR_COUNT = sizeof(ANCHORS) / sizeof(ANCHORS[0]);
+const uint8_t SELECTED_ANCHORS = 3;
+
+DW1000JangScheduler::SchedulerConfiguration SCHEDULER_CONFIG = {
+    100,     // min_interval (ms)
+    5000,    // max_interval (ms)
+    2000,    // exchange_airtime (us), poll, response, final and report at 850 kbps
+    100000,  // airtime_budget (us per second)
+    0.1,     // range_step (m)
+    0.05     // range_noise (m)
+};
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t TAG_FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    false
+};
+
+DW1000JangAnchorSelection::AnchorSelection selection;
+double x = 0.6;
+double y = 0.6;
+
+void reselect() {
+    DW1000JangAnchorSelection::AnchorSelection candidate = DW1000JangAnchorSelection::select(x, y, SELECTED_ANCHORS, millis());
+    if(candidate.success) {
+        selection = candidate;
+        DW1000JangAnchorSelection::schedule(selection);
+    }
+}
+
+void setup() {
+    // DEBUG monitoring
+    Serial.begin(115200);
+    Serial.println(F("### DW1000Jang-arduino-anchor-selection-tag ###"));
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println("DW1000Jang initialized ...");
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(TAG_FRAME_FILTER_CONFIG);
+
+    DW1000Jang::setDeviceAddress(14);
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+
+    DW1000Jang::setAntennaDelay(16436);
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(5000);
+
+    DW1000JangScheduler::configure(SCHEDULER_CONFIG);
+    DW1000JangAnchorSelection::setAnchors(ANCHORS, ANCHOR_COUNT);
+    reselect();
+
+    Serial.println(F("Committed configuration ..."));
+}
+
+void loop() {
+    DW1000JangScheduler::ScheduledRange scheduled = DW1000JangScheduler::next(millis());
+    if(!scheduled.due) {
+        delay(scheduled.wait);
+        return;
+    }
+
+    New_structure result = DW1000JangRTLS::Tag_Distance_Request(scheduled.address, 1500);
+    if(!result.success) {
+        DW1000JangScheduler::addFailure(scheduled.address, millis());
+        return;
+    }
+    if(result.nlos) {
+        DW1000JangAnchorSelection::markNlos(scheduled.address, millis());
+        reselect();
+        return;
+    }
+    DW1000JangScheduler::addRange(scheduled.address, result.distance, millis());
+
+    /* position from the filtered ranges of the selected anchors */
+    double ranges[DW1000JangAnchorSelection::MAX_SELECTED_ANCHORS];
+    for(uint8_t i = 0; i < selection.count; i++) {
+        DW1000JangScheduler::ScheduledAnchor* anchor = DW1000JangScheduler::find(selection.addresses[i]);
+        if(anchor == nullptr || anchor->samples == 0) {
+            return;
+        }
+        ranges[i] = anchor->range;
+    }
+    DW1000JangAnchorSelection::TagPosition position = DW1000JangAnchorSelection::locate(selection.addresses, ranges, selection.count, x, y);
+    if(!position.success) {
+        return;
+    }
+    x = position.x;
+    y = position.y;
+    reselect();
+
+    Serial.print("x: "); Serial.print(x, 3);
+    Serial.print(" y: "); Serial.print(y, 3);
+    Serial.print(" gdop: "); Serial.print(selection.gdop, 2);
+    Serial.print(" anchors:");
+    for(uint8_t i = 0; i < selection.count; i++) {
+        Serial.print(" "); Serial.print(selection.addresses[i]);
+    }
+    Serial.println();
+}
@@ -0,0 +1,142 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * 14.Anchor_Survey.ino
+ *
+ * Self-survey of the anchors: flash this sketch on every anchor with its own ANCHOR_ADDRESS.
+ * Each anchor answers exchanges like 5.Triangulation_A/B/C_Anchor and, at random moments, ranges
+ * the anchors with a higher address in bursts until SAMPLES_PER_PAIR exchanges were collected per pair.
+ * Two anchors starting a burst at the same time miss each other and simply try again later.
+ * Every burst is printed as "from|to|median|variance|exchanges", AnchorSurvey.m collects the lines
+ * of all anchors and computes the anchor coordinates.
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangRanging.hpp>
+#include <DW1000JangRTLS.hpp>
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_RST = 7;
+const uint8_t PIN_SS = 10; // spi select pin
+#endif
+
+/* change for every anchor, the survey covers all pairs of SURVEY_ANCHORS */
+const uint16_t ANCHOR_ADDRESS = 1;
+uint16_t SURVEY_ANCHORS[] = {1, 2, 3, 4};
+const byte SURVEY_COUNT = sizeof(SURVEY_ANCHORS) / sizeof(SURVEY_ANCHORS[0]);
+
+const uint16_t SAMPLES_PER_PAIR = 160;
+const uint8_t BURST_EXCHANGES = MAX_BURST_EXCHANGES;
+/* pause between two bursts of this anchor, randomized so the anchors do not keep colliding */
+const uint32_t BURST_PAUSE_MIN_MS = 100;
+const uint32_t BURST_PAUSE_MAX_MS = 500;
+
+uint16_t samples[SURVEY_COUNT];
+byte nextPeer = 0;
+uint32_t nextBurst = 0;
+boolean surveyDone = false;
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t ANCHOR_FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    false
+};
+
+void setup() {
+    // DEBUG monitoring
+    Serial.begin(115200);
+    Serial.println(F("### DW1000Jang-arduino-anchor-survey ###"));
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println(F("DW1000Jang initialized ..."));
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(ANCHOR_FRAME_FILTER_CONFIG);
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(8000);
+
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+    DW1000Jang::setDeviceAddress(ANCHOR_ADDRESS);
+
+    DW1000Jang::setAntennaDelay(16436);
+
+    /* anchors without a higher address only answer */
+    for(byte i = 0; i < SURVEY_COUNT; i++) {
+        samples[i] = SURVEY_ANCHORS[i] > ANCHOR_ADDRESS ? 0 : SAMPLES_PER_PAIR;
+    }
+    randomSeed(ANCHOR_ADDRESS);
+    nextBurst = millis() + random(BURST_PAUSE_MIN_MS, BURST_PAUSE_MAX_MS);
+
+    Serial.println(F("Committed configuration ..."));
+}
+
+/* next anchor still short of samples, round robin, SURVEY_COUNT if the survey is complete */
+byte findPeer() {
+    for(byte i = 0; i < SURVEY_COUNT; i++) {
+        byte peer = (nextPeer + i) % SURVEY_COUNT;
+        if(samples[peer] < SAMPLES_PER_PAIR) {
+            return peer;
+        }
+    }
+    return SURVEY_COUNT;
+}
+
+void loop() {
+    if(!surveyDone && (int32_t)(millis() - nextBurst) >= 0) {
+        byte peer = findPeer();
+        if(peer == SURVEY_COUNT) {
+            surveyDone = true;
+            Serial.println(F("survey done"));
+        } else {
+            RangeBurstResult burst = DW1000JangRTLS::tagRangeBurst(SURVEY_ANCHORS[peer], BURST_EXCHANGES);
+            if(burst.success) {
+                samples[peer] += burst.count;
+                Serial.print(ANCHOR_ADDRESS); Serial.print("|");
+                Serial.print(SURVEY_ANCHORS[peer]); Serial.print("|");
+                Serial.print(burst.median, 4); Serial.print("|");
+                Serial.print(burst.variance, 6); Serial.print("|");
+                Serial.println(burst.count);
+            }
+            nextPeer = (peer + 1) % SURVEY_COUNT;
+            nextBurst = millis() + random(BURST_PAUSE_MIN_MS, BURST_PAUSE_MAX_MS);
+        }
+    }
+
+    /* answer the bursts of the other anchors in between */
+    DW1000JangRTLS::anchorRangeAcceptMultiTag(NextActivity::RANGING_CONFIRM, 0);
+}
@@ -0,0 +1,161 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * 15.Antenna_Delay_Calibration.ino
+ *
+ * Antenna delay calibration with three (or more) devices placed at known distances:
+ * flash this sketch on every device with its own DEVICE_ADDRESS. Each device answers exchanges like
+ * 5.Triangulation_A/B/C_Anchor and, at random moments, ranges every other device in bursts
+ * until SAMPLES_PER_PAIR exchanges were collected per device.
+ * Every burst is printed as "from|to|median|variance|exchanges|EUI|tx delay|rx delay|die temperature",
+ * AntennaDelayCalibration.m solves the delays of all devices by least squares and prints ANTENNA_DELAYS entries.
+ * The entries carry the calibration temperature, add the drift slopes of the devices to compensate it
+ * (see DW1000JangCalibration::updateTemperatureCompensation).
+ * Paste them here and run again to check the ranges now match the distances.
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangRanging.hpp>
+#include <DW1000JangRTLS.hpp>
+#include <DW1000JangCalibration.hpp>
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_RST = 7;
+const uint8_t PIN_SS = 10; // spi select pin
+#endif
+
+/* change for every device */
+const uint16_t DEVICE_ADDRESS = 1;
+uint16_t CALIBRATION_DEVICES[] = {1, 2, 3};
+const byte DEVICE_COUNT = sizeof(CALIBRATION_DEVICES) / sizeof(CALIBRATION_DEVICES[0]);
+
+/* delays of the calibrated devices, other devices start from DEFAULT_ANTENNA_DELAY */
+const uint16_t DEFAULT_ANTENNA_DELAY = 16436;
+DW1000JangCalibration::AntennaDelayEntry ANTENNA_DELAYS[] = {
+    {0x0000000000000000ULL, 16436, 16436, 0, 0, 0} // replace with the output of AntennaDelayCalibration.m
+};
+const uint8_t ANTENNA_DELAY_COUNT = sizeof(ANTENNA_DELAYS) / sizeof(ANTENNA_DELAYS[0]);
+
+const uint16_t SAMPLES_PER_PAIR = 160;
+const uint8_t BURST_EXCHANGES = MAX_BURST_EXCHANGES;
+/* pause between two bursts of this device, randomized so the devices do not keep colliding */
+const uint32_t BURST_PAUSE_MIN_MS = 100;
+const uint32_t BURST_PAUSE_MAX_MS = 500;
+
+uint16_t samples[DEVICE_COUNT];
+byte nextPeer = 0;
+uint32_t nextBurst = 0;
+boolean calibrationDone = false;
+char eui[24];
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    false
+};
+
+void setup() {
+    // DEBUG monitoring
+    Serial.begin(115200);
+    Serial.println(F("### DW1000Jang-arduino-antenna-delay-calibration ###"));
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println(F("DW1000Jang initialized ..."));
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(FRAME_FILTER_CONFIG);
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(8000);
+
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+    DW1000Jang::setDeviceAddress(DEVICE_ADDRESS);
+
+    if(DW1000JangCalibration::applyAntennaDelay(ANTENNA_DELAYS, ANTENNA_DELAY_COUNT, DEFAULT_ANTENNA_DELAY)) {
+        Serial.println(F("Calibrated antenna delays applied"));
+    }
+    DW1000Jang::getPrintableExtendedUniqueIdentifier(eui);
+
+    /* both directions of every pair are ranged, the solver averages them */
+    for(byte i = 0; i < DEVICE_COUNT; i++) {
+        samples[i] = CALIBRATION_DEVICES[i] != DEVICE_ADDRESS ? 0 : SAMPLES_PER_PAIR;
+    }
+    randomSeed(DEVICE_ADDRESS);
+    nextBurst = millis() + random(BURST_PAUSE_MIN_MS, BURST_PAUSE_MAX_MS);
+
+    Serial.println(F("Committed configuration ..."));
+}
+
+/* next device still short of samples, round robin, DEVICE_COUNT if the calibration is complete */
+byte findPeer() {
+    for(byte i = 0; i < DEVICE_COUNT; i++) {
+        byte peer = (nextPeer + i) % DEVICE_COUNT;
+        if(samples[peer] < SAMPLES_PER_PAIR) {
+            return peer;
+        }
+    }
+    return DEVICE_COUNT;
+}
+
+void loop() {
+    if(!calibrationDone && (int32_t)(millis() - nextBurst) >= 0) {
+        byte peer = findPeer();
+        if(peer == DEVICE_COUNT) {
+            calibrationDone = true;
+            Serial.println(F("calibration done"));
+        } else {
+            RangeBurstResult burst = DW1000JangRTLS::tagRangeBurst(CALIBRATION_DEVICES[peer], BURST_EXCHANGES);
+            if(burst.success) {
+                samples[peer] += burst.count;
+                Serial.print(DEVICE_ADDRESS); Serial.print("|");
+                Serial.print(CALIBRATION_DEVICES[peer]); Serial.print("|");
+                Serial.print(burst.median, 4); Serial.print("|");
+                Serial.print(burst.variance, 6); Serial.print("|");
+                Serial.print(burst.count); Serial.print("|");
+                Serial.print(eui); Serial.print("|");
+                Serial.print(DW1000Jang::getTxAntennaDelay()); Serial.print("|");
+                Serial.print(DW1000Jang::getRxAntennaDelay()); Serial.print("|");
+                Serial.println(DW1000Jang::getTemperature(), 1);
+            }
+            nextPeer = (peer + 1) % DEVICE_COUNT;
+            nextBurst = millis() + random(BURST_PAUSE_MIN_MS, BURST_PAUSE_MAX_MS);
+        }
+    }
+
+    /* answer the bursts of the other devices in between */
+    DW1000JangRTLS::anchorRangeAcceptMultiTag(NextActivity::RANGING_CONFIRM, 0);
+}
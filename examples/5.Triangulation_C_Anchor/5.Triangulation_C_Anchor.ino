@@ -16,6 +16,7 @@
 #include <DW1000JangUtils.hpp>
 #include <DW1000JangRanging.hpp>
 #include <DW1000JangRTLS.hpp>
+#include <DW1000JangCalibration.hpp>
 
 
 // connection pins
@@ -50,9 +51,15 @@ frame_filtering_configuration_t ANCHOR_FRAME_FILTER_CONFIG = {
     false,
     false,
     false,
-    false /* This allows blink frames */
+    true /* This allows blink frames */
 };
 
+/* calibrated delays and temperature drift per device, from AntennaDelayCalibration.m (see 15.Antenna_Delay_Calibration) */
+DW1000JangCalibration::AntennaDelayEntry ANTENNA_DELAYS[] = {
+    {0x0000000000000000ULL, 16436, 16436, 25.0, 0, 0}
+};
+const uint8_t ANTENNA_DELAY_COUNT = sizeof(ANTENNA_DELAYS) / sizeof(ANTENNA_DELAYS[0]);
+
 void setup() {
     // DEBUG monitoring
     Serial.begin(115200);
@@ -76,7 +83,12 @@ void setup() {
     DW1000Jang::setNetworkId(RTLS_APP_ID);
     DW1000Jang::setDeviceAddress(3);
 	
-    DW1000Jang::setAntennaDelay(16436);
+    DW1000JangCalibration::applyAntennaDelay(ANTENNA_DELAYS, ANTENNA_DELAY_COUNT, 16436);
+    /* follow the die temperature every 10 s, rewrite the delays once they drift by 2 ticks */
+    DW1000JangCalibration::setTemperatureCompensation(10000, 2);
+
+    /* answer discovery blinks in the slot of our address */
+    DW1000JangRTLS::setDiscoverySlot(3, 2000);
     
     Serial.println(F("Committed configuration ..."));
     // DEBUG chip info and registers pretty printed
@@ -93,6 +105,10 @@ void setup() {
 
 void loop() {
 
-    RangeAcceptResult result = DW1000JangRTLS::Anchor_Distance_Response();
+    /* between exchanges, the radio is idle */
+    DW1000JangCalibration::updateTemperatureCompensation(millis());
+
+    /* exchanges of several tags can interleave, each one is tracked in its own session */
+    TagRangeAcceptResult result = DW1000JangRTLS::anchorRangeAcceptMultiTag(NextActivity::RANGING_CONFIRM, 0);
     
 }
\ No newline at end of file
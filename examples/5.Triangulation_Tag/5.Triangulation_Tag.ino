@@ -127,35 +127,32 @@ void calculatePosition(double &x, double &y) {
 
 void loop() {
 
-  int rand;
   double x,y;
-  
-  New_structure result_A_Anchor = DW1000JangRTLS::Tag_Distance_Request(1, 1500);
+
+  /* Wait for the coordinator beacon, the first poll goes out at the start of our slot */
+  SuperframeSlot slot = DW1000JangRTLS::tagWaitForSuperframe();
+  if(!slot.success)
+  {
+    return;
+  }
+
+  New_structure result_A_Anchor = DW1000JangRTLS::Tag_Distance_Request(1, 1500, slot.slot_start);
   if(result_A_Anchor.success)
   {
 
     range_A = result_A_Anchor.distance;
-    randomSeed(analogRead(0));
-    rand = random(1,10);
-    delay(10+10*rand);
 
     New_structure result_B_Anchor = DW1000JangRTLS::Tag_Distance_Request(2, 1500);
     if(result_B_Anchor.success)
     {
 
       range_B = result_B_Anchor.distance;
-      randomSeed(analogRead(0));
-      rand = random(1,10);
-      delay(10+10*rand);
 
       New_structure result_C_Anchor = DW1000JangRTLS::Tag_Distance_Request(3, 1500);
       if(result_C_Anchor.success)
       {
 
         range_C = result_C_Anchor.distance;
-        randomSeed(analogRead(0));
-        rand = random(1,10);
-        delay(10+10*rand);
 
         calculatePosition(x,y);
 
@@ -110,6 +110,11 @@ void setup() {
  
 uint16_t FP_INDEX;
 
+// CIR 버퍼 (실수부, 허수부 순서로 저장)
+const uint16_t CIR_BEFORE_FP = 5;
+const uint16_t CIR_SAMPLES = 100;
+int16_t cir[2 * CIR_SAMPLES];
+
 uint16_t FP_AMPL1;
 uint16_t FP_AMPL2;
 uint16_t FP_AMPL3;
@@ -148,10 +153,22 @@ void loop() {
 
   Serial.println("----------------");
 
-  DW1000Jang::getReceivedCIR(); // Serial Plotter로 그래프 출력할 때 주석 해제하기! 
-                              // Serial Plotter로 그래프 출력 시 
-                              // FP_INDEX = DW1000Jang::getFP_index();부터 
-                              // Serial.println("----------------");까지 주석 처리하기!
+  // 첫 번째 경로(FP_INDEX) 주변의 CIR을 버퍼로 읽어온 뒤 출력
+  uint16_t firstIndex;
+  uint16_t count = DW1000Jang::getReceivedCIR(cir, CIR_BEFORE_FP, CIR_SAMPLES, &firstIndex);
+  for(uint16_t i = 0; i < count; i++) { // Serial Plotter로 그래프 출력할 때 주석 해제하기! 
+                                        // Serial Plotter로 그래프 출력 시 
+                                        // FP_INDEX = DW1000Jang::getFP_index();부터 
+                                        // Serial.println("----------------");까지 주석 처리하기!
+    double re = cir[2*i];
+    double im = cir[2*i + 1];
+    Serial.print(re);
+    Serial.print(",");
+    Serial.print(im);
+    Serial.print(",");
+    Serial.println(sqrt(re*re + im*im));
+  }
+  Serial.print("\n");
 
 
 }
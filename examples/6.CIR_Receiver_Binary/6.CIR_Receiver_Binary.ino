@@ -0,0 +1,101 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+/*
+ * Copyright (c) 2015 by Thomas Trojer <thomas@trojer.net>
+ * Decawave DW1000 library for arduino.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file 6.CIR_Receiver_Binary.ino
+ * Receives frames from 6.CIR_Sender and sends the impulse response around
+ * the first path compressed over a 1 Mbaud serial port.
+ * Decode and plot on the host with CIRCollector.m
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangCIR.hpp>
+
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15; // spi select pin
+#else
+const uint8_t PIN_SS = 10; // spi select pin
+#endif
+
+// 첫 번째 경로 앞 샘플 수와 전송할 CIR 길이
+const uint16_t CIR_BEFORE_FP = 5;
+const uint16_t CIR_SAMPLES = 100;
+// 블록마다 유지할 비트 수 (16 = 무손실)
+const uint8_t MANTISSA_BITS = 12;
+
+byte sequence = 0;
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_3,
+    DataRate::RATE_6800KBPS,
+    PulseFrequency::FREQ_64MHZ,
+    PreambleLength::LEN_128,
+    PreambleCode::CODE_10
+};
+
+void setup() {
+  // 바이너리 프레임만 전송하므로 시작 메시지는 출력하지 않음
+  Serial.begin(1000000);
+  DW1000Jang::initializeNoInterrupt(PIN_SS);
+  DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+
+  DW1000Jang::setDeviceAddress(6);
+  DW1000Jang::setNetworkId(10);
+
+  DW1000Jang::setAntennaDelay(16436);
+}
+
+void loop() {
+  DW1000Jang::startReceive();
+  while(!DW1000Jang::isReceiveDone()) {
+    #if defined(ESP8266)
+    yield();
+    #endif
+  }
+  DW1000Jang::clearReceiveStatus();
+
+  // 누적기를 블록 단위로 읽어 압축 후 바로 전송 (전송 중에 다음 블록을 읽음)
+  DW1000JangCIR::streamCompressedCIR(Serial, CIR_BEFORE_FP, CIR_SAMPLES, sequence++, MANTISSA_BITS);
+}
@@ -0,0 +1,94 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 
+ * TDoA_Anchor.ino
+ * 
+ * Anchor of the downlink TDoA mode: answers each master beacon in its own slot.
+ * Flash one anchor per slot with ANCHOR_ADDRESS and ANCHOR_SLOT changed (slot 1 for address 2, slot 2 for address 3, ...)
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangRTLS.hpp>
+
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_RST = 7;
+const uint8_t PIN_SS = 10; // spi select pin
+#endif
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    false
+};
+
+void setupDW1000(uint16_t address, uint16_t frameWaitTimeout) {
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println(F("DW1000Jang initialized ..."));
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(FRAME_FILTER_CONFIG);
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(frameWaitTimeout);
+
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+    DW1000Jang::setDeviceAddress(address);
+
+    DW1000Jang::setAntennaDelay(16436);
+    Serial.println(F("Committed configuration ..."));
+}
+
+const uint16_t ANCHOR_ADDRESS = 2;
+const byte ANCHOR_SLOT = 1;
+const uint16_t SLOT_DURATION = 5000;
+
+void setup() {
+    // DEBUG monitoring
+    Serial.begin(115200);
+    Serial.println(F("### DW1000Jang-arduino-tdoa-anchor ###"));
+    setupDW1000(ANCHOR_ADDRESS, 0);
+}
+
+void loop() {
+    TdoaAnchorResult result = DW1000JangRTLS::anchorTdoaRound(ANCHOR_SLOT, SLOT_DURATION);
+    if(result.success) {
+        Serial.print("round "); Serial.print(result.round);
+        Serial.print(" clock offset ppm "); Serial.println(result.rate_offset * 1e6);
+    }
+}
@@ -0,0 +1,93 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 
+ * TDoA_Master_Anchor.ino
+ * 
+ * Master anchor of the downlink TDoA mode: opens a round every ROUND_PERIOD_MS, the other anchors answer in their slot
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangRTLS.hpp>
+
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_RST = 7;
+const uint8_t PIN_SS = 10; // spi select pin
+#endif
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    false
+};
+
+void setupDW1000(uint16_t address, uint16_t frameWaitTimeout) {
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println(F("DW1000Jang initialized ..."));
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(FRAME_FILTER_CONFIG);
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(frameWaitTimeout);
+
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+    DW1000Jang::setDeviceAddress(address);
+
+    DW1000Jang::setAntennaDelay(16436);
+    Serial.println(F("Committed configuration ..."));
+}
+
+/* Must be longer than the slots of all the anchors */
+const uint16_t ROUND_PERIOD_MS = 100;
+const uint16_t BEACON_TX_DELAY = 1000;
+
+byte round_number = 0;
+
+void setup() {
+    // DEBUG monitoring
+    Serial.begin(115200);
+    Serial.println(F("### DW1000Jang-arduino-tdoa-master-anchor ###"));
+    setupDW1000(1, 0);
+}
+
+void loop() {
+    DW1000JangRTLS::transmitTdoaMasterBeacon(round_number++, BEACON_TX_DELAY);
+    DW1000JangRTLS::waitForTransmission();
+    delay(ROUND_PERIOD_MS);
+}
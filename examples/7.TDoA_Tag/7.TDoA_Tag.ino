@@ -0,0 +1,109 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 
+ * TDoA_Tag.ino
+ * 
+ * Tag of the downlink TDoA mode: only listens to the anchor beacons and solves its position, any number of tags can run
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangRTLS.hpp>
+#include <DW1000JangTDoA.hpp>
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_RST = 7;
+const uint8_t PIN_SS = 10; // spi select pin
+#endif
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    false
+};
+
+void setupDW1000(uint16_t address, uint16_t frameWaitTimeout) {
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println(F("DW1000Jang initialized ..."));
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(FRAME_FILTER_CONFIG);
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(frameWaitTimeout);
+
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+    DW1000Jang::setDeviceAddress(address);
+
+    DW1000Jang::setAntennaDelay(16436);
+    Serial.println(F("Committed configuration ..."));
+}
+
+/* anchors[0] is the master, the others are listed with their short address */
+const DW1000JangTDoA::TdoaAnchor anchors[] = {
+    {1, 0.0, 0.0},
+    {2, 1.2, 0.0},
+    {3, 1.2, 1.2},
+    {4, 0.0, 1.2}
+};
+const uint8_t ANCHOR_COUNT = sizeof(anchors) / sizeof(anchors[0]);
+
+double x = 0.6;
+double y = 0.6;
+
+void setup() {
+    // DEBUG monitoring
+    Serial.begin(115200);
+    Serial.println(F("### DW1000Jang-arduino-tdoa-tag ###"));
+    /* keeps listening from one slot to the next */
+    setupDW1000(100, 8000);
+}
+
+void loop() {
+    TdoaRoundResult round = DW1000JangRTLS::tagTdoaRound(anchors, ANCHOR_COUNT);
+    if(!round.success) {
+        return;
+    }
+
+    DW1000JangTDoA::TdoaPosition position = DW1000JangTDoA::solvePosition(anchors, round.range_difference, ANCHOR_COUNT, x, y);
+    if(position.success) {
+        x = position.x;
+        y = position.y;
+        Serial.print("x : "); Serial.print(x);
+        Serial.print(" y : "); Serial.println(y);
+    }
+}
@@ -0,0 +1,106 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 
+ * UplinkTDoA_Anchor.ino
+ * 
+ * Anchor of the uplink TDoA mode: follows the reference anchor clock and reports the tag blinks in it.
+ * Flash every anchor with its own ANCHOR_ADDRESS and REFERENCE_DISTANCE
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangRTLS.hpp>
+#include <DW1000JangTDoA.hpp>
+
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_RST = 7;
+const uint8_t PIN_SS = 10; // spi select pin
+#endif
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    true /* This allows blink frames */
+};
+
+void setupDW1000(uint16_t address, uint16_t frameWaitTimeout) {
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println(F("DW1000Jang initialized ..."));
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(FRAME_FILTER_CONFIG);
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(frameWaitTimeout);
+
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+    DW1000Jang::setDeviceAddress(address);
+
+    DW1000Jang::setAntennaDelay(16436);
+    Serial.println(F("Committed configuration ..."));
+}
+
+/* Anchor lines on the serial port: tag EUI|blink sequence|reference time high 32 bits|reference time low 32 bits */
+const uint16_t ANCHOR_ADDRESS = 2;
+/* distance to the reference anchor in meters */
+const double REFERENCE_DISTANCE = 1.2;
+
+DW1000JangTDoA::ClockSync sync;
+
+void printBlink(UplinkBlinkResult& blink) {
+    for(int8_t i = 7; i >= 0; i--) {
+        if(blink.tag_eui[i] < 0x10) Serial.print('0');
+        Serial.print(blink.tag_eui[i], HEX);
+    }
+    Serial.print('|'); Serial.print(blink.sequence);
+    Serial.print('|'); Serial.print(static_cast<uint32_t>(blink.reference_time >> 32));
+    Serial.print('|'); Serial.println(static_cast<uint32_t>(blink.reference_time & 0xFFFFFFFF));
+}
+
+void setup() {
+    Serial.begin(1000000);
+    setupDW1000(ANCHOR_ADDRESS, 0);
+    DW1000JangTDoA::clockSyncReset(sync);
+}
+
+void loop() {
+    UplinkBlinkResult blink = DW1000JangRTLS::anchorUplinkTdoa(&sync, REFERENCE_DISTANCE);
+    if(blink.success) {
+        printBlink(blink);
+    }
+}
@@ -0,0 +1,97 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 
+ * 9.Burst_Ranging_Tag.ino
+ * 
+ * Ranges one anchor with bursts of back to back exchanges and prints the averaged results.
+ * Any anchor running anchorRangeAcceptMultiTag (e.g. 5.Triangulation_B_Anchor) answers the burst.
+ */
+
+#include <DW1000Jang.hpp>
+#include <DW1000JangUtils.hpp>
+#include <DW1000JangTime.hpp>
+#include <DW1000JangConstants.hpp>
+#include <DW1000JangRanging.hpp>
+#include <DW1000JangRTLS.hpp>
+
+// connection pins
+#if defined(ESP8266)
+const uint8_t PIN_SS = 15;
+#else
+const uint8_t PIN_SS = 10; // spi select pin
+const uint8_t PIN_RST = 7;
+#endif
+
+const uint16_t TARGET_ANCHOR = 2;
+const uint8_t BURST_EXCHANGES = 10;
+
+device_configuration_t DEFAULT_CONFIG = {
+    false,
+    true,
+    true,
+    true,
+    false,
+    SFDMode::STANDARD_SFD,
+    Channel::CHANNEL_5,
+    DataRate::RATE_850KBPS,
+    PulseFrequency::FREQ_16MHZ,
+    PreambleLength::LEN_256,
+    PreambleCode::CODE_3
+};
+
+frame_filtering_configuration_t TAG_FRAME_FILTER_CONFIG = {
+    false,
+    false,
+    true,
+    false,
+    false,
+    false,
+    false,
+    false
+};
+
+void setup() {
+    // DEBUG monitoring
+    Serial.begin(115200);
+    Serial.println(F("### DW1000Jang-arduino-burst-ranging-tag ###"));
+    // initialize the driver
+    #if defined(ESP8266)
+    DW1000Jang::initializeNoInterrupt(PIN_SS);
+    #else
+    DW1000Jang::initializeNoInterrupt(PIN_SS, PIN_RST);
+    #endif
+    Serial.println("DW1000Jang initialized ...");
+    // general configuration
+    DW1000Jang::applyConfiguration(DEFAULT_CONFIG);
+    DW1000Jang::enableFrameFiltering(TAG_FRAME_FILTER_CONFIG);
+
+    DW1000Jang::setDeviceAddress(14);
+    DW1000Jang::setNetworkId(RTLS_APP_ID);
+
+    DW1000Jang::setAntennaDelay(16436);
+
+    DW1000Jang::setPreambleDetectionTimeout(64);
+    DW1000Jang::setSfdDetectionTimeout(273);
+    DW1000Jang::setReceiveFrameWaitTimeoutPeriod(5000);
+
+    Serial.println(F("Committed configuration ..."));
+}
+
+void loop() {
+    RangeBurstResult burst = DW1000JangRTLS::tagRangeBurst(TARGET_ANCHOR, BURST_EXCHANGES);
+    if(burst.success) {
+        Serial.print("exchanges: "); Serial.print(burst.count);
+        Serial.print(" mean: "); Serial.print(burst.mean, 3);
+        Serial.print(" median: "); Serial.print(burst.median, 3);
+        Serial.print(" std: "); Serial.print(sqrt(burst.variance), 3);
+        Serial.print(" phase: "); Serial.print(burst.phase, 3);
+        Serial.print(" coherence: "); Serial.println(burst.phase_coherence, 2);
+    }
+    delay(100);
+}
@@ -4,6 +4,7 @@
 #include <DW1000JangConstants.hpp>
 #include <DW1000JangRanging.hpp>
 #include <DW1000JangRTLS.hpp>
+#include <DW1000JangFrames.hpp>
 
 // connection pins
 const uint8_t PIN_RST = 7; // reset pin
@@ -90,22 +91,23 @@ byte target_anchor[4][2] = {{0x05, 0x00},
 
 uint16_t ANCHOR_INDEX = 0;
 const uint16_t CYCLE_DELAY = 1000;
-const uint16_t RECEIVE_MODE_DELAY = 1550;
+const uint16_t POLL_RESP_DELAY = 1700; // must match the responders
 const uint16_t RESP_FINAL_DELAY = 1500;
 const uint16_t FINAL_POST_DELAY = 1700;
 
 void loop() {
+    DW1000JangRTLS::expectResponse(DW1000JangFrames::Poll::length(), POLL_RESP_DELAY, DW1000JangFrames::DelayedResponseToPoll::length());
     DW1000JangRTLS::transmitPoll_v2(target_anchor[ANCHOR_INDEX]);
-    if(!DW1000JangRTLS::waitForNextRangingStep_v2(RECEIVE_MODE_DELAY)) {
+    if(!DW1000JangRTLS::waitForResponse()) {
         return;
     } 
     else 
     {
-        size_t cont_len = DW1000Jang::getReceivedDataLength();
-        byte cont_recv[cont_len];
-        DW1000Jang::getReceivedData(cont_recv, cont_len);
+        DW1000JangFrames::ReceivedFrame frame;
+        frame.read();
+        DW1000JangFrames::View<DW1000JangFrames::ResponseToPoll> cont_recv = frame.as<DW1000JangFrames::ResponseToPoll>();
  
-        if (cont_len > 10 && cont_recv[9] == ACTIVITY_CONTROL && cont_recv[10] == RANGING_CONTINUE) 
+        if (cont_recv.isValid()) 
         {
             /* Received Response to poll */
             uint64_t timePollTransmitted = DW1000Jang::getTransmitTimestamp();
@@ -113,7 +115,7 @@ void loop() {
             double phaseResponse = DW1000Jang::getReceivedPhase(); //Response Message를 받고 위상을 얻는 작업
 
             DW1000JangRTLS::transmitFinalMessage_v3(
-                &cont_recv[7], 
+                cont_recv.at<DW1000JangFrames::ResponseToPoll::Source>(), 
                 RESP_FINAL_DELAY, 
                 timePollTransmitted, // Poll transmit time
                 timeResponseReceived,  // Response to poll receive time
@@ -122,7 +124,7 @@ void loop() {
             DW1000JangRTLS::waitForTransmission();
 
             DW1000JangRTLS::transmitPostFinalMessage(
-                &cont_recv[7],
+                cont_recv.at<DW1000JangFrames::ResponseToPoll::Source>(),
                 FINAL_POST_DELAY
             ); //PostFinal Message를 보내는 부분, PostFinal Message를 보내는 시점을 Final Message 송신 시점을 기준으로 함.
             DW1000JangRTLS::waitForTransmission();
@@ -4,6 +4,7 @@
 #include <DW1000JangConstants.hpp>
 #include <DW1000JangRanging.hpp>
 #include <DW1000JangRTLS.hpp>
+#include <DW1000JangFrames.hpp>
 
 // connection pins
 const uint8_t PIN_RST = 7; // reset pin
@@ -80,6 +81,7 @@ void setup() {
 
 const uint16_t RECEIVE_MODE_DELAY = 1550;
 const uint16_t POLL_RESP_DELAY = 1700;
+const uint16_t RESP_FINAL_DELAY = 1500; // mm_Range_Initiator의 RESP_FINAL_DELAY와 같아야 함
 
 const double LIGHT_VELOCITY = 3 * 10e8;
 const double FREQ_CH3 = 2 * (4492.8 * 10e6);
@@ -93,36 +95,34 @@ void loop() {
     }
     else 
     {
-        size_t poll_len = DW1000Jang::getReceivedDataLength();
-        byte poll_data[poll_len];
-        DW1000Jang::getReceivedData(poll_data, poll_len);
+        DW1000JangFrames::ReceivedFrame poll;
+        poll.read();
 
-        if(poll_len > 9 && poll_data[9] == RANGING_TAG_POLL) 
+        if(poll.is<DW1000JangFrames::Poll>()) 
         {
             uint64_t timePollReceived = DW1000Jang::getReceiveTimestamp();
             double phasePoll = DW1000Jang::getReceivedPhase(); //Poll Message를 받고 위상을 얻는 작업
 
-            DW1000JangRTLS::transmitResponseToPoll_v3(&poll_data[7], POLL_RESP_DELAY); //기본 코드와 동일한 함수 사용, Response Message를 보내는 시점을 Poll Message 수신 시점을 기준으로 함.
-            DW1000JangRTLS::waitForTransmission();
-            uint64_t timeResponseToPoll = DW1000Jang::getTransmitTimestamp();
-
-            if(!DW1000JangRTLS::receiveFrame_v2(RECEIVE_MODE_DELAY)) {
+            DW1000JangRTLS::expectResponse(DW1000JangFrames::DelayedResponseToPoll::length(), RESP_FINAL_DELAY, DW1000JangFrames::PhaseFinalMessage::length(), REPLY_PROCESSING_US);
+            DW1000JangRTLS::transmitResponseToPoll_v3(poll.as<DW1000JangFrames::Poll>().at<DW1000JangFrames::Poll::Source>(), POLL_RESP_DELAY); //기본 코드와 동일한 함수 사용, Response Message를 보내는 시점을 Poll Message 수신 시점을 기준으로 함.
+            if(!DW1000JangRTLS::waitForResponse()) {
                 return;
             }
             else 
             {
-                size_t rfinal_len = DW1000Jang::getReceivedDataLength();
-                byte rfinal_data[rfinal_len];
-                DW1000Jang::getReceivedData(rfinal_data, rfinal_len);
+                DW1000JangFrames::ReceivedFrame frame;
+                frame.read();
+                DW1000JangFrames::View<DW1000JangFrames::PhaseFinalMessage> rfinal_data = frame.as<DW1000JangFrames::PhaseFinalMessage>();
 
-                if(rfinal_len > 22 && rfinal_data[9] == RANGING_TAG_FINAL_RESPONSE_EMBEDDED) {
+                if(rfinal_data.isValid()) {
+                    uint64_t timeResponseToPoll = DW1000Jang::getTransmitTimestamp();
                     uint64_t timeFinalMessageReceive = DW1000Jang::getReceiveTimestamp();
                     double phaseFinal = DW1000Jang::getReceivedPhase(); //Final Message를 받고 위상을 얻는 작업
                     // Final Message를 받은 후 packet에 존재하는 정보를 먼저 변수에 저장
-                    double phaseResponse = static_cast<double>(DW1000JangUtils::bytesAsValue(&rfinal_data[22], 4) / 1000.0);
-                    uint64_t timePollSent = DW1000JangUtils::bytesAsValue(&rfinal_data[10], 4);
-                    uint64_t timeResponseToPollReceived = DW1000JangUtils::bytesAsValue(&rfinal_data[14], 4);
-                    uint64_t timeFinalMessageSent = DW1000JangUtils::bytesAsValue(&rfinal_data[18], 4);
+                    double phaseResponse = static_cast<double>(rfinal_data.get<DW1000JangFrames::PhaseFinalMessage::PhaseResponse>() / 1000.0);
+                    uint64_t timePollSent = rfinal_data.get<DW1000JangFrames::PhaseFinalMessage::PollSent>();
+                    uint64_t timeResponseToPollReceived = rfinal_data.get<DW1000JangFrames::PhaseFinalMessage::ResponseReceived>();
+                    uint64_t timeFinalMessageSent = rfinal_data.get<DW1000JangFrames::PhaseFinalMessage::FinalSent>();
 
                     // PostFinal Message를 받는 부분 추가
                     if (!DW1000JangRTLS::receiveFrame_v3(RECEIVE_MODE_DELAY)) {
@@ -130,11 +130,9 @@ void loop() {
                     }
                     else
                     {
-                      size_t rpostfinal_len = DW1000Jang::getReceivedDataLength();
-                      byte rpostfinal_data[rpostfinal_len];
-                      DW1000Jang::getReceivedData(rpostfinal_data, rpostfinal_len);
+                      frame.read();
 
-                      if (rpostfinal_len > 9 && rpostfinal_data[9] == RANGING_TAG_POST_FINAL_RESPONSE_EMBEDDED) {
+                      if (frame.is<DW1000JangFrames::PostFinal>()) {
                         double phasePostFinal = DW1000Jang::getReceivedPhase(); //PostFinal Message를 받고 위상을 얻는 작업
 
                         dist_twr = DW1000JangRanging::computeRangeAsymmetric(
@@ -55,8 +55,6 @@
 #include "DW1000JangRegisters.hpp"
 #include "SPIporting.hpp"
 
-byte CIR[10];
-
 
 namespace DW1000Jang {
 	
@@ -87,6 +85,106 @@ namespace DW1000Jang {
 		byte       _chanctrl[LEN_CHAN_CTRL];
 		byte       _networkAndAddress[LEN_PANADR];
 
+		/* Register shadows, the bytes last written to the registers set by applyConfiguration and the other setters.
+		The control registers come first, the tuning registers follow in the layout of configuration_image_t, then the rest.
+		They are also the snapshot written back by spiWakeup */
+		enum _Shadow : uint8_t {
+			_SHADOW_SYS_CFG,
+			_SHADOW_CHAN_CTRL,
+			_SHADOW_TX_FCTRL,
+			_SHADOW_AGC_TUNE1,
+			_SHADOW_AGC_TUNE2,
+			_SHADOW_AGC_TUNE3,
+			_SHADOW_DRX_TUNE0b,
+			_SHADOW_DRX_TUNE1a,
+			_SHADOW_DRX_TUNE1b,
+			_SHADOW_DRX_TUNE2,
+			_SHADOW_DRX_TUNE4H,
+			_SHADOW_LDE_CFG1,
+			_SHADOW_LDE_CFG2,
+			_SHADOW_LDE_REPC,
+			_SHADOW_TX_POWER,
+			_SHADOW_RF_RXCTRLH,
+			_SHADOW_RF_TXCTRL,
+			_SHADOW_TC_PGDELAY,
+			_SHADOW_FS_PLLCFG,
+			_SHADOW_FS_PLLTUNE,
+			_SHADOW_SFD_LENGTH,
+			_SHADOW_PANADR,
+			_SHADOW_SYS_MASK,
+			_SHADOW_TX_ANTD,
+			_SHADOW_LDE_RXANTD,
+			_SHADOW_RX_WFTO,
+			_SHADOW_DRX_SFDTOC,
+			_SHADOW_DRX_PRETOC,
+			_SHADOW_RX_SNIFF,
+			_SHADOW_W4R_TIM,
+			_SHADOW_COUNT
+		};
+		constexpr uint8_t _SHADOW_FIRST_TUNING = _SHADOW_AGC_TUNE1;
+		constexpr uint8_t _SHADOW_FIRST_RUNTIME = _SHADOW_PANADR;
+
+		typedef struct _ShadowRegister {
+			byte cmd;
+			uint16_t offset;
+			uint8_t length;
+		} _ShadowRegister;
+
+		const _ShadowRegister _SHADOW_REGISTERS[_SHADOW_COUNT] = {
+			{SYS_CFG, NO_SUB, LEN_SYS_CFG},
+			{CHAN_CTRL, NO_SUB, LEN_CHAN_CTRL},
+			{TX_FCTRL, NO_SUB, LEN_TX_FCTRL},
+			{AGC_TUNE, AGC_TUNE1_SUB, LEN_AGC_TUNE1},
+			{AGC_TUNE, AGC_TUNE2_SUB, LEN_AGC_TUNE2},
+			{AGC_TUNE, AGC_TUNE3_SUB, LEN_AGC_TUNE3},
+			{DRX_TUNE, DRX_TUNE0b_SUB, LEN_DRX_TUNE0b},
+			{DRX_TUNE, DRX_TUNE1a_SUB, LEN_DRX_TUNE1a},
+			{DRX_TUNE, DRX_TUNE1b_SUB, LEN_DRX_TUNE1b},
+			{DRX_TUNE, DRX_TUNE2_SUB, LEN_DRX_TUNE2},
+			{DRX_TUNE, DRX_TUNE4H_SUB, LEN_DRX_TUNE4H},
+			{LDE_IF, LDE_CFG1_SUB, LEN_LDE_CFG1},
+			{LDE_IF, LDE_CFG2_SUB, LEN_LDE_CFG2},
+			{LDE_IF, LDE_REPC_SUB, LEN_LDE_REPC},
+			{TX_POWER, NO_SUB, LEN_TX_POWER},
+			{RF_CONF, RF_RXCTRLH_SUB, LEN_RF_RXCTRLH},
+			{RF_CONF, RF_TXCTRL_SUB, LEN_RF_TXCTRL},
+			{TX_CAL, TC_PGDELAY_SUB, LEN_TC_PGDELAY},
+			{FS_CTRL, FS_PLLCFG_SUB, LEN_FS_PLLCFG},
+			{FS_CTRL, FS_PLLTUNE_SUB, LEN_FS_PLLTUNE},
+			{USR_SFD, SFD_LENGTH_SUB, LEN_SFD_LENGTH},
+			{PANADR, NO_SUB, LEN_PANADR},
+			{SYS_MASK, NO_SUB, LEN_SYS_MASK},
+			{TX_ANTD, NO_SUB, LEN_TX_ANTD},
+			{LDE_IF, LDE_RXANTD_SUB, LEN_LDE_RXANTD},
+			{RX_WFTO, NO_SUB, LEN_RX_WFTO},
+			{DRX_TUNE, DRX_SFDTOC_SUB, LEN_DRX_SFDTOC},
+			{DRX_TUNE, DRX_PRETOC_SUB, LEN_DRX_PRETOC},
+			{RX_SNIFF, NO_SUB, LEN_RX_SNIFF},
+			{ACK_RESP_T, ACK_RESP_T_W4R_TIME_SUB, LEN_ACK_RESP_T_W4R_TIME_SUB}
+		};
+
+		constexpr uint8_t _LEN_SHADOW_CONTROL = LEN_SYS_CFG + LEN_CHAN_CTRL + LEN_TX_FCTRL;
+		constexpr uint8_t _LEN_SHADOW_RUNTIME = LEN_PANADR + LEN_SYS_MASK + LEN_TX_ANTD + LEN_LDE_RXANTD + LEN_RX_WFTO + LEN_DRX_SFDTOC + LEN_DRX_PRETOC + LEN_RX_SNIFF + LEN_ACK_RESP_T_W4R_TIME_SUB;
+		static_assert(_SHADOW_COUNT <= 32, "shadows must fit _shadowValid");
+		static_assert(LEN_AGC_TUNE1 + LEN_AGC_TUNE2 + LEN_AGC_TUNE3 + LEN_DRX_TUNE0b + LEN_DRX_TUNE1a + LEN_DRX_TUNE1b + LEN_DRX_TUNE2
+			+ LEN_DRX_TUNE4H + LEN_LDE_CFG1 + LEN_LDE_CFG2 + LEN_LDE_REPC + LEN_TX_POWER + LEN_RF_RXCTRLH + LEN_RF_TXCTRL
+			+ LEN_TC_PGDELAY + LEN_FS_PLLTUNE + LEN_FS_PLLCFG + LEN_SFD_LENGTH == LEN_CONFIGURATION_IMAGE, "configuration image layout");
+
+		byte       _shadow[_LEN_SHADOW_CONTROL + LEN_CONFIGURATION_IMAGE + _LEN_SHADOW_RUNTIME];
+		/* one bit per _Shadow, cleared by a reset */
+		uint32_t   _shadowValid = 0;
+
+		/* Wake up: CS low time that wakes the chip, bound of the wait for INIT and the PLL lock */
+		constexpr uint16_t _WAKEUP_CS_LOW_US = 500;
+		constexpr uint32_t _WAKEUP_TIMEOUT_US = 5000;
+		uint32_t   _wakeupDuration = 0;
+		/* the last spiWakeup timed out, the configuration is still to be restored */
+		boolean    _wakeupPending = false;
+
+		/* Sniff mode: the receiver is on for _SNIFF_ON_PACS PACs and off for the rest of the cycle while looking for a preamble */
+		constexpr uint8_t _SNIFF_ON_PACS = 2;
+		boolean    _sniffMode = false;
+
 		/* Temperature and Voltage monitoring */
 		byte _vmeas3v3 = 0;
 		byte _tmeas23C = 0;
@@ -109,6 +207,8 @@ namespace DW1000Jang {
 		boolean 		_wait4resp = false;
 		uint16_t		_antennaTxDelay = 0;
 		uint16_t		_antennaRxDelay = 0;
+		uint16_t		_rxFrameWaitTimeout = 0;
+		uint32_t		_txBufferRevision = 0;
 
 		/* ############################# PRIVATE METHODS ################################### */
 		
@@ -180,6 +280,53 @@ namespace DW1000Jang {
 		void _writeSingleByteToRegister(byte cmd, uint16_t offset, byte data) {
 			_writeBytesToRegister(cmd, offset, &data, 1); // 1 as data_size because writes a single byte
 		}
+
+		/* Offset of a shadowed register in _shadow */
+		uint8_t _shadowPosition(uint8_t index) {
+			uint8_t position = 0;
+			for(uint8_t i = 0; i < index; i++) {
+				position += _SHADOW_REGISTERS[i].length;
+			}
+			return position;
+		}
+
+		/* Writes a shadowed register, nothing is sent if it already holds data */
+		void _writeShadowed(uint8_t index, byte data[]) {
+			const _ShadowRegister& reg = _SHADOW_REGISTERS[index];
+			byte* shadow = &_shadow[_shadowPosition(index)];
+			uint32_t bit = static_cast<uint32_t>(1) << index;
+			if((_shadowValid & bit) && memcmp(shadow, data, reg.length) == 0) {
+				return;
+			}
+			_writeBytesToRegister(reg.cmd, reg.offset, data, reg.length);
+			memcpy(shadow, data, reg.length);
+			_shadowValid |= bit;
+		}
+
+		/* Writes every valid shadow back, registers next to each other in the table and on the chip go in one burst */
+		void _restoreShadows() {
+			uint8_t position = 0;
+			uint8_t i = 0;
+			while(i < _SHADOW_COUNT) {
+				uint8_t length = _SHADOW_REGISTERS[i].length;
+				if(!(_shadowValid & (static_cast<uint32_t>(1) << i))) {
+					position += length;
+					i++;
+					continue;
+				}
+				const _ShadowRegister& first = _SHADOW_REGISTERS[i];
+				uint8_t burst = length;
+				i++;
+				while(i < _SHADOW_COUNT && (_shadowValid & (static_cast<uint32_t>(1) << i))
+					&& _SHADOW_REGISTERS[i].cmd == first.cmd && first.offset != NO_SUB
+					&& _SHADOW_REGISTERS[i].offset == first.offset + burst) {
+					burst += _SHADOW_REGISTERS[i].length;
+					i++;
+				}
+				_writeBytesToRegister(first.cmd, first.offset, &_shadow[position], burst);
+				position += burst;
+			}
+		}
 		
 		/*
 		* Read bytes from the DW1000. Number of bytes depend on register length.
@@ -214,6 +361,27 @@ namespace DW1000Jang {
 			SPIporting::readFromSPI(_ss, headerLen, header, data_size, data);
 		}
 
+		/* Polls (slow SPI) until the chip answers in INIT and its PLL locked, false on timeout */
+		boolean _waitForWakeup(uint32_t start) {
+			byte deviceId[LEN_DEV_ID];
+			uint32_t expectedDeviceId = 0xDECA0130;
+			do {
+				_readBytesFromRegister(DEV_ID, NO_SUB, deviceId, LEN_DEV_ID);
+				if(DW1000JangUtils::bytesAsValue(deviceId, LEN_DEV_ID) == expectedDeviceId) {
+					break;
+				}
+			} while(micros() - start < _WAKEUP_TIMEOUT_US);
+
+			byte status[LEN_SYS_STATUS];
+			do {
+				_readBytesFromRegister(SYS_STATUS, NO_SUB, status, LEN_SYS_STATUS);
+				if(DW1000JangUtils::getBit(status, LEN_SYS_STATUS, CPLOCK_BIT)) {
+					return true;
+				}
+			} while(micros() - start < _WAKEUP_TIMEOUT_US);
+			return false;
+		}
+
 		void _readBytesFromRegister_2(byte cmd, uint16_t offset, uint16_t data[], uint16_t data_size) {
 			byte header[3];
 			uint8_t headerLen = 1;
@@ -314,6 +482,86 @@ namespace DW1000Jang {
 			_writeBytesToRegister(PMSC, PMSC_CTRL0_SUB, pmscctrl0, 2);
 		}
 		
+		/* ACC_MEM is readable only with the accumulator clocks forced on, see _restoreAccumulatorClocks */
+		void _enableAccumulatorClocks(byte saved[]) {
+			byte pmscctrl0[LEN_PMSC_CTRL0];
+			_readBytesFromRegister(PMSC, PMSC_CTRL0_SUB, saved, LEN_PMSC_CTRL0);
+			memcpy(pmscctrl0, saved, LEN_PMSC_CTRL0);
+			/* RXCLKS forced to the 125MHz PLL clock */
+			pmscctrl0[0] = (pmscctrl0[0] & 0xF3) | 0x08;
+			DW1000JangUtils::setBit(pmscctrl0, LEN_PMSC_CTRL0, FACE_BIT, 1);
+			DW1000JangUtils::setBit(pmscctrl0, LEN_PMSC_CTRL0, AMCE_BIT, 1);
+			_writeBytesToRegister(PMSC, PMSC_CTRL0_SUB, pmscctrl0, LEN_PMSC_CTRL0);
+		}
+
+		void _restoreAccumulatorClocks(byte saved[]) {
+			_writeBytesToRegister(PMSC, PMSC_CTRL0_SUB, saved, LEN_PMSC_CTRL0);
+		}
+
+		uint16_t _preambleSymbols() {
+			switch(_preambleLength) {
+				case PreambleLength::LEN_64:
+					return 64;
+				case PreambleLength::LEN_128:
+					return 128;
+				case PreambleLength::LEN_256:
+					return 256;
+				case PreambleLength::LEN_512:
+					return 512;
+				case PreambleLength::LEN_1024:
+					return 1024;
+				case PreambleLength::LEN_1536:
+					return 1536;
+				case PreambleLength::LEN_2048:
+					return 2048;
+				default:
+					return 4096;
+			}
+		}
+
+		/* PLL2_SEQ_EN lets the sniff mode switch the receiver PLL off, it is not retained in deep sleep */
+		void _setSniffSequencing(boolean val) {
+			byte pmscctrl0[LEN_PMSC_CTRL0];
+			_readBytesFromRegister(PMSC, PMSC_CTRL0_SUB, pmscctrl0, LEN_PMSC_CTRL0);
+			DW1000JangUtils::setBit(pmscctrl0, LEN_PMSC_CTRL0, PLL2_SEQ_EN_BIT, val);
+			_writeBytesToRegister(PMSC, PMSC_CTRL0_SUB, pmscctrl0, LEN_PMSC_CTRL0);
+		}
+
+		/*
+		* Writes the sniff times for the current preamble length and PAC size. A whole on/off cycle
+		* fits in a quarter of the preamble, so a preamble is seen during an on time with at least
+		* three quarters of it left for the acquisition. Nothing is written if the preamble is too short.
+		*/
+		boolean _writeSniffTimes() {
+			/* symbol duration in ns */
+			uint32_t symbol = _pulseFrequency == PulseFrequency::FREQ_16MHZ ? 994 : 1018;
+			uint32_t onTime = static_cast<uint32_t>(_SNIFF_ON_PACS) * static_cast<uint16_t>(_pacSize) * symbol;
+			uint32_t cycle = static_cast<uint32_t>(_preambleSymbols() / 4) * symbol;
+			if(cycle <= onTime) {
+				return false;
+			}
+			/* SNIFF_OFFT counts 128 cycles of the 124.8MHz clock */
+			uint32_t offTime = (cycle - onTime) / 1026;
+			if(offTime == 0) {
+				return false;
+			}
+			byte rx_sniff[LEN_RX_SNIFF];
+			memset(rx_sniff, 0, LEN_RX_SNIFF);
+			rx_sniff[0] = _SNIFF_ON_PACS - 1;
+			rx_sniff[1] = offTime > 0xFF ? 0xFF : static_cast<byte>(offTime);
+			_writeShadowed(_SHADOW_RX_SNIFF, rx_sniff);
+			return true;
+		}
+
+		/* Reads count (at most ACCUMULATOR_CHUNK_SAMPLES) samples, the clocks must be on. Every read starts with a dummy byte */
+		void _readAccumulatorChunk(int16_t samples[], uint16_t first, uint16_t count) {
+			byte raw[1 + 4*ACCUMULATOR_CHUNK_SAMPLES];
+			_readBytesFromRegister(ACC_MEM, first * 4, raw, 1 + 4*count);
+			for(uint16_t i = 0; i < 2*count; i++) {
+				samples[i] = (int16_t)((uint16_t)raw[1 + 2*i] | ((uint16_t)raw[2 + 2*i] << 8));
+			}
+		}
+
 		/* Steps used to get Temp and Voltage */
 		void _vbatAndTempSteps() {
 			byte step1 = 0x80; _writeBytesToRegister(RF_CONF, 0x11, &step1, 1);
@@ -333,21 +581,21 @@ namespace DW1000Jang {
 			} else {
 				// TODO proper error/warning handling
 			}
-			_writeBytesToRegister(AGC_TUNE, AGC_TUNE1_SUB, agctune1, LEN_AGC_TUNE1);
+			_writeShadowed(_SHADOW_AGC_TUNE1, agctune1);
 		}
 
 		/* AGC_TUNE2 - reg:0x23, sub-reg:0x0C, table 25 */
 		void _agctune2() {
 			byte agctune2[LEN_AGC_TUNE2];
 			DW1000JangUtils::writeValueToBytes(agctune2, 0x2502A907L, LEN_AGC_TUNE2);
-			_writeBytesToRegister(AGC_TUNE, AGC_TUNE2_SUB, agctune2, LEN_AGC_TUNE2);
+			_writeShadowed(_SHADOW_AGC_TUNE2, agctune2);
 		}
 
 		/* AGC_TUNE3 - reg:0x23, sub-reg:0x12, table 26 */
 		void _agctune3() {
 			byte agctune3[LEN_AGC_TUNE3];
 			DW1000JangUtils::writeValueToBytes(agctune3, 0x0035, LEN_AGC_TUNE3);
-			_writeBytesToRegister(AGC_TUNE, AGC_TUNE3_SUB, agctune3, LEN_AGC_TUNE3);
+			_writeShadowed(_SHADOW_AGC_TUNE3, agctune3);
 		}
 
 		/* DRX_TUNE0b - reg:0x27, sub-reg:0x02, table 30 */
@@ -374,7 +622,7 @@ namespace DW1000Jang {
 			} else {
 				// TODO proper error/warning handling
 			}
-			_writeBytesToRegister(DRX_TUNE, DRX_TUNE0b_SUB, drxtune0b, LEN_DRX_TUNE0b);
+			_writeShadowed(_SHADOW_DRX_TUNE0b, drxtune0b);
 		}
 
 		/* DRX_TUNE1a - reg:0x27, sub-reg:0x04, table 31 */
@@ -387,7 +635,7 @@ namespace DW1000Jang {
 			} else {
 				// TODO proper error/warning handling
 			}
-			_writeBytesToRegister(DRX_TUNE, DRX_TUNE1a_SUB, drxtune1a, LEN_DRX_TUNE1a);
+			_writeShadowed(_SHADOW_DRX_TUNE1a, drxtune1a);
 		}
 
 		/* DRX_TUNE1b - reg:0x27, sub-reg:0x06, table 32 */
@@ -413,7 +661,7 @@ namespace DW1000Jang {
 					// TODO proper error/warning handling
 				}
 			}
-			_writeBytesToRegister(DRX_TUNE, DRX_TUNE1b_SUB, drxtune1b, LEN_DRX_TUNE1b);
+			_writeShadowed(_SHADOW_DRX_TUNE1b, drxtune1b);
 		}
 
 		/* DRX_TUNE2 - reg:0x27, sub-reg:0x08, table 33 */
@@ -454,7 +702,7 @@ namespace DW1000Jang {
 			} else {
 				// TODO proper error/warning handling
 			}
-			_writeBytesToRegister(DRX_TUNE, DRX_TUNE2_SUB, drxtune2, LEN_DRX_TUNE2);
+			_writeShadowed(_SHADOW_DRX_TUNE2, drxtune2);
 		}
 
 		/* DRX_TUNE4H - reg:0x27, sub-reg:0x26, table 34 */
@@ -465,14 +713,14 @@ namespace DW1000Jang {
 			} else {
 				DW1000JangUtils::writeValueToBytes(drxtune4H, 0x0028, LEN_DRX_TUNE4H);
 			}
-			_writeBytesToRegister(DRX_TUNE, DRX_TUNE4H_SUB, drxtune4H, LEN_DRX_TUNE4H);
+			_writeShadowed(_SHADOW_DRX_TUNE4H, drxtune4H);
 		}
 
 		/* LDE_CFG1 - reg 0x2E, sub-reg:0x0806 */
 		void _ldecfg1() {
 			byte ldecfg1[LEN_LDE_CFG1];
 			_nlos == true ? DW1000JangUtils::writeValueToBytes(ldecfg1, 0x7, LEN_LDE_CFG1) : DW1000JangUtils::writeValueToBytes(ldecfg1, 0xD, LEN_LDE_CFG1);
-			_writeBytesToRegister(LDE_IF, LDE_CFG1_SUB, ldecfg1, LEN_LDE_CFG1);
+			_writeShadowed(_SHADOW_LDE_CFG1, ldecfg1);
 		}
 
 		/* LDE_CFG2 - reg 0x2E, sub-reg:0x1806, table 50 */
@@ -485,7 +733,7 @@ namespace DW1000Jang {
 			} else {
 				// TODO proper error/warning handling
 			}
-			_writeBytesToRegister(LDE_IF, LDE_CFG2_SUB, ldecfg2, LEN_LDE_CFG2);
+			_writeShadowed(_SHADOW_LDE_CFG2, ldecfg2);
 		}
 
 		/* LDE_REPC - reg 0x2E, sub-reg:0x2804, table 51 */
@@ -567,7 +815,7 @@ namespace DW1000Jang {
 				// TODO proper error/warning handling
 			}
 			
-			_writeBytesToRegister(LDE_IF, LDE_REPC_SUB, lderepc, LEN_LDE_REPC);
+			_writeShadowed(_SHADOW_LDE_REPC, lderepc);
 		}
 
 		/* TX_POWER (enabled smart transmit power control) - reg:0x1E, tables 19-20
@@ -737,7 +985,7 @@ namespace DW1000Jang {
 			} else {
 				// TODO proper error/warning handling
 			}
-			_writeBytesToRegister(TX_POWER, NO_SUB, txpower, LEN_TX_POWER);
+			_writeShadowed(_SHADOW_TX_POWER, txpower);
 		}
 
 		/* RF_RXCTRLH - reg:0x28, sub-reg:0x0B, table 37 */
@@ -748,7 +996,7 @@ namespace DW1000Jang {
 			} else {
 				DW1000JangUtils::writeValueToBytes(rfrxctrlh, 0xBC, LEN_RF_RXCTRLH);
 			}
-			_writeBytesToRegister(RF_CONF, RF_RXCTRLH_SUB, rfrxctrlh, LEN_RF_RXCTRLH);
+			_writeShadowed(_SHADOW_RF_RXCTRLH, rfrxctrlh);
 		}
 
 		/* RX_TXCTRL - reg:0x28, sub-reg:0x0C */
@@ -769,7 +1017,7 @@ namespace DW1000Jang {
 			} else {
 				// TODO proper error/warning handling
 			}
-			_writeBytesToRegister(RF_CONF, RF_TXCTRL_SUB, rftxctrl, LEN_RF_TXCTRL);
+			_writeShadowed(_SHADOW_RF_TXCTRL, rftxctrl);
 		}
 
 		/* TC_PGDELAY - reg:0x2A, sub-reg:0x0B, table 40 */
@@ -790,7 +1038,7 @@ namespace DW1000Jang {
 			} else {
 				// TODO proper error/warning handling
 			}
-			_writeBytesToRegister(TX_CAL, TC_PGDELAY_SUB, tcpgdelay, LEN_TC_PGDELAY);
+			_writeShadowed(_SHADOW_TC_PGDELAY, tcpgdelay);
 		}
 
 		// FS_PLLCFG and FS_PLLTUNE - reg:0x2B, sub-reg:0x07-0x0B, tables 43-44
@@ -812,8 +1060,8 @@ namespace DW1000Jang {
 			} else {
 				// TODO proper error/warning handling
 			}
-			_writeBytesToRegister(FS_CTRL, FS_PLLTUNE_SUB, fsplltune, LEN_FS_PLLTUNE);
-			_writeBytesToRegister(FS_CTRL, FS_PLLCFG_SUB, fspllcfg, LEN_FS_PLLCFG);
+			_writeShadowed(_SHADOW_FS_PLLTUNE, fsplltune);
+			_writeShadowed(_SHADOW_FS_PLLCFG, fspllcfg);
 		}
 
 		void _tune() {
@@ -837,23 +1085,30 @@ namespace DW1000Jang {
 		}
 
 		void _writeNetworkIdAndDeviceAddress() {
-			_writeBytesToRegister(PANADR, NO_SUB, _networkAndAddress, LEN_PANADR);
+			_writeShadowed(_SHADOW_PANADR, _networkAndAddress);
 		}
 
 		void _writeSystemConfigurationRegister() {
-			_writeBytesToRegister(SYS_CFG, NO_SUB, _syscfg, LEN_SYS_CFG);
+			_writeShadowed(_SHADOW_SYS_CFG, _syscfg);
 		}
 
 		void _writeChannelControlRegister() {
-			_writeBytesToRegister(CHAN_CTRL, NO_SUB, _chanctrl, LEN_CHAN_CTRL);
+			_writeShadowed(_SHADOW_CHAN_CTRL, _chanctrl);
 		}
 
 		void _writeTransmitFrameControlRegister() {
-			_writeBytesToRegister(TX_FCTRL, NO_SUB, _txfctrl, LEN_TX_FCTRL);
+			_writeShadowed(_SHADOW_TX_FCTRL, _txfctrl);
+		}
+
+		/* TXBOFFS, bits 22 to 31 of TX_FCTRL: position in TX_BUFFER of the first byte sent */
+		void _setTransmitBufferOffset(uint16_t offset) {
+			_txfctrl[2] &= 0x3F;
+			_txfctrl[2] |= (byte)((offset << 6) & 0xC0);
+			_txfctrl[3] = (byte)((offset >> 2) & 0xFF);
 		}
 
 		void _writeSystemEventMaskRegister() {
-			_writeBytesToRegister(SYS_MASK, NO_SUB, _sysmask, LEN_SYS_MASK);
+			_writeShadowed(_SHADOW_SYS_MASK, _sysmask);
 		}
 
 		void _writeAntennaDelayRegisters() {
@@ -861,8 +1116,8 @@ namespace DW1000Jang {
 			byte antennaRxDelayBytes[2];
 			DW1000JangUtils::writeValueToBytes(antennaTxDelayBytes, _antennaTxDelay, LEN_TX_ANTD);
 			DW1000JangUtils::writeValueToBytes(antennaRxDelayBytes, _antennaRxDelay, LEN_LDE_RXANTD);
-			_writeBytesToRegister(TX_ANTD, NO_SUB, antennaTxDelayBytes, LEN_TX_ANTD);
-			_writeBytesToRegister(LDE_IF, LDE_RXANTD_SUB, antennaRxDelayBytes, LEN_LDE_RXANTD);
+			_writeShadowed(_SHADOW_TX_ANTD, antennaTxDelayBytes);
+			_writeShadowed(_SHADOW_LDE_RXANTD, antennaRxDelayBytes);
 		}
 
 		void _writeConfiguration() {
@@ -885,20 +1140,15 @@ namespace DW1000Jang {
 			_frameCheck = val;
 		}
 
+		/* LDE_CFG1 and LDE_CFG2 are written by _tune */
 		void _setNlosOptimization(boolean val) {
 			_nlos = val;
-			if(_nlos) {
-				_ldecfg1();
-				_ldecfg2();
-			}
 		}
 
+		/* SYS_CFG and TX_POWER are written by _writeConfiguration and _tune */
 		void _useSmartPower(boolean smartPower) {
 			_smartPower = smartPower;
 			DW1000JangUtils::setBit(_syscfg, LEN_SYS_CFG, DIS_STXP_BIT, !smartPower);
-			_writeSystemConfigurationRegister();
-			if(_autoTXPower)
-				_txpowertune();
 		}
 
 		void _setSFDMode(SFDMode mode) {
@@ -1044,19 +1294,21 @@ namespace DW1000Jang {
 		}
 
 		void _setNonStandardSFDLength() {
+			byte sfdLength;
 			switch(_dataRate) {
 				case DataRate::RATE_6800KBPS:
-					_writeSingleByteToRegister(USR_SFD, SFD_LENGTH_SUB, 0x08);
+					sfdLength = 0x08;
 					break;
 				case DataRate::RATE_850KBPS:
-					_writeSingleByteToRegister(USR_SFD, SFD_LENGTH_SUB, 0x10);
+					sfdLength = 0x10;
 					break;
 				case DataRate::RATE_110KBPS:
-					_writeSingleByteToRegister(USR_SFD, SFD_LENGTH_SUB, 0x40);
+					sfdLength = 0x40;
 					break;
 				default:
 					return; //TODO Proper error handling
 			}
+			_writeShadowed(_SHADOW_SFD_LENGTH, &sfdLength);
 		}
 
 		void _interruptOnSent(boolean val) {
@@ -1405,6 +1657,18 @@ namespace DW1000Jang {
 		_clearTransmitStatus();
 	}
 
+	boolean isDelayedStartLate() {
+		_readSystemEventStatusRegister();
+		if(!DW1000JangUtils::getBit(_sysstatus, LEN_SYS_STATUS, HPDWARN_BIT)) {
+			return false;
+		}
+		byte clear[LEN_SYS_STATUS];
+		memset(clear, 0, LEN_SYS_STATUS);
+		DW1000JangUtils::setBit(clear, LEN_SYS_STATUS, HPDWARN_BIT, true);
+		_writeBytesToRegister(SYS_STATUS, NO_SUB, clear, LEN_SYS_STATUS);
+		return true;
+	}
+
 	boolean isReceiveDone() {
 		_readSystemEventStatusRegister();
 		return _isReceiveDone();
@@ -1493,26 +1757,54 @@ namespace DW1000Jang {
 		_writeValueToRegister(AON, AON_CTRL_SUB, 0x00, LEN_AON_CTRL);
 		/* Write 1 in SAVE_BIT */
 		_writeValueToRegister(AON, AON_CTRL_SUB, 0x02, LEN_AON_CTRL);
+		/* TX buffer is not retained in sleep, the shadows are kept for spiWakeup */
+		_txBufferRevision++;
 	}
 
-	void spiWakeup(){
+	boolean spiWakeup(){
 		byte deviceId[LEN_DEV_ID];
 		byte expectedDeviceId[LEN_DEV_ID];
 		DW1000JangUtils::writeValueToBytes(expectedDeviceId, 0xDECA0130, LEN_DEV_ID);
 		_readBytesFromRegister(DEV_ID, NO_SUB, deviceId, LEN_DEV_ID);
-		if (memcmp(deviceId, expectedDeviceId, LEN_DEV_ID)) {
-			digitalWrite(_ss, LOW);
-			delay(1);
-			digitalWrite(_ss, HIGH);
-			delay(5);
-			setTxAntennaDelay(_antennaTxDelay);
+		boolean asleep = memcmp(deviceId, expectedDeviceId, LEN_DEV_ID) != 0;
+		if (asleep || _wakeupPending) {
+			uint32_t start = micros();
+			if (asleep) {
+				digitalWrite(_ss, LOW);
+				delayMicroseconds(_WAKEUP_CS_LOW_US);
+				digitalWrite(_ss, HIGH);
+			}
+			/* the chip runs on the crystal until the PLL locks, SPI is limited to 3MHz meanwhile */
+			SPIporting::setSPIspeed(SPIClock::SLOW);
+			boolean awake = _waitForWakeup(start);
+			SPIporting::setSPIspeed(SPIClock::FAST);
+			/* writing the shadows to a chip that did not come up would be lost, the next call retries */
+			_wakeupPending = !awake;
+			if (!awake) {
+				return false;
+			}
+			/* the LDE microcode is reloaded by the AON (ONW_LLDE), the configuration is written back from the shadows */
+			_restoreShadows();
+			if (_sniffMode) {
+				_setSniffSequencing(true);
+			}
 			if (_debounceClockEnabled){
 					enableDebounceClock();
 			}
+			_wakeupDuration = micros() - start;
 		}
+		return true;
+	}
+
+	uint32_t getWakeupDuration() {
+		return _wakeupDuration;
 	}
 
 	void reset() {
+		_txBufferRevision++;
+		_shadowValid = 0;
+		_wakeupPending = false;
+		_sniffMode = false;
 		if(_rst == 0xff) { /* Fallback to Software Reset */
 			softwareReset();
 		} else {
@@ -1526,6 +1818,9 @@ namespace DW1000Jang {
 	}
 
 	void softwareReset() {
+		_txBufferRevision++;
+		_shadowValid = 0;
+		_sniffMode = false;
 		SPIporting::setSPIspeed(SPIClock::SLOW);
 		
 		/* Disable sequencing and go to state "INIT" - (a) Sets SYSCLKS to 01 */
@@ -1821,6 +2116,7 @@ namespace DW1000Jang {
 	}
 
 	void applyConfiguration(device_configuration_t config) {
+		/* the registers are only written if they differ from their shadows, switching profiles costs what changed */
 		forceTRxOff();
 
 		_useExtendedFrameLength(config.extendedFrameLength);
@@ -1845,6 +2141,55 @@ namespace DW1000Jang {
 		_writeConfiguration();
 		// tune according to configuration
 		_tune();
+
+		if(_sniffMode && !_writeSniffTimes())
+			disableSniffMode();
+	}
+
+	void saveConfigurationImage(configuration_image_t& image) {
+		image.config.extendedFrameLength = DW1000JangUtils::getBit(_syscfg, LEN_SYS_CFG, PHR_MODE_0_BIT);
+		image.config.receiverAutoReenable = DW1000JangUtils::getBit(_syscfg, LEN_SYS_CFG, RXAUTR_BIT);
+		image.config.smartPower = _smartPower;
+		image.config.frameCheck = _frameCheck;
+		image.config.nlos = _nlos;
+		image.config.sfd = _standardSFD ? SFDMode::STANDARD_SFD : SFDMode::DECAWAVE_SFD;
+		image.config.channel = _channel;
+		image.config.dataRate = _dataRate;
+		image.config.pulseFreq = _pulseFrequency;
+		image.config.preambleLen = _preambleLength;
+		/* the code actually in use, after the validity check */
+		image.config.preaCode = _preambleCode;
+		memcpy(image.registers, &_shadow[_LEN_SHADOW_CONTROL], LEN_CONFIGURATION_IMAGE);
+		image.valid = (_shadowValid >> _SHADOW_FIRST_TUNING) & ((static_cast<uint32_t>(1) << (_SHADOW_FIRST_RUNTIME - _SHADOW_FIRST_TUNING)) - 1);
+	}
+
+	void applyConfigurationImage(const configuration_image_t& image) {
+		forceTRxOff();
+
+		_useExtendedFrameLength(image.config.extendedFrameLength);
+		_setReceiverAutoReenable(image.config.receiverAutoReenable);
+		_useSmartPower(image.config.smartPower);
+		_useFrameCheck(image.config.frameCheck);
+		_setNlosOptimization(image.config.nlos);
+		_setSFDMode(image.config.sfd);
+		_setChannel(image.config.channel);
+		_setDataRate(image.config.dataRate);
+		_setPulseFrequency(image.config.pulseFreq);
+		_setPreambleLength(image.config.preambleLen);
+		_setPreambleCode(image.config.preaCode);
+		_writeConfiguration();
+
+		/* the tuning tables are not evaluated again */
+		byte registers[LEN_CONFIGURATION_IMAGE];
+		memcpy(registers, image.registers, LEN_CONFIGURATION_IMAGE);
+		for(uint8_t i = _SHADOW_FIRST_TUNING; i < _SHADOW_FIRST_RUNTIME; i++) {
+			if(image.valid & (static_cast<uint32_t>(1) << (i - _SHADOW_FIRST_TUNING))) {
+				_writeShadowed(i, &registers[_shadowPosition(i) - _LEN_SHADOW_CONTROL]);
+			}
+		}
+
+		if(_sniffMode && !_writeSniffTimes())
+			disableSniffMode();
 	}
 
 	Channel getChannel() {
@@ -1855,23 +2200,62 @@ namespace DW1000Jang {
 		return _pulseFrequency;
 	}
 
+	DataRate getDataRate() {
+		return _dataRate;
+	}
+
+	PreambleLength getPreambleLength() {
+		return _preambleLength;
+	}
+
+	boolean isFrameCheckEnabled() {
+		return _frameCheck;
+	}
+
 	void setPreambleDetectionTimeout(uint16_t pacSize) {
 		byte drx_pretoc[LEN_DRX_PRETOC];
 		DW1000JangUtils::writeValueToBytes(drx_pretoc, pacSize, LEN_DRX_PRETOC);
-		_writeBytesToRegister(DRX_TUNE, DRX_PRETOC_SUB, drx_pretoc, LEN_DRX_PRETOC);
+		_writeShadowed(_SHADOW_DRX_PRETOC, drx_pretoc);
 	}
 
 	void setSfdDetectionTimeout(uint16_t preambleSymbols) {
 		byte drx_sfdtoc[LEN_DRX_SFDTOC];
 		DW1000JangUtils::writeValueToBytes(drx_sfdtoc, preambleSymbols, LEN_DRX_SFDTOC);
-		_writeBytesToRegister(DRX_TUNE, DRX_SFDTOC_SUB, drx_sfdtoc, LEN_DRX_SFDTOC);
+		_writeShadowed(_SHADOW_DRX_SFDTOC, drx_sfdtoc);
+	}
+
+	boolean enableSniffMode() {
+		if(!_writeSniffTimes()) {
+			disableSniffMode();
+			return false;
+		}
+		if(!_sniffMode) {
+			_setSniffSequencing(true);
+			_sniffMode = true;
+		}
+		return true;
+	}
+
+	void disableSniffMode() {
+		if(!_sniffMode)
+			return;
+		byte rx_sniff[LEN_RX_SNIFF];
+		memset(rx_sniff, 0, LEN_RX_SNIFF);
+		_writeShadowed(_SHADOW_RX_SNIFF, rx_sniff);
+		_setSniffSequencing(false);
+		_sniffMode = false;
+	}
+
+	boolean isSniffModeEnabled() {
+		return _sniffMode;
 	}
 
 	void setReceiveFrameWaitTimeoutPeriod(uint16_t timeMicroSeconds) {
+		_rxFrameWaitTimeout = timeMicroSeconds;
 		if (timeMicroSeconds > 0) {
 			byte rx_wfto[LEN_RX_WFTO];
 			DW1000JangUtils::writeValueToBytes(rx_wfto, timeMicroSeconds, LEN_RX_WFTO);
-			_writeBytesToRegister(RX_WFTO, NO_SUB, rx_wfto, LEN_RX_WFTO);
+			_writeShadowed(_SHADOW_RX_WFTO, rx_wfto);
 			/* enable frame wait timeout bit */
 			DW1000JangUtils::setBit(_syscfg, LEN_SYS_CFG, RXWTOE_BIT, true);
 			_writeSystemConfigurationRegister();
@@ -1882,6 +2266,10 @@ namespace DW1000Jang {
 		}
 	}
 
+	uint16_t getReceiveFrameWaitTimeoutPeriod() {
+		return _rxFrameWaitTimeout;
+	}
+
 	void applyInterruptConfiguration(interrupt_configuration_t interrupt_config) {
 		forceTRxOff();
 
@@ -1897,6 +2285,8 @@ namespace DW1000Jang {
 
 	void setWait4Response(uint32_t timeMicroSeconds) {
 		_wait4resp = timeMicroSeconds == 0 ? false : true;
+		if(!_wait4resp)
+			return;
 
 		/* Check if it overflows 20 bits */
 		if(timeMicroSeconds > 1048575)
@@ -1905,12 +2295,12 @@ namespace DW1000Jang {
 		byte W4R_TIME[LEN_ACK_RESP_T_W4R_TIME_SUB];
 		DW1000JangUtils::writeValueToBytes(W4R_TIME, timeMicroSeconds, LEN_ACK_RESP_T_W4R_TIME_SUB);
 		W4R_TIME[2] &= 0x0F; 
-		_writeBytesToRegister(ACK_RESP_T, ACK_RESP_T_W4R_TIME_SUB, W4R_TIME, LEN_ACK_RESP_T_W4R_TIME_SUB);
+		_writeShadowed(_SHADOW_W4R_TIM, W4R_TIME);
 	}
 
 	void setTXPower(byte power[]) {
 		//TODO Check byte length
-		_writeBytesToRegister(TX_POWER, NO_SUB, power, LEN_TX_POWER);
+		_writeShadowed(_SHADOW_TX_POWER, power);
 		_autoTXPower = false;
 	}
 
@@ -1942,7 +2332,7 @@ namespace DW1000Jang {
 	void setTCPGDelay(byte tcpgdelay) {
 		byte tcpgBytes[LEN_TC_PGDELAY];
 		DW1000JangUtils::writeValueToBytes(tcpgBytes, tcpgdelay, LEN_TC_PGDELAY);
-		_writeBytesToRegister(TX_CAL, TC_PGDELAY_SUB, tcpgBytes, LEN_TC_PGDELAY);
+		_writeShadowed(_SHADOW_TC_PGDELAY, tcpgBytes);
 		_autoTCPGDelay = false;
 	}
 
@@ -1992,14 +2382,49 @@ namespace DW1000Jang {
 		}
 		// transmit data and length
 		_writeBytesToRegister(TX_BUFFER, NO_SUB, data, n);
+		_txBufferRevision++;
 		
 		/* Sets up transmit frame control length based on data length */
 		_txfctrl[0] = (byte)(n & 0xFF); // 1 byte (regular length + 1 bit)
 		_txfctrl[1] &= 0xE0;
 		_txfctrl[1] |= (byte)((n >> 8) & 0x03);  // 2 added bits if extended length
+		_setTransmitBufferOffset(0);
 		_writeTransmitFrameControlRegister();
 	}
 
+	boolean setTransmitDataAt(uint16_t offset, byte data[], uint16_t n) {
+		if(n == 0 || offset + n > LEN_EXT_UWB_FRAMES) {
+			return false;
+		}
+		/* patch in place through sub-addressing, frame length is left untouched */
+		_writeBytesToRegister(TX_BUFFER, offset, data, n);
+		return true;
+	}
+
+	boolean setTransmitLength(uint16_t n, uint16_t bufferOffset) {
+		if(_frameCheck) {
+			n += 2; // two bytes CRC-16
+		}
+		if(n > LEN_EXT_UWB_FRAMES || (n > LEN_UWB_FRAMES && !_extendedFrameLength)) {
+			return false;
+		}
+		/* the frame (CRC included) has to end inside the buffer */
+		if(bufferOffset + n > LEN_EXT_UWB_FRAMES) {
+			return false;
+		}
+		_txfctrl[0] = (byte)(n & 0xFF);
+		_txfctrl[1] &= 0xE0;
+		_txfctrl[1] |= (byte)((n >> 8) & 0x03);
+		_setTransmitBufferOffset(bufferOffset);
+		/* skipped by the shadow when neither the length nor the offset changed */
+		_writeTransmitFrameControlRegister();
+		return true;
+	}
+
+	uint32_t getTransmitBufferRevision() {
+		return _txBufferRevision;
+	}
+
 	void setTransmitData(const String& data) {
 		uint16_t n = data.length()+1;
 		byte* dataBytes = (byte*)malloc(n);
@@ -2069,77 +2494,165 @@ namespace DW1000Jang {
 		return DW1000JangUtils::bytesAsValue(data, LEN_SYS_TIME);		
 	}
 
-	float getReceiveQuality() {
-		byte         noiseBytes[LEN_STD_NOISE];
-		byte         fpAmpl2Bytes[LEN_FP_AMPL2];
-		uint16_t     noise, f2;
-		_readBytesFromRegister(RX_FQUAL, STD_NOISE_SUB, noiseBytes, LEN_STD_NOISE);
-		_readBytesFromRegister(RX_FQUAL, FP_AMPL2_SUB, fpAmpl2Bytes, LEN_FP_AMPL2);
-		noise = (uint16_t)noiseBytes[0] | ((uint16_t)noiseBytes[1] << 8);
-		f2    = (uint16_t)fpAmpl2Bytes[0] | ((uint16_t)fpAmpl2Bytes[1] << 8);
-		return (float)f2/noise;
+	namespace {
+		enum : uint8_t {
+			_RECEIVE_POWER_CACHED = 0x01,
+			_FIRST_PATH_POWER_CACHED = 0x02,
+			_FIRST_PATH_SNR_CACHED = 0x04
+		};
+
+		/* received power estimate of the user manual (section 4.7), A and the correction above -88dBm depend on the PRF */
+		float _powerFromRatio(float ratio, boolean prf16) {
+			float power = 10.0*log10(ratio) - (prf16 ? 113.77 : 121.74);
+			if(power > -88) {
+				// approximation of Fig. 22 in user manual for dbm correction
+				power += (power+88)*(prf16 ? 2.3334 : 1.1667);
+			}
+			return power;
+		}
+
+		/* same in 0.1 dBm from log2 of the ratio in 8 bit fixed point, computed in 0.01 dBm */
+		int16_t _powerTenthsFromLog2(int32_t log2Ratio, boolean prf16) {
+			/* 1000 * log10(2) = 301.03 */
+			int32_t power = (log2Ratio * 30103 / 100 + 128) / 256 - (prf16 ? 11377 : 12174);
+			if(power > -8800) {
+				power += (power+8800) * (prf16 ? 23334 : 11667) / 10000;
+			}
+			return static_cast<int16_t>(power >= 0 ? (power + 5) / 10 : (power - 5) / 10);
+		}
 	}
 
-	float getFirstPathPower() {
-		byte         fpAmpl1Bytes[LEN_FP_AMPL1];
-		byte         fpAmpl2Bytes[LEN_FP_AMPL2];
-		byte         fpAmpl3Bytes[LEN_FP_AMPL3];
-		byte         rxFrameInfo[LEN_RX_FINFO];
-		uint16_t     f1, f2, f3, N;
-		float        A, corrFac;
-		_readBytesFromRegister(RX_TIME, FP_AMPL1_SUB, fpAmpl1Bytes, LEN_FP_AMPL1);
-		_readBytesFromRegister(RX_FQUAL, FP_AMPL2_SUB, fpAmpl2Bytes, LEN_FP_AMPL2);
-		_readBytesFromRegister(RX_FQUAL, FP_AMPL3_SUB, fpAmpl3Bytes, LEN_FP_AMPL3);
-		_readBytesFromRegister(RX_FINFO, NO_SUB, rxFrameInfo, LEN_RX_FINFO);
-		f1 = (uint16_t)fpAmpl1Bytes[0] | ((uint16_t)fpAmpl1Bytes[1] << 8);
-		f2 = (uint16_t)fpAmpl2Bytes[0] | ((uint16_t)fpAmpl2Bytes[1] << 8);
-		f3 = (uint16_t)fpAmpl3Bytes[0] | ((uint16_t)fpAmpl3Bytes[1] << 8);
-		N  = (((uint16_t)rxFrameInfo[2] >> 4) & 0xFF) | ((uint16_t)rxFrameInfo[3] << 4);
-
-		if(_pulseFrequency == PulseFrequency::FREQ_16MHZ) {
-			A       = 113.77;
-			corrFac = 2.3334;
-		} else {
-			A       = 121.74;
-			corrFac = 1.1667;
+	ReceiveDiagnostics getReceiveDiagnostics() {
+		ReceiveDiagnostics diagnostics;
+		byte quality[LEN_RX_FQUAL];
+		byte firstPath[LEN_FP_INDEX + LEN_FP_AMPL1];
+		byte frameInfo[LEN_RX_FINFO];
+		byte peakPath[LEN_LDE_PPINDX];
+		_readBytesFromRegister(RX_FQUAL, NO_SUB, quality, LEN_RX_FQUAL);
+		/* FP_INDEX and FP_AMPL1 are next to each other */
+		_readBytesFromRegister(RX_TIME, FP_INDEX_SUB, firstPath, LEN_FP_INDEX + LEN_FP_AMPL1);
+		_readBytesFromRegister(RX_FINFO, NO_SUB, frameInfo, LEN_RX_FINFO);
+		_readBytesFromRegister(LDE_IF, LDE_PPINDX_SUB, peakPath, LEN_LDE_PPINDX);
+
+		diagnostics.noise = (uint16_t)quality[STD_NOISE_SUB] | ((uint16_t)quality[STD_NOISE_SUB + 1] << 8);
+		diagnostics.firstPathAmplitude2 = (uint16_t)quality[FP_AMPL2_SUB] | ((uint16_t)quality[FP_AMPL2_SUB + 1] << 8);
+		diagnostics.firstPathAmplitude3 = (uint16_t)quality[FP_AMPL3_SUB] | ((uint16_t)quality[FP_AMPL3_SUB + 1] << 8);
+		diagnostics.cirPower = (uint16_t)quality[CIR_PWR_SUB] | ((uint16_t)quality[CIR_PWR_SUB + 1] << 8);
+		diagnostics.firstPathIndexFixedPoint = (uint16_t)firstPath[0] | ((uint16_t)firstPath[1] << 8);
+		diagnostics.firstPathAmplitude1 = (uint16_t)firstPath[2] | ((uint16_t)firstPath[3] << 8);
+		diagnostics.preambleAccumulation = (((uint16_t)frameInfo[2] >> 4) & 0xFF) | ((uint16_t)frameInfo[3] << 4);
+		diagnostics.peakPathIndex = (uint16_t)peakPath[0] | ((uint16_t)peakPath[1] << 8);
+		diagnostics.prf16 = _pulseFrequency == PulseFrequency::FREQ_16MHZ;
+		diagnostics._cached = 0;
+		return diagnostics;
+	}
+
+	float ReceiveDiagnostics::receivePower() {
+		if(!(_cached & _RECEIVE_POWER_CACHED)) {
+			float N = preambleAccumulation;
+			_receivePower = _powerFromRatio(((float)cirPower*131072.0)/(N*N), prf16);
+			_cached |= _RECEIVE_POWER_CACHED;
 		}
-		float estFpPwr = 10.0*log10(((float)f1*(float)f1+(float)f2*(float)f2+(float)f3*(float)f3)/((float)N*(float)N))-A;
-		if(estFpPwr <= -88) {
-			return estFpPwr;
-		} else {
-			// approximation of Fig. 22 in user manual for dbm correction
-			estFpPwr += (estFpPwr+88)*corrFac;
+		return _receivePower;
+	}
+
+	float ReceiveDiagnostics::firstPathPower() {
+		if(!(_cached & _FIRST_PATH_POWER_CACHED)) {
+			float f1 = firstPathAmplitude1;
+			float f2 = firstPathAmplitude2;
+			float f3 = firstPathAmplitude3;
+			float N = preambleAccumulation;
+			_firstPathPower = _powerFromRatio((f1*f1+f2*f2+f3*f3)/(N*N), prf16);
+			_cached |= _FIRST_PATH_POWER_CACHED;
+		}
+		return _firstPathPower;
+	}
+
+	float ReceiveDiagnostics::firstPathSnr() {
+		if(!(_cached & _FIRST_PATH_SNR_CACHED)) {
+			_firstPathSnr = (float)firstPathAmplitude2/noise;
+			_cached |= _FIRST_PATH_SNR_CACHED;
 		}
-		return estFpPwr;
+		return _firstPathSnr;
+	}
+
+	int16_t ReceiveDiagnostics::receivePowerTenths() const {
+		int32_t log2Ratio = DW1000JangUtils::log2Fixed(cirPower) + 17*256 - 2*DW1000JangUtils::log2Fixed(preambleAccumulation);
+		return _powerTenthsFromLog2(log2Ratio, prf16);
+	}
+
+	int16_t ReceiveDiagnostics::firstPathPowerTenths() const {
+		/* scaled so the sum of the three squares fits 32 bits */
+		uint32_t f1 = firstPathAmplitude1;
+		uint32_t f2 = firstPathAmplitude2;
+		uint32_t f3 = firstPathAmplitude3;
+		uint8_t shift = 0;
+		while((f1 | f2 | f3) >= 0x8000) {
+			f1 >>= 1;
+			f2 >>= 1;
+			f3 >>= 1;
+			shift++;
+		}
+		uint32_t sum = f1*f1 + f2*f2 + f3*f3;
+		int32_t log2Ratio = DW1000JangUtils::log2Fixed(sum) + 2*256*shift - 2*DW1000JangUtils::log2Fixed(preambleAccumulation);
+		return _powerTenthsFromLog2(log2Ratio, prf16);
+	}
+
+	uint16_t ReceiveDiagnostics::firstPathSnrFixed() const {
+		if(noise == 0) {
+			return 0xFFFF;
+		}
+		uint32_t snr = ((uint32_t)firstPathAmplitude2 << 8) / noise;
+		return snr > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(snr);
+	}
+
+	/* the legacy getters read the diagnostics at once too, the dB math lives in ReceiveDiagnostics only */
+	float getReceiveQuality() {
+		return getReceiveDiagnostics().firstPathSnr();
+	}
+
+	float getFirstPathPower() {
+		return getReceiveDiagnostics().firstPathPower();
 	}
 
 	float getReceivePower() {
-		byte     cirPwrBytes[LEN_CIR_PWR];
-		byte     rxFrameInfo[LEN_RX_FINFO];
-		uint32_t twoPower17 = 131072;
-		uint16_t C, N;
-		float    A, corrFac;
-		_readBytesFromRegister(RX_FQUAL, CIR_PWR_SUB, cirPwrBytes, LEN_CIR_PWR);
-		_readBytesFromRegister(RX_FINFO, NO_SUB, rxFrameInfo, LEN_RX_FINFO);
-		C = (uint16_t)cirPwrBytes[0] | ((uint16_t)cirPwrBytes[1] << 8);
-		N = (((uint16_t)rxFrameInfo[2] >> 4) & 0xFF) | ((uint16_t)rxFrameInfo[3] << 4);
+		return getReceiveDiagnostics().receivePower();
+	}
 
-		if(_pulseFrequency == PulseFrequency::FREQ_16MHZ) {
-			A       = 113.77;
-			corrFac = 2.3334;
-		} else {
-			A       = 121.74;
-			corrFac = 1.1667;
+	int32_t getCarrierIntegrator() {
+		byte carInt[LEN_DRX_CAR_INT];
+		_readBytesFromRegister(DRX_TUNE, DRX_CAR_INT_SUB, carInt, LEN_DRX_CAR_INT);
+		int32_t value = (int32_t)carInt[0] | ((int32_t)carInt[1] << 8) | ((int32_t)(carInt[2] & 0x1F) << 16);
+		if(value & 0x100000) {
+			value -= 0x200000;
 		}
-		
-		float estRxPwr = 10.0*log10(((float)C*(float)twoPower17)/((float)N*(float)N))-A;
-		if(estRxPwr <= -88) {
-			return estRxPwr;
-		} else {
-			// approximation of Fig. 22 in user manual for dbm correction
-			estRxPwr += (estRxPwr+88)*corrFac;
+		return value;
+	}
+
+	double getReceivedClockOffset() {
+		/* integrator unit in Hz: 998.4MHz / 2 / 1024 / 2^17, the 110kbps mode integrates 8 times longer */
+		double hertzPerUnit = 998.4e6 / 2.0 / 1024.0 / 131072.0;
+		if(_dataRate == DataRate::RATE_110KBPS) {
+			hertzPerUnit /= 8.0;
+		}
+		double carrierFrequency;
+		switch(_channel) {
+			case Channel::CHANNEL_1:
+				carrierFrequency = 3494.4e6;
+				break;
+			case Channel::CHANNEL_3:
+				carrierFrequency = 4492.8e6;
+				break;
+			case Channel::CHANNEL_5:
+			case Channel::CHANNEL_7:
+				carrierFrequency = 6489.6e6;
+				break;
+			default:
+				carrierFrequency = 3993.6e6;
+				break;
 		}
-		return estRxPwr;
+		/* a positive integrator means the remote carrier is below the local one */
+		return -static_cast<double>(getCarrierIntegrator()) * hertzPerUnit / carrierFrequency;
 	}
 
 	uint16_t reverseByte(byte num) 
@@ -2154,13 +2667,21 @@ namespace DW1000Jang {
 
 	uint16_t getFP_index()
 	{
-		byte FP_index[2];
-		_readBytesFromRegister(0x15, 0x05, FP_index, 2);
-		uint16_t value = FP_index[1] << 8 | FP_index[0];
+		return getFP_indexFixedPoint() / 64;
+	}
 
-		value /= 64;
+	uint16_t getFP_indexFixedPoint()
+	{
+		byte FP_index[2];
+		_readBytesFromRegister(RX_TIME, FP_INDEX_SUB, FP_index, LEN_FP_INDEX);
+		return FP_index[1] << 8 | FP_index[0];
+	}
 
-		return value;
+	uint16_t getPeakPathIndex()
+	{
+		byte ppIndex[LEN_LDE_PPINDX];
+		_readBytesFromRegister(LDE_IF, LDE_PPINDX_SUB, ppIndex, LEN_LDE_PPINDX);
+		return (uint16_t)ppIndex[0] | ((uint16_t)ppIndex[1] << 8);
 	}
 
 	uint16_t getFP_AMPL1()
@@ -2193,66 +2714,96 @@ namespace DW1000Jang {
     	return value;
 	}
 
-	void getReceivedCIR() {
-
-			byte pmscctrl0[LEN_PMSC_CTRL0];
-			memset(pmscctrl0, 0, LEN_PMSC_CTRL0);
-			_readBytesFromRegister(PMSC, PMSC_CTRL0_SUB, pmscctrl0, LEN_PMSC_CTRL0);
-			DW1000JangUtils::setBit(pmscctrl0, LEN_PMSC_CTRL0, FACE_BIT, 1);
-			DW1000JangUtils::setBit(pmscctrl0, LEN_PMSC_CTRL0, AMCE_BIT, 1);
-			_writeBytesToRegister(PMSC, PMSC_CTRL0_SUB, pmscctrl0, LEN_PMSC_CTRL0);
-
-			uint16_t FP_INDEX = getFP_index();
+	uint16_t getAccumulatorLength() {
+		return _pulseFrequency == PulseFrequency::FREQ_16MHZ ? ACCUMULATOR_SAMPLES_PRF16 : ACCUMULATOR_SAMPLES_PRF64;
+	}
 
-			_readBytesFromRegister(0x25, FP_INDEX * 4, CIR, 512);
-			double CIR_16_Re;
-			double CIR_16_Im;
-			double Amp;
-			int i = 1;
-			while(i < 400) {
-				CIR_16_Re = (CIR[i] | CIR[i + 1] << 8);
-				CIR_16_Im = (CIR[i+2] | CIR[i + 3] << 8);
-				Amp = sqrt(CIR_16_Re * CIR_16_Re + CIR_16_Im * CIR_16_Im);
+	uint16_t getAccumulatorSamples(int16_t samples[], uint16_t first, uint16_t count) {
+		uint16_t length = getAccumulatorLength();
+		if(first >= length) {
+			return 0;
+		}
+		if(count > length - first) {
+			count = length - first;
+		}
 
-				
-				Serial.print (CIR_16_Re);
-				Serial.print(",");
-				Serial.print (CIR_16_Im);
-				Serial.print(",");
-				Serial.println (Amp);
+		byte pmscctrl0[LEN_PMSC_CTRL0];
+		_enableAccumulatorClocks(pmscctrl0);
+		for(uint16_t done = 0; done < count; done += ACCUMULATOR_CHUNK_SAMPLES) {
+			uint16_t chunk = count - done < ACCUMULATOR_CHUNK_SAMPLES ? count - done : ACCUMULATOR_CHUNK_SAMPLES;
+			_readAccumulatorChunk(&samples[2*done], first + done, chunk);
+		}
+		_restoreAccumulatorClocks(pmscctrl0);
+		return count;
+	}
 
-				i = i + 4;
-			}
-			Serial.print("\n");
+	uint16_t getReceivedCIR(int16_t samples[], uint16_t before, uint16_t count, uint16_t* firstIndex) {
+		uint16_t fpIndex = getFP_index();
+		uint16_t first = fpIndex > before ? fpIndex - before : 0;
+		if(firstIndex != nullptr) {
+			*firstIndex = first;
+		}
+		return getAccumulatorSamples(samples, first, count);
 	}
 
-	double getReceivedPhase() {
+	void streamAccumulator(void (* handler)(const int16_t samples[], uint16_t first, uint16_t count)) {
+		int16_t chunk[2*ACCUMULATOR_CHUNK_SAMPLES];
+		uint16_t length = getAccumulatorLength();
 
 		byte pmscctrl0[LEN_PMSC_CTRL0];
-		memset(pmscctrl0, 0, LEN_PMSC_CTRL0);
-		_readBytesFromRegister(PMSC, PMSC_CTRL0_SUB, pmscctrl0, LEN_PMSC_CTRL0);
-		DW1000JangUtils::setBit(pmscctrl0, LEN_PMSC_CTRL0, FACE_BIT, 1); 
-		DW1000JangUtils::setBit(pmscctrl0, LEN_PMSC_CTRL0, AMCE_BIT, 1); 
-		_writeBytesToRegister(PMSC, PMSC_CTRL0_SUB, pmscctrl0, LEN_PMSC_CTRL0);
-
-		uint16_t FP_INDEX = getFP_index();
+		_enableAccumulatorClocks(pmscctrl0);
+		for(uint16_t first = 0; first < length; first += ACCUMULATOR_CHUNK_SAMPLES) {
+			uint16_t count = length - first < ACCUMULATOR_CHUNK_SAMPLES ? length - first : ACCUMULATOR_CHUNK_SAMPLES;
+			_readAccumulatorChunk(chunk, first, count);
+			handler(chunk, first, count);
+		}
+		_restoreAccumulatorClocks(pmscctrl0);
+	}
 
-		_readBytesFromRegister(0x25, FP_INDEX * 4, CIR, 5);
-		int32_t CIR_16_Re;
-		int32_t CIR_16_Im;
-		double Phase;
-		int i = 1;
-		CIR_16_Re = ((int32_t)CIR[i] | (int32_t)CIR[i + 1] << 8);
-		CIR_16_Im = ((int32_t)CIR[i + 2] | (int32_t)CIR[i + 3] << 8);
+	uint16_t streamAccumulator(uint16_t first, uint16_t count, void (* handler)(const int16_t samples[], uint16_t first, uint16_t count, void* context), void* context) {
+		int16_t chunk[2*ACCUMULATOR_CHUNK_SAMPLES];
+		uint16_t length = getAccumulatorLength();
+		if(first >= length) {
+			return 0;
+		}
+		if(count > length - first) {
+			count = length - first;
+		}
 
-		if (CIR_16_Re & 0x00008000) {
-			CIR_16_Re |= 0xffff0000;
+		byte pmscctrl0[LEN_PMSC_CTRL0];
+		_enableAccumulatorClocks(pmscctrl0);
+		for(uint16_t done = 0; done < count; done += ACCUMULATOR_CHUNK_SAMPLES) {
+			uint16_t chunkCount = count - done < ACCUMULATOR_CHUNK_SAMPLES ? count - done : ACCUMULATOR_CHUNK_SAMPLES;
+			_readAccumulatorChunk(chunk, first + done, chunkCount);
+			handler(chunk, first + done, chunkCount, context);
 		}
-		if (CIR_16_Im & 0x00008000) {
-			CIR_16_Im |= 0xffff0000;
+		_restoreAccumulatorClocks(pmscctrl0);
+		return count;
+	}
+
+	void getReceivedCIR() {
+		int16_t samples[2*ACCUMULATOR_CHUNK_SAMPLES];
+		uint16_t first = getFP_index();
+		for(uint16_t done = 0; done < 100; done += ACCUMULATOR_CHUNK_SAMPLES) {
+			uint16_t count = getAccumulatorSamples(samples, first + done, 100 - done < ACCUMULATOR_CHUNK_SAMPLES ? 100 - done : ACCUMULATOR_CHUNK_SAMPLES);
+			for(uint16_t i = 0; i < count; i++) {
+				double re = samples[2*i];
+				double im = samples[2*i + 1];
+				Serial.print(re);
+				Serial.print(",");
+				Serial.print(im);
+				Serial.print(",");
+				Serial.println(sqrt(re*re + im*im));
+			}
 		}
+		Serial.print("\n");
+	}
+
+	double getReceivedPhase() {
+		int16_t sample[2];
+		getReceivedCIR(sample, 0, 1, nullptr);
 
-		Phase = -1 * atan2f((double)CIR_16_Im, (double)CIR_16_Re);
+		double Phase = -1 * atan2f((double)sample[1], (double)sample[0]);
 
 		if (Phase < 0) {
 			Phase += 2 * PI;
@@ -51,6 +51,7 @@
 #include "DW1000JangConstants.hpp"
 #include "DW1000JangConfiguration.hpp"
 #include "DW1000JangCompileOptions.hpp"
+#include "deprecated.hpp"
 
 namespace DW1000Jang {
 	/** 
@@ -103,9 +104,22 @@ namespace DW1000Jang {
 	void deepSleep();
 
 	/**
-	Wake-up from deep sleep by toggle chip select pin
+	Wake-up from deep sleep by toggle chip select pin.
+	Waits for the chip to answer and its PLL to lock instead of a fixed delay, then writes back in a few bursts
+	every register set through the driver (configuration, tuning, addresses, antenna delays, interrupt mask, timeouts),
+	so no initialize or applyConfiguration is needed before ranging again. Does nothing if the chip is awake.
+	If the chip does not answer or its PLL does not lock within 5 ms nothing is written, the next call waits again
+	and restores the configuration then.
+
+	returns true if the chip is awake and configured
+	*/
+	boolean spiWakeup();
+
+	/**
+	Returns the time taken by the last spiWakeup that woke the chip, from the chip select pulse until the configuration
+	is restored (microseconds)
 	*/
-	void spiWakeup();
+	uint32_t getWakeupDuration();
 	
 	/**
 	Resets all connected or the currently selected DW1000 chip.
@@ -243,6 +257,36 @@ namespace DW1000Jang {
 	*/
 	void setTransmitData(const String& data);
 
+	/**
+	Overwrites part of the tx buffer without changing the frame length.
+	Used to patch the variable fields of a frame already loaded with setTransmitData.
+
+	@param [in] offset the position in the tx buffer of the first byte to write
+	@param [in] data the bytes to write
+	@param [in] n the length of the array of bytes
+
+	returns false (nothing written) if the bytes do not fit the tx buffer
+	*/
+	boolean setTransmitDataAt(uint16_t offset, byte data[], uint16_t n);
+
+	/**
+	Sets the length of the frame to transmit and where it starts in the tx buffer (TXBOFFS), so several frames
+	can stay resident at their own offsets. TX_FCTRL is written only if one of them differs from the current value.
+	setTransmitData sends from offset 0 again.
+
+	@param [in] n the length of the frame without CRC
+	@param [in] bufferOffset position in the tx buffer of the first byte of the frame
+
+	returns false (nothing changed) if the frame is longer than the configured frame length allows or leaves the buffer
+	*/
+	boolean setTransmitLength(uint16_t n, uint16_t bufferOffset = 0);
+
+	/**
+	Returns a counter incremented every time the whole tx buffer is rewritten or its content is lost (reset, deep sleep).
+	Content written with setTransmitDataAt is valid only as long as this value does not change.
+	*/
+	uint32_t getTransmitBufferRevision();
+
 	/**
 	Gets the received bytes and stores them in a byte array
 
@@ -289,7 +333,58 @@ namespace DW1000Jang {
 	/* receive quality information. (RX_FSQUAL) - reg:0x12 */
 
 	/**
-	Gets the receive power of the device (last receive)
+	Raw diagnostics of one reception, read at once by getReceiveDiagnostics.
+	The powers are computed on first use and cached, the integer variants avoid floating point and log10 on AVR.
+	*/
+	struct ReceiveDiagnostics {
+		/* CIR_PWR */
+		uint16_t cirPower;
+		/* FP_AMPL1, FP_AMPL2, FP_AMPL3 */
+		uint16_t firstPathAmplitude1;
+		uint16_t firstPathAmplitude2;
+		uint16_t firstPathAmplitude3;
+		/* STD_NOISE */
+		uint16_t noise;
+		/* RXPACC, preamble symbols accumulated */
+		uint16_t preambleAccumulation;
+		/* FP_INDEX, 10.6 fixed point */
+		uint16_t firstPathIndexFixedPoint;
+		/* LDE_PPINDX */
+		uint16_t peakPathIndex;
+		boolean prf16;
+
+		/* same as getReceivePower */
+		float receivePower();
+		/* same as getFirstPathPower */
+		float firstPathPower();
+		/* same as getReceiveQuality */
+		float firstPathSnr();
+		uint16_t firstPathIndex() const { return firstPathIndexFixedPoint / 64; }
+
+		/* receive power in 0.1 dBm, within 0.2 dB of receivePower up to -88 dBm and 0.4 dB above (steeper correction) */
+		int16_t receivePowerTenths() const;
+		/* first path power in 0.1 dBm, same accuracy */
+		int16_t firstPathPowerTenths() const;
+		/* first path SNR in 8 bit fixed point, saturated at 0xFFFF */
+		uint16_t firstPathSnrFixed() const;
+
+		uint8_t _cached;
+		float _receivePower;
+		float _firstPathPower;
+		float _firstPathSnr;
+	};
+
+	/**
+	Reads the diagnostics of the last reception with four SPI transactions,
+	instead of two to four per getReceivePower, getFirstPathPower, getReceiveQuality, getFP_index call
+
+	returns the raw diagnostics, nothing is computed yet
+	*/
+	ReceiveDiagnostics getReceiveDiagnostics();
+
+	/**
+	Gets the receive power of the device (last receive), same as getReceiveDiagnostics().receivePower().
+	Use getReceiveDiagnostics directly when more than one of these values is needed.
 
 	returns the last receive power of the device
 	*/
@@ -309,6 +404,21 @@ namespace DW1000Jang {
 	*/
 	float getReceiveQuality();
 
+	/**
+	Gets the carrier integrator of the last reception (DRX_CAR_INT), the carrier frequency offset of the transmitter
+
+	returns the signed 21 bit integrator value
+	*/
+	int32_t getCarrierIntegrator();
+
+	/**
+	Estimates the clock offset of the transmitter of the last received frame from the carrier integrator.
+	Carrier and timestamps derive from the same crystal, so this is also the rate offset of the remote timestamps.
+
+	returns (remote rate - local rate) / local rate, e.g. 5e-6 if the remote clock runs 5 ppm faster
+	*/
+	double getReceivedClockOffset();
+
 	/**
 	Sets both tx and rx antenna delay value
 
@@ -422,6 +532,15 @@ namespace DW1000Jang {
 
 	void clearTransmitStatus();
 
+	/**
+	Checks the delayed transmission or reception just started against its time (HPDWARN).
+	A time already passed is more than half a period away: the DW1000 would wait for the counter to wrap, about 17 seconds,
+	so the caller cancels it with forceTRxOff. The warning is cleared.
+
+	returns true if the delayed operation started too late
+	*/
+	boolean isDelayedStartLate();
+
 	boolean isReceiveDone();
 
 	void clearReceiveStatus();
@@ -449,12 +568,28 @@ namespace DW1000Jang {
 	void setInterruptPolarity(boolean val);
 
 	/**
-	Applies the target configuration to the DW1000
+	Applies the target configuration to the DW1000.
+	Only the registers whose content changes are written, switching between profiles that differ in one field is cheap.
 
 	@param [in] config the configuration to apply to the DW1000
 	*/
 	void applyConfiguration(device_configuration_t config);
 
+	/**
+	Captures the configuration applied last with its tuning registers, e.g. once per profile at startup.
+	applyConfigurationImage then switches to the profile without evaluating the tuning tables again.
+
+	@param [out] image the configuration image
+	*/
+	void saveConfigurationImage(configuration_image_t& image);
+
+	/**
+	Applies a configuration captured by saveConfigurationImage, only the registers that differ are written
+
+	@param [in] image the configuration image
+	*/
+	void applyConfigurationImage(const configuration_image_t& image);
+
 	/**
 	Enables the interrupts for the target events
 
@@ -475,6 +610,21 @@ namespace DW1000Jang {
 	returns the current PRF
 	*/
 	PulseFrequency getPulseFrequency();
+
+	/**
+	Returns the data rate of the current configuration
+	*/
+	DataRate getDataRate();
+
+	/**
+	Returns the preamble length of the current configuration
+	*/
+	PreambleLength getPreambleLength();
+
+	/**
+	Returns whether the frame check (CRC) is appended to transmitted frames
+	*/
+	boolean isFrameCheckEnabled();
 	
 	/**
 	Sets the timeout for Raceive Frame.
@@ -492,6 +642,25 @@ namespace DW1000Jang {
 	*/
 	void setSfdDetectionTimeout(uint16_t preambleSymbols);
 
+	/**
+	Enables the preamble sniff mode: until a preamble is detected the receiver is on for 2 PACs
+	and off for the rest of a cycle derived from the current preamble length and PAC size.
+	The sniff times follow later configuration changes and are restored by spiWakeup.
+
+	returns false, with the sniff mode off, if the preamble is too short to be sniffed
+	*/
+	boolean enableSniffMode();
+
+	/**
+	Disables the preamble sniff mode, the receiver stays on until a frame is received or a timeout expires
+	*/
+	void disableSniffMode();
+
+	/**
+	Returns whether the preamble sniff mode is enabled
+	*/
+	boolean isSniffModeEnabled();
+
 	/**
 	Sets the timeout for Raceive Frame. Must be sets in idle mode.
 	Allow the external microprocessor to enter a low power state awaiting a valid receive frame.
@@ -500,6 +669,11 @@ namespace DW1000Jang {
 	*/
 	void setReceiveFrameWaitTimeoutPeriod(uint16_t timeMicroSeconds);
 
+	/**
+	Returns the frame wait timeout last set with setReceiveFrameWaitTimeoutPeriod, 0 if disabled
+	*/
+	uint16_t getReceiveFrameWaitTimeoutPeriod();
+
 	/**
 	Sets the device in receive mode
 
@@ -565,7 +739,7 @@ namespace DW1000Jang {
 	
 	/**
 	Sets the time before the device enters receive after a transmission.
-	Use 0 here to deactivate it.
+	Use 0 here to deactivate it, W4R_TIM is then left untouched. W4R_TIM is only written when it changes.
 
 	@param[in] time in μs. units = ~1μs(1.026μs)
 	*/
@@ -615,12 +789,76 @@ namespace DW1000Jang {
     void getPrettyBytes(byte cmd, uint16_t offset, char msgBuffer[], uint16_t n);
 	#endif
 
+	/**
+	Prints 100 samples of the channel impulse response from the first path as text (real, imaginary, amplitude)
+	*/
+	DEPRECATED_MSG("use getReceivedCIR(samples, before, count, firstIndex) and print or send the buffer")
 	void getReceivedCIR();
 
+	/**
+	Reads samples of the channel impulse response of the last reception from the accumulator.
+	Each sample is a complex int16 pair, the accumulator holds getAccumulatorLength() samples.
+
+	@param [out] samples interleaved real and imaginary parts, room for 2*count values
+	@param [in] first accumulator index of the first sample
+	@param [in] count number of samples
+
+	returns the number of samples read, less than count at the end of the accumulator
+	*/
+	uint16_t getAccumulatorSamples(int16_t samples[], uint16_t first, uint16_t count);
+
+	/**
+	Reads a window of the channel impulse response of the last reception around its first path (FP_INDEX)
+
+	@param [out] samples interleaved real and imaginary parts, room for 2*count values
+	@param [in] before number of samples captured before the first path
+	@param [in] count length of the window
+	@param [out] firstIndex accumulator index of samples[0], can be nullptr
+
+	returns the number of samples read, the window is clipped at the ends of the accumulator
+	*/
+	uint16_t getReceivedCIR(int16_t samples[], uint16_t before, uint16_t count, uint16_t* firstIndex);
+
+	/**
+	Reads the whole accumulator in chunks of ACCUMULATOR_CHUNK_SAMPLES and hands each one to handler,
+	e.g. to send the impulse response in binary without a 4kB buffer. The accumulator clocks stay on until the end.
+
+	@param [in] handler called with the interleaved samples of the chunk, the accumulator index of its first sample and its length
+	*/
+	void streamAccumulator(void (* handler)(const int16_t samples[], uint16_t first, uint16_t count));
+
+	/**
+	Reads count samples of the accumulator from index first in chunks of ACCUMULATOR_CHUNK_SAMPLES and hands each one
+	to handler. The accumulator clocks are forced on once for the whole range, unlike repeated getAccumulatorSamples calls.
+
+	@param [in] first accumulator index of the first sample
+	@param [in] count number of samples
+	@param [in] handler called with the interleaved samples of the chunk, the accumulator index of its first sample, its length and context
+	@param [in] context passed through to handler
+
+	returns the number of samples read, less than count at the end of the accumulator
+	*/
+	uint16_t streamAccumulator(uint16_t first, uint16_t count, void (* handler)(const int16_t samples[], uint16_t first, uint16_t count, void* context), void* context);
+
+	/**
+	Returns the number of samples in the accumulator for the current PRF
+	*/
+	uint16_t getAccumulatorLength();
+
 	double getReceivedPhase();
 
 	uint16_t getFP_index();
 
+	/**
+	Gets the first path index of the last reception with its fractional part (10.6 fixed point, 1/64 tap = 1 DW1000 tick)
+	*/
+	uint16_t getFP_indexFixedPoint();
+
+	/**
+	Gets the index of the strongest path found by the leading edge detection (LDE_PPINDX), same unit as getFP_index
+	*/
+	uint16_t getPeakPathIndex();
+
 	uint16_t reverseByte(byte b);
 	 
 	uint16_t getFP_AMPL1();
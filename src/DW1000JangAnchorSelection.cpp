@@ -0,0 +1,251 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#include <Arduino.h>
+#include "DW1000JangAnchorSelection.hpp"
+#include "DW1000JangScheduler.hpp"
+
+namespace DW1000JangAnchorSelection {
+
+    constexpr uint8_t MAX_ITERATIONS = 10;
+    constexpr double CONVERGENCE_M = 0.001;
+    /* the previous selection is kept while its GDOP is within this fraction of the best one */
+    constexpr double SELECTION_HYSTERESIS = 0.1;
+
+    namespace {
+        AnchorPosition _anchors[MAX_SELECTABLE_ANCHORS];
+        uint8_t _anchorCount = 0;
+        /* millis() of the last NLOS flag of each anchor */
+        uint32_t _nlosTime[MAX_SELECTABLE_ANCHORS];
+        boolean _nlos[MAX_SELECTABLE_ANCHORS];
+        uint32_t _nlosHoldTime = 10000;
+        AnchorSelection _last = {false, 0, {0}, INFINITY};
+
+        const AnchorPosition* _find(uint16_t address) {
+            for(uint8_t i = 0; i < _anchorCount; i++) {
+                if(_anchors[i].address == address) {
+                    return &_anchors[i];
+                }
+            }
+            return nullptr;
+        }
+
+        boolean _eligible(uint8_t index, uint32_t now) {
+            if(!_nlos[index]) {
+                return true;
+            }
+            if(now - _nlosTime[index] >= _nlosHoldTime) {
+                _nlos[index] = false;
+                return true;
+            }
+            return false;
+        }
+    }
+
+    void setAnchors(const AnchorPosition anchors[], uint8_t count) {
+        _anchorCount = count > MAX_SELECTABLE_ANCHORS ? MAX_SELECTABLE_ANCHORS : count;
+        memcpy(_anchors, anchors, _anchorCount * sizeof(AnchorPosition));
+        memset(_nlos, 0, sizeof(_nlos));
+        _last.success = false;
+    }
+
+    void markNlos(uint16_t address, uint32_t now) {
+        for(uint8_t i = 0; i < _anchorCount; i++) {
+            if(_anchors[i].address == address) {
+                _nlos[i] = true;
+                _nlosTime[i] = now;
+            }
+        }
+    }
+
+    void setNlosHoldTime(uint32_t holdTime) {
+        _nlosHoldTime = holdTime;
+    }
+
+    double gdop(const AnchorPosition anchors[], uint8_t count, double x, double y) {
+        /* H^T H of the unit vectors */
+        double a11 = 0, a12 = 0, a22 = 0;
+        for(uint8_t i = 0; i < count; i++) {
+            double dx = x - anchors[i].x;
+            double dy = y - anchors[i].y;
+            double d = sqrt(dx*dx + dy*dy);
+            if(d < 1e-6) {
+                continue;
+            }
+            a11 += dx*dx / (d*d);
+            a12 += dx*dy / (d*d);
+            a22 += dy*dy / (d*d);
+        }
+        double det = a11*a22 - a12*a12;
+        if(det < 1e-9) {
+            return INFINITY;
+        }
+        /* trace of the inverse */
+        return sqrt((a11 + a22) / det);
+    }
+
+    AnchorSelection select(double x, double y, uint8_t count, uint32_t now) {
+        AnchorSelection result = {false, 0, {0}, INFINITY};
+
+        uint8_t eligible[MAX_SELECTABLE_ANCHORS];
+        uint8_t eligibleCount = 0;
+        for(uint8_t i = 0; i < _anchorCount; i++) {
+            if(_eligible(i, now)) {
+                eligible[eligibleCount++] = i;
+            }
+        }
+        if(count > MAX_SELECTED_ANCHORS) count = MAX_SELECTED_ANCHORS;
+        if(count > eligibleCount) count = eligibleCount;
+        if(count < 3) {
+            return result;
+        }
+
+        double lastGdop = INFINITY;
+
+        /* every combination of count eligible anchors, in lexicographic order */
+        uint8_t pick[MAX_SELECTED_ANCHORS];
+        for(uint8_t i = 0; i < count; i++) {
+            pick[i] = i;
+        }
+        AnchorPosition subset[MAX_SELECTED_ANCHORS];
+        while(true) {
+            for(uint8_t i = 0; i < count; i++) {
+                subset[i] = _anchors[eligible[pick[i]]];
+            }
+            double value = gdop(subset, count, x, y);
+            if(value < result.gdop) {
+                result.success = true;
+                result.count = count;
+                result.gdop = value;
+                for(uint8_t i = 0; i < count; i++) {
+                    result.addresses[i] = subset[i].address;
+                }
+            }
+            if(_last.success && _last.count == count) {
+                /* the subset currently ranged, same order as in _last since both follow the table */
+                boolean same = true;
+                for(uint8_t i = 0; i < count; i++) {
+                    same = same && subset[i].address == _last.addresses[i];
+                }
+                if(same) {
+                    lastGdop = value;
+                }
+            }
+
+            int8_t i = count - 1;
+            while(i >= 0 && pick[i] == eligibleCount - count + i) {
+                i--;
+            }
+            if(i < 0) {
+                break;
+            }
+            pick[i]++;
+            for(uint8_t j = i + 1; j < count; j++) {
+                pick[j] = pick[j - 1] + 1;
+            }
+        }
+
+        /* a previous subset that no longer fixes the position is never kept */
+        if(result.success && lastGdop <= result.gdop * (1.0 + SELECTION_HYSTERESIS)) {
+            result = _last;
+            result.gdop = lastGdop;
+        }
+        _last = result;
+        return result;
+    }
+
+    void schedule(const AnchorSelection& selection) {
+        if(!selection.success) {
+            return;
+        }
+        for(uint8_t i = 0; i < _anchorCount; i++) {
+            boolean selected = false;
+            for(uint8_t j = 0; j < selection.count; j++) {
+                if(selection.addresses[j] == _anchors[i].address) {
+                    selected = true;
+                }
+            }
+            if(!selected) {
+                DW1000JangScheduler::removeAnchor(_anchors[i].address);
+            } else if(DW1000JangScheduler::find(_anchors[i].address) == nullptr) {
+                DW1000JangScheduler::addAnchor(_anchors[i].address);
+            }
+        }
+    }
+
+    TagPosition locate(const uint16_t addresses[], const double ranges[], uint8_t count, double x0, double y0) {
+        if(count < 3) {
+            return {false, x0, y0};
+        }
+        const AnchorPosition* anchors[MAX_SELECTABLE_ANCHORS];
+        if(count > MAX_SELECTABLE_ANCHORS) count = MAX_SELECTABLE_ANCHORS;
+        for(uint8_t i = 0; i < count; i++) {
+            anchors[i] = _find(addresses[i]);
+            if(anchors[i] == nullptr) {
+                return {false, x0, y0};
+            }
+        }
+
+        double x = x0;
+        double y = y0;
+        for(uint8_t iteration = 0; iteration < MAX_ITERATIONS; iteration++) {
+            /* normal equations JtJ * delta = -Jt * r */
+            double a11 = 0, a12 = 0, a22 = 0, b1 = 0, b2 = 0;
+            for(uint8_t i = 0; i < count; i++) {
+                double dx = x - anchors[i]->x;
+                double dy = y - anchors[i]->y;
+                double d = sqrt(dx*dx + dy*dy);
+                if(d < 1e-6) d = 1e-6;
+
+                double jx = dx/d;
+                double jy = dy/d;
+                double r = d - ranges[i];
+
+                a11 += jx*jx;
+                a12 += jx*jy;
+                a22 += jy*jy;
+                b1 -= jx*r;
+                b2 -= jy*r;
+            }
+
+            double det = a11*a22 - a12*a12;
+            if(fabs(det) < 1e-9) {
+                return {false, x, y};
+            }
+            double stepX = (a22*b1 - a12*b2) / det;
+            double stepY = (a11*b2 - a12*b1) / det;
+            x += stepX;
+            y += stepY;
+
+            if(isnan(x) || isnan(y)) {
+                return {false, x0, y0};
+            }
+            if(fabs(stepX) < CONVERGENCE_M && fabs(stepY) < CONVERGENCE_M) {
+                return {true, x, y};
+            }
+        }
+        return {false, x, y};
+    }
+}
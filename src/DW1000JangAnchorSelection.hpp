@@ -0,0 +1,112 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace DW1000JangAnchorSelection {
+
+    /* Anchors with a known position, and anchors ranged at once */
+    constexpr uint8_t MAX_SELECTABLE_ANCHORS = 8;
+    constexpr uint8_t MAX_SELECTED_ANCHORS = 4;
+
+    typedef struct AnchorPosition {
+        uint16_t address;
+        double x;
+        double y;
+    } AnchorPosition;
+
+    typedef struct AnchorSelection {
+        boolean success;
+        uint8_t count;
+        uint16_t addresses[MAX_SELECTED_ANCHORS];
+        /* geometric dilution of precision of the subset at the tag estimate */
+        double gdop;
+    } AnchorSelection;
+
+    typedef struct TagPosition {
+        boolean success;
+        double x;
+        double y;
+    } TagPosition;
+
+    /**
+    Sets the anchors to choose from, at most MAX_SELECTABLE_ANCHORS. NLOS flags are cleared.
+    */
+    void setAnchors(const AnchorPosition anchors[], uint8_t count);
+
+    /**
+    Flags an anchor as seen without line of sight, e.g. from the nlos flag of its range report (New_structure),
+    it is left out of the selections for the hold time
+
+    @param [in] address short address of the anchor
+    @param [in] now millis()
+    */
+    void markNlos(uint16_t address, uint32_t now);
+
+    /* Time in ms an NLOS flag excludes its anchor, 10 s by default */
+    void setNlosHoldTime(uint32_t holdTime);
+
+    /**
+    Dilution of precision of ranges to the given anchors, sqrt(trace((H^T H)^-1)) where the rows of H are
+    the unit vectors from the anchors to the tag.
+
+    returns the GDOP, INFINITY if the anchors cannot fix the position
+    */
+    double gdop(const AnchorPosition anchors[], uint8_t count, double x, double y);
+
+    /**
+    Picks the subset of count anchors (3 to MAX_SELECTED_ANCHORS) with the lowest GDOP at the tag estimate,
+    anchors flagged NLOS within the hold time are left out. All subsets are tried.
+    The previous selection is kept while it stays eligible and within 10% of the best GDOP, so the schedule does not flap.
+
+    @param [in] x tag estimate
+    @param [in] y tag estimate
+    @param [in] count anchors to select, fewer are selected if fewer are eligible
+    @param [in] now millis()
+
+    returns the subset, success is false if fewer than 3 anchors are eligible or no subset fixes the position,
+     the previous selection is then dropped as well
+    */
+    AnchorSelection select(double x, double y, uint8_t count, uint32_t now);
+
+    /**
+    Makes DW1000JangScheduler range the selected anchors: the new ones are added, the others are removed
+    */
+    void schedule(const AnchorSelection& selection);
+
+    /**
+    Solves the 2D position from ranges to known anchors with Gauss-Newton iterations.
+
+    @param [in] addresses anchors ranged, looked up in the anchors of setAnchors
+    @param [in] ranges ranges in meters, aligned to addresses
+    @param [in] count number of ranges (at least 3)
+    @param [in] x0 initial guess, e.g. the last position
+    @param [in] y0 initial guess
+
+    returns the position, success is false if an anchor is unknown or the geometry does not converge
+    */
+    TagPosition locate(const uint16_t addresses[], const double ranges[], uint8_t count, double x0, double y0);
+}
@@ -0,0 +1,344 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#include <Arduino.h>
+#include "DW1000Jang.hpp"
+#include "DW1000JangConstants.hpp"
+#include "DW1000JangCIR.hpp"
+
+namespace DW1000JangCIR {
+
+    namespace {
+        /* Hand set starting point: NLOS channels rise slowly to a late strongest path, are spread and less peaky */
+        NlosModel _model = {
+            32,     // riseTime
+            -1,     // kurtosis
+            -2,     // firstPathRatio
+            2,      // meanExcessDelay
+            2,      // rmsDelaySpread
+            80,     // offset
+            60,     // biasPerExcessTap, about a fifth of a tap
+            0       // biasOffset
+        };
+
+        /* Rice coding of one block */
+        constexpr uint8_t RICE_ESCAPE = 15;
+        constexpr uint8_t RICE_RAW_BITS = 18;
+
+        typedef struct BitWriter {
+            byte* data;
+            uint16_t bits;
+        } BitWriter;
+
+        void _writeBits(BitWriter& writer, uint32_t value, uint8_t count) {
+            while(count > 0) {
+                count--;
+                byte* target = &writer.data[writer.bits >> 3];
+                byte mask = 0x80 >> (writer.bits & 7);
+                if(value & (static_cast<uint32_t>(1) << count)) {
+                    *target |= mask;
+                } else {
+                    *target &= ~mask;
+                }
+                writer.bits++;
+            }
+        }
+
+        /* Encodes count (at most COMPRESSION_BLOCK) samples to out, returns the block length */
+        uint16_t _encodeBlock(const int16_t samples[], uint16_t count, uint8_t mantissaBits, byte out[]) {
+            uint16_t values = 2*count;
+
+            /* block exponent: the largest value keeps mantissaBits bits with its sign */
+            uint16_t maxAbs = 0;
+            for(uint16_t i = 0; i < values; i++) {
+                uint16_t magnitude = samples[i] < 0 ? -static_cast<int32_t>(samples[i]) : samples[i];
+                if(magnitude > maxAbs) maxAbs = magnitude;
+            }
+            uint8_t exponent = 0;
+            while((static_cast<uint32_t>(maxAbs) >> exponent) >= (static_cast<uint32_t>(1) << (mantissaBits - 1)) && exponent < 15) {
+                exponent++;
+            }
+
+            /* zigzag deltas, I and Q follow their own previous value */
+            uint32_t mapped[2*COMPRESSION_BLOCK];
+            int32_t previous[2] = {0, 0};
+            uint32_t sum = 0;
+            for(uint16_t i = 0; i < values; i++) {
+                int32_t value = samples[i] >= 0 ? samples[i] >> exponent : -((-static_cast<int32_t>(samples[i])) >> exponent);
+                int32_t delta = value - previous[i & 1];
+                previous[i & 1] = value;
+                mapped[i] = delta >= 0 ? static_cast<uint32_t>(delta) << 1 : (static_cast<uint32_t>(-delta) << 1) - 1;
+                sum += mapped[i];
+            }
+
+            /* rice parameter close to log2 of the mean */
+            uint8_t k = 0;
+            while(k < 15 && (static_cast<uint32_t>(values) << (k + 1)) <= sum) {
+                k++;
+            }
+
+            BitWriter writer = {&out[2], 0};
+            for(uint16_t i = 0; i < values; i++) {
+                uint32_t quotient = mapped[i] >> k;
+                if(quotient >= RICE_ESCAPE) {
+                    _writeBits(writer, (static_cast<uint32_t>(1) << RICE_ESCAPE) - 1, RICE_ESCAPE);
+                    _writeBits(writer, mapped[i], RICE_RAW_BITS);
+                } else {
+                    /* quotient ones then a zero */
+                    _writeBits(writer, ((static_cast<uint32_t>(1) << quotient) - 1) << 1, quotient + 1);
+                    _writeBits(writer, mapped[i], k);
+                }
+            }
+            /* pad the last byte with zeros */
+            if(writer.bits & 7) {
+                _writeBits(writer, 0, 8 - (writer.bits & 7));
+            }
+
+            uint16_t length = writer.bits >> 3;
+            out[0] = (exponent << 4) | k;
+            out[1] = static_cast<byte>(length);
+            return length + 2;
+        }
+
+        uint16_t _writeHeader(byte out[], byte sequence, uint16_t firstIndex, uint16_t fpIndexFixedPoint, uint16_t count) {
+            out[0] = COMPRESSION_SYNC_1;
+            out[1] = COMPRESSION_SYNC_2;
+            out[2] = sequence;
+            out[3] = firstIndex & 0xFF;
+            out[4] = firstIndex >> 8;
+            out[5] = fpIndexFixedPoint & 0xFF;
+            out[6] = fpIndexFixedPoint >> 8;
+            out[7] = count & 0xFF;
+            out[8] = count >> 8;
+            return 9;
+        }
+
+        byte _checksum(const byte data[], uint16_t length, byte checksum) {
+            for(uint16_t i = 0; i < length; i++) {
+                checksum += data[i];
+            }
+            return checksum;
+        }
+
+        uint8_t _clampMantissa(uint8_t mantissaBits) {
+            if(mantissaBits < 2) return 2;
+            if(mantissaBits > 16) return 16;
+            return mantissaBits;
+        }
+
+        uint32_t _sqrt(uint32_t value) {
+            uint32_t result = 0;
+            uint32_t bit = static_cast<uint32_t>(1) << 30;
+            while(bit > value) {
+                bit >>= 2;
+            }
+            while(bit != 0) {
+                if(value >= result + bit) {
+                    value -= result + bit;
+                    result = (result >> 1) + bit;
+                } else {
+                    result >>= 1;
+                }
+                bit >>= 2;
+            }
+            return result;
+        }
+
+        /* streamAccumulator handler filling the CirWindow passed as context */
+        void _appendToWindow(const int16_t chunk[], uint16_t first, uint16_t count, void* context) {
+            CirWindow& window = *static_cast<CirWindow*>(context);
+            for(uint16_t i = 0; i < count; i++) {
+                window.amplitude[window.count + i] = amplitude(chunk[2*i], chunk[2*i + 1]);
+                if(window.count + i < LEADING_EDGE_WINDOW) {
+                    window.leadingEdge[2*(window.count + i)] = chunk[2*i];
+                    window.leadingEdge[2*(window.count + i) + 1] = chunk[2*i + 1];
+                }
+            }
+            window.count += count;
+        }
+    }
+
+    uint16_t amplitude(int16_t re, int16_t im) {
+        uint16_t a = re < 0 ? -static_cast<int32_t>(re) : re;
+        uint16_t b = im < 0 ? -static_cast<int32_t>(im) : im;
+        uint16_t high = a > b ? a : b;
+        uint16_t low = a > b ? b : a;
+        /* max + 3/8 min stays below 65535 for 16 bit components */
+        return high + ((low * static_cast<uint32_t>(3)) >> 3);
+    }
+
+    void readWindow(CirWindow& window) {
+        window.fpIndexFixedPoint = DW1000Jang::getFP_indexFixedPoint();
+        uint16_t fpIndex = window.fpIndexFixedPoint / 64;
+        uint16_t first = fpIndex > FEATURE_WINDOW_BEFORE ? fpIndex - FEATURE_WINDOW_BEFORE : 0;
+        window.firstIndex = first;
+        window.firstPath = fpIndex - first;
+        window.count = 0;
+        /* one clock switch for the whole window */
+        DW1000Jang::streamAccumulator(first, FEATURE_WINDOW, _appendToWindow, &window);
+    }
+
+    CirFeatures computeFeatures(const CirWindow& window) {
+        CirFeatures features = {0, 0, 0, 0, 0};
+        if(window.firstPath >= window.count) {
+            return features;
+        }
+        const uint16_t* a = window.amplitude;
+
+        uint16_t peak = window.firstPath;
+        for(uint16_t i = window.firstPath; i < window.count; i++) {
+            if(a[i] > a[peak]) {
+                peak = i;
+            }
+        }
+        features.riseTime = peak - window.firstPath;
+        features.firstPathRatio = a[peak] > 0 ? static_cast<uint16_t>((static_cast<uint32_t>(a[window.firstPath]) << 8) / a[peak]) : 0;
+
+        /* energy moments of the delay after the first path */
+        uint64_t energy = 0, moment1 = 0, moment2 = 0;
+        for(uint16_t i = window.firstPath; i < window.count; i++) {
+            uint32_t e = (static_cast<uint32_t>(a[i]) * a[i]) >> 12;
+            uint32_t t = i - window.firstPath;
+            energy += e;
+            moment1 += static_cast<uint64_t>(t) * e;
+            moment2 += static_cast<uint64_t>(t * t) * e;
+        }
+        if(energy > 0) {
+            uint32_t mean = static_cast<uint32_t>((moment1 << 4) / energy);
+            int64_t variance = static_cast<int64_t>((moment2 << 8) / energy) - static_cast<int64_t>(mean) * mean;
+            features.meanExcessDelay = mean > 0xFFFF ? 0xFFFF : mean;
+            features.rmsDelaySpread = variance > 0 ? _sqrt(static_cast<uint32_t>(variance)) : 0;
+        }
+
+        /* kurtosis over the whole window, deviations scaled down to keep the fourth powers in 64 bits */
+        uint32_t sum = 0;
+        for(uint16_t i = 0; i < window.count; i++) {
+            sum += a[i];
+        }
+        int32_t mean = sum / window.count;
+        uint32_t maxDeviation = 0;
+        for(uint16_t i = 0; i < window.count; i++) {
+            uint32_t deviation = a[i] > mean ? a[i] - mean : mean - a[i];
+            if(deviation > maxDeviation) maxDeviation = deviation;
+        }
+        uint8_t shift = 0;
+        while((maxDeviation >> shift) > 2047) {
+            shift++;
+        }
+        uint64_t sum2 = 0, sum4 = 0;
+        for(uint16_t i = 0; i < window.count; i++) {
+            int32_t deviation = (static_cast<int32_t>(a[i]) - mean) / (static_cast<int32_t>(1) << shift);
+            uint32_t squared = static_cast<uint32_t>(deviation * deviation);
+            sum2 += squared;
+            sum4 += static_cast<uint64_t>(squared) * squared;
+        }
+        if(sum2 > 0) {
+            uint64_t kurtosis = (static_cast<uint64_t>(window.count) * sum4 << 4) / (sum2 * sum2);
+            features.kurtosis = kurtosis > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(kurtosis);
+        }
+        return features;
+    }
+
+    NlosClassification classify(const CirFeatures& features) {
+        NlosClassification result;
+        result.features = features;
+        result.score = _model.offset
+            + static_cast<int32_t>(_model.riseTime) * features.riseTime
+            + static_cast<int32_t>(_model.kurtosis) * features.kurtosis
+            + static_cast<int32_t>(_model.firstPathRatio) * features.firstPathRatio
+            + static_cast<int32_t>(_model.meanExcessDelay) * features.meanExcessDelay
+            + static_cast<int32_t>(_model.rmsDelaySpread) * features.rmsDelaySpread;
+        result.nlos = result.score > 0;
+
+        result.bias = 0;
+        if(result.nlos) {
+            int32_t biasMillimeters = _model.biasOffset + (static_cast<int32_t>(_model.biasPerExcessTap) * features.meanExcessDelay) / 16;
+            if(biasMillimeters > 0) {
+                result.bias = biasMillimeters / 1000.0;
+            }
+        }
+        return result;
+    }
+
+    NlosClassification classifyLastReception() {
+        CirWindow window;
+        readWindow(window);
+        return classify(computeFeatures(window));
+    }
+
+    void setModel(const NlosModel& model) {
+        _model = model;
+    }
+
+    uint16_t compressWindow(const int16_t samples[], uint16_t count, uint16_t firstIndex, uint16_t fpIndexFixedPoint,
+        byte sequence, uint8_t mantissaBits, byte out[], uint16_t outSize) {
+        mantissaBits = _clampMantissa(mantissaBits);
+        if(outSize < 10) {
+            return 0;
+        }
+        uint16_t length = _writeHeader(out, sequence, firstIndex, fpIndexFixedPoint, count);
+
+        byte block[MAX_COMPRESSED_BLOCK];
+        for(uint16_t done = 0; done < count; done += COMPRESSION_BLOCK) {
+            uint16_t samplesInBlock = count - done < COMPRESSION_BLOCK ? count - done : COMPRESSION_BLOCK;
+            uint16_t blockLength = _encodeBlock(&samples[2*done], samplesInBlock, mantissaBits, block);
+            if(length + blockLength + 1 > outSize) {
+                return 0;
+            }
+            memcpy(&out[length], block, blockLength);
+            length += blockLength;
+        }
+        out[length] = _checksum(&out[2], length - 2, 0);
+        return length + 1;
+    }
+
+    void streamCompressedCIR(Print& out, uint16_t before, uint16_t count, byte sequence, uint8_t mantissaBits) {
+        mantissaBits = _clampMantissa(mantissaBits);
+        uint16_t fpIndexFixedPoint = DW1000Jang::getFP_indexFixedPoint();
+        uint16_t fpIndex = fpIndexFixedPoint / 64;
+        uint16_t first = fpIndex > before ? fpIndex - before : 0;
+        uint16_t length = DW1000Jang::getAccumulatorLength();
+        if(first + count > length) {
+            count = first < length ? length - first : 0;
+        }
+
+        byte header[9];
+        _writeHeader(header, sequence, first, fpIndexFixedPoint, count);
+        out.write(header, sizeof(header));
+        byte checksum = _checksum(&header[2], sizeof(header) - 2, 0);
+
+        int16_t samples[2*COMPRESSION_BLOCK];
+        byte block[MAX_COMPRESSED_BLOCK];
+        for(uint16_t done = 0; done < count; done += COMPRESSION_BLOCK) {
+            uint16_t samplesInBlock = count - done < COMPRESSION_BLOCK ? count - done : COMPRESSION_BLOCK;
+            DW1000Jang::getAccumulatorSamples(samples, first + done, samplesInBlock);
+            uint16_t blockLength = _encodeBlock(samples, samplesInBlock, mantissaBits, block);
+            /* returns as soon as the block is queued, the next accumulator read overlaps its transmission */
+            out.write(block, blockLength);
+            checksum = _checksum(block, blockLength, checksum);
+        }
+        out.write(checksum);
+    }
+}
@@ -0,0 +1,158 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace DW1000JangCIR {
+
+    /* Taps of the impulse response used for the features, from 2 taps before the first path */
+    constexpr uint16_t FEATURE_WINDOW = 64;
+    constexpr uint16_t FEATURE_WINDOW_BEFORE = 2;
+
+    /* Complex samples kept from the start of the window for DW1000JangRanging::estimateFirstPath */
+    constexpr uint16_t LEADING_EDGE_WINDOW = 8;
+
+    /* Amplitudes of the impulse response around the first path of one reception */
+    typedef struct CirWindow {
+        uint16_t amplitude[FEATURE_WINDOW];
+        uint16_t count;
+        /* position of the first path (FP_INDEX) in amplitude[] */
+        uint16_t firstPath;
+        /* first LEADING_EDGE_WINDOW samples, interleaved real and imaginary parts */
+        int16_t leadingEdge[2*LEADING_EDGE_WINDOW];
+        /* accumulator index of amplitude[0] and FP_INDEX in 10.6 fixed point */
+        uint16_t firstIndex;
+        uint16_t fpIndexFixedPoint;
+    } CirWindow;
+
+    /* Channel features of a reception, fixed point */
+    typedef struct CirFeatures {
+        /* taps from the first path to the strongest path */
+        uint16_t riseTime;
+        /* kurtosis of the amplitudes, Q4 */
+        uint16_t kurtosis;
+        /* first path amplitude over the strongest amplitude, Q8 */
+        uint16_t firstPathRatio;
+        /* energy weighted mean delay after the first path, Q4 taps */
+        uint16_t meanExcessDelay;
+        /* energy weighted delay spread, Q4 taps */
+        uint16_t rmsDelaySpread;
+    } CirFeatures;
+
+    /**
+    Linear LOS/NLOS model: score = offset + sum(weight * feature) in the units of CirFeatures, NLOS if score > 0.
+    The NLOS bias is estimated as biasOffset + biasPerExcessTap * meanExcessDelay (in taps), in millimeters.
+    The default model is set by hand from typical office and warehouse channels, train one on your site with setModel.
+    */
+    typedef struct NlosModel {
+        int16_t riseTime;
+        int16_t kurtosis;
+        int16_t firstPathRatio;
+        int16_t meanExcessDelay;
+        int16_t rmsDelaySpread;
+        int32_t offset;
+        int16_t biasPerExcessTap;
+        int16_t biasOffset;
+    } NlosModel;
+
+    typedef struct NlosClassification {
+        boolean nlos;
+        int32_t score;
+        /* estimated positive range bias in meters, 0 for LOS */
+        double bias;
+        CirFeatures features;
+    } NlosClassification;
+
+    /* Amplitude of a complex sample without square root (alpha max plus beta min, error below 4%) */
+    uint16_t amplitude(int16_t re, int16_t im);
+
+    /**
+    Reads the impulse response window of the last reception, call it before the receiver is enabled again.
+    The features can be computed later, e.g. after answering the frame. The same read also serves the first path
+    refinement (leadingEdge), so the accumulator is only read once per reception.
+    */
+    void readWindow(CirWindow& window);
+
+    CirFeatures computeFeatures(const CirWindow& window);
+
+    NlosClassification classify(const CirFeatures& features);
+
+    /* readWindow, computeFeatures and classify in one call */
+    NlosClassification classifyLastReception();
+
+    /* Replaces the default model */
+    void setModel(const NlosModel& model);
+
+    /*** Compression of impulse response windows for offload, decoded on the host by CIRCollector.m ***
+
+    Frame: sync 0xA5 0x5A, sequence (1), first index (2), FP_INDEX 10.6 (2), sample count (2), blocks, checksum (1).
+    Each block of up to COMPRESSION_BLOCK samples: exponent << 4 | rice parameter (1), bitstream length (1), bitstream.
+    The block values are the samples shifted right by the block exponent, the bitstream holds the zigzag mapped deltas
+     of I and Q (interleaved, from 0 at the start of the block) in Rice codes, a quotient of 15 escapes to 18 raw bits.
+    Integers are little endian, bits are written MSB first, the checksum is the byte sum after the sync bytes.
+    */
+    constexpr uint16_t COMPRESSION_BLOCK = 16;
+    constexpr byte COMPRESSION_SYNC_1 = 0xA5;
+    constexpr byte COMPRESSION_SYNC_2 = 0x5A;
+    /* Largest encoded block, every value escaped */
+    constexpr uint16_t MAX_COMPRESSED_BLOCK = 2 + (2*COMPRESSION_BLOCK*33 + 7) / 8;
+
+    /* Size of a compressWindow buffer that always fits count samples, a partial last block counts as a full one */
+    constexpr uint16_t maxCompressedLength(uint16_t count) {
+        return (count + COMPRESSION_BLOCK - 1) / COMPRESSION_BLOCK * MAX_COMPRESSED_BLOCK + 12;
+    }
+
+    /**
+    Compresses a window of samples (see DW1000Jang::getReceivedCIR)
+
+    @param [in] samples interleaved real and imaginary parts
+    @param [in] count number of samples
+    @param [in] firstIndex accumulator index of samples[0]
+    @param [in] fpIndexFixedPoint FP_INDEX of the reception, 10.6 fixed point
+    @param [in] sequence frame counter echoed to the host
+    @param [in] mantissaBits bits kept per value and block (2..16), 16 is lossless
+    @param [out] out the frame
+    @param [in] outSize size of out, maxCompressedLength(count) = (count + COMPRESSION_BLOCK - 1) / COMPRESSION_BLOCK * MAX_COMPRESSED_BLOCK + 12 always fits
+
+    returns the frame length, 0 if out is too small
+    */
+    uint16_t compressWindow(const int16_t samples[], uint16_t count, uint16_t firstIndex, uint16_t fpIndexFixedPoint,
+        byte sequence, uint8_t mantissaBits, byte out[], uint16_t outSize);
+
+    /**
+    Reads a window around the first path of the last reception block by block and writes it compressed to out
+    (e.g. Serial). The serial port sends a block from its buffer while the next block is read from the accumulator,
+    so the window never needs to be held in RAM.
+
+    @param [in] out the output stream
+    @param [in] before samples before the first path
+    @param [in] count length of the window
+    @param [in] sequence frame counter echoed to the host
+    @param [in] mantissaBits bits kept per value and block (2..16), 16 is lossless
+    */
+    void streamCompressedCIR(Print& out, uint16_t before, uint16_t count, byte sequence, uint8_t mantissaBits);
+}
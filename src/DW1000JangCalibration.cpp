@@ -0,0 +1,110 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#include <Arduino.h>
+#include "DW1000JangCalibration.hpp"
+#include "DW1000Jang.hpp"
+#include "DW1000JangRegisters.hpp"
+#include "DW1000JangRanging.hpp"
+
+namespace DW1000JangCalibration {
+
+    namespace {
+        /* entry of this device, default delays and no slopes if it is not calibrated */
+        AntennaDelayEntry _entry = {0, 16436, 16436, 0, 0, 0};
+        uint32_t _samplePeriod = 10000;
+        uint16_t _delayThreshold = 2;
+        uint32_t _lastSample = 0;
+        boolean _sampled = false;
+        float _temperature = NAN;
+        /* correction written to the delay registers, in ticks */
+        int16_t _delayCorrection = 0;
+
+        void _writeDelays() {
+            DW1000Jang::setTxAntennaDelay(_entry.tx_delay + _delayCorrection);
+            DW1000Jang::setRxAntennaDelay(_entry.rx_delay + _delayCorrection);
+        }
+    }
+
+    uint64_t getEUI64() {
+        byte eui[LEN_EUI];
+        DW1000Jang::getEUI(eui);
+        uint64_t value = 0;
+        for(int8_t i = LEN_EUI - 1; i >= 0; i--) {
+            value = (value << 8) | eui[i];
+        }
+        return value;
+    }
+
+    boolean applyAntennaDelay(const AntennaDelayEntry table[], uint8_t count, uint16_t default_delay) {
+        uint64_t eui = getEUI64();
+        for(uint8_t i = 0; i < count; i++) {
+            if(table[i].eui == eui) {
+                _entry = table[i];
+                _delayCorrection = 0;
+                _sampled = false;
+                _writeDelays();
+                return true;
+            }
+        }
+        _entry = {eui, default_delay, default_delay, 0, 0, 0};
+        _delayCorrection = 0;
+        _sampled = false;
+        DW1000Jang::setAntennaDelay(default_delay);
+        return false;
+    }
+
+    void setTemperatureCompensation(uint32_t sample_period, uint16_t delay_threshold) {
+        _samplePeriod = sample_period;
+        _delayThreshold = delay_threshold;
+    }
+
+    boolean updateTemperatureCompensation(uint32_t now) {
+        if(_entry.delay_slope == 0 && _entry.bias_slope == 0) {
+            return false;
+        }
+        if(_sampled && now - _lastSample < _samplePeriod) {
+            return false;
+        }
+        _sampled = true;
+        _lastSample = now;
+        _temperature = DW1000Jang::getTemperature();
+
+        float drift = _temperature - _entry.temperature;
+        DW1000JangRanging::setRangeOffset(_entry.bias_slope * drift);
+
+        int16_t correction = static_cast<int16_t>(lround(_entry.delay_slope * drift));
+        if(abs(correction - _delayCorrection) < _delayThreshold) {
+            return false;
+        }
+        _delayCorrection = correction;
+        _writeDelays();
+        return true;
+    }
+
+    float getCompensationTemperature() {
+        return _temperature;
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace DW1000JangCalibration {
+
+    /* Antenna delays of one device, found with AntennaDelayCalibration.m */
+    typedef struct AntennaDelayEntry {
+        /* EUI as printed by getPrintableExtendedUniqueIdentifier, most significant byte first */
+        uint64_t eui;
+        uint16_t tx_delay;
+        uint16_t rx_delay;
+        /* die temperature in °C during the calibration, drift per °C away from it of both delays (ticks)
+           and of the range bias (m), leave the slopes at 0 to disable the temperature compensation */
+        float temperature;
+        float delay_slope;
+        float bias_slope;
+    } AntennaDelayEntry;
+
+    /**
+    EUI of the device as one number, in the order of getPrintableExtendedUniqueIdentifier
+    */
+    uint64_t getEUI64();
+
+    /**
+    Looks the EUI of the device up in the table and sets its tx and rx antenna delays.
+    Devices missing from the table get default_delay for both.
+
+    returns true if the device was found in the table
+    */
+    boolean applyAntennaDelay(const AntennaDelayEntry table[], uint8_t count, uint16_t default_delay);
+
+    /**
+    Sets how often updateTemperatureCompensation samples the die temperature (10 s by default)
+    and the change of the delay correction, in ticks, that is worth rewriting the antenna delays (2 by default)
+    */
+    void setTemperatureCompensation(uint32_t sample_period, uint16_t delay_threshold);
+
+    /**
+    Samples the die temperature once per sample period and follows it with the slopes of the entry
+    applied by applyAntennaDelay: the range bias goes to DW1000JangRanging::setRangeOffset, the delay
+    registers are only rewritten when their correction moved by the threshold.
+    Call it from the loop between exchanges, never while the radio is busy or asleep.
+
+    @param [in] now millis()
+
+    returns true if the antenna delays were rewritten
+    */
+    boolean updateTemperatureCompensation(uint32_t now);
+
+    /* Last sampled die temperature in °C, NAN before the first sample */
+    float getCompensationTemperature();
+}
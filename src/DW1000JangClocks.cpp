@@ -0,0 +1,145 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#include <Arduino.h>
+#include "DW1000JangClocks.hpp"
+#include "DW1000JangConstants.hpp"
+
+namespace DW1000JangClocks {
+
+    /* Carrier integrator noise, about 0.1 ppm on a good reception */
+    constexpr double CLOCK_OFFSET_VARIANCE = 0.1e-6 * 0.1e-6;
+
+    namespace {
+        PeerClock _peers[DW1000Jang_PEER_CLOCKS];
+        /* Monotonic use counter for LRU ordering, as in DW1000JangSessions */
+        uint32_t _useCounter = 0;
+
+        void _touch(PeerClock* peer) {
+            peer->lastUse = ++_useCounter;
+        }
+
+        int64_t _signedDifference(uint64_t from, uint64_t to) {
+            int64_t difference = static_cast<int64_t>((to + TIME_OVERFLOW - from) % TIME_OVERFLOW);
+            if(difference > TIME_OVERFLOW / 2) {
+                difference -= TIME_OVERFLOW;
+            }
+            return difference;
+        }
+    }
+
+    PeerClock* track(uint16_t address) {
+        PeerClock* slot = nullptr;
+        for(uint8_t i = 0; i < DW1000Jang_PEER_CLOCKS; i++) {
+            PeerClock* peer = &_peers[i];
+            if(peer->active && peer->address == address) {
+                return peer;
+            }
+            if(slot == nullptr || (slot->active && (!peer->active || peer->lastUse < slot->lastUse))) {
+                slot = peer;
+            }
+        }
+        memset(slot, 0, sizeof(PeerClock));
+        slot->address = address;
+        slot->active = true;
+        _touch(slot);
+        return slot;
+    }
+
+    PeerClock* find(uint16_t address) {
+        for(uint8_t i = 0; i < DW1000Jang_PEER_CLOCKS; i++) {
+            if(_peers[i].active && _peers[i].address == address) {
+                return &_peers[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void addTimestamps(PeerClock* peer, uint64_t peerTime, uint64_t localTime) {
+        DW1000JangTDoA::clockSyncUpdate(peer->sync, peerTime, localTime);
+        if(peer->samples < UINT16_MAX) {
+            peer->samples++;
+        }
+        _touch(peer);
+    }
+
+    void addClockOffset(PeerClock* peer, double clockOffset) {
+        /* the filter drift is (local - peer) / peer */
+        DW1000JangTDoA::clockSyncUpdateDrift(peer->sync, -clockOffset / (1.0 + clockOffset), CLOCK_OFFSET_VARIANCE);
+        _touch(peer);
+    }
+
+    ClockEstimate estimate(const PeerClock* peer, uint64_t localTime) {
+        const DW1000JangTDoA::ClockSync& sync = peer->sync;
+        ClockEstimate result = {sync.initialized, 0, 0, 0, 0};
+
+        if(sync.p22 > 0) {
+            result.ppm = -sync.drift / (1.0 + sync.drift) * 1e6;
+            result.ppmDeviation = sqrt(sync.p22) * 1e6;
+        }
+        if(sync.initialized) {
+            double dt = static_cast<double>(_signedDifference(sync.localTime, localTime));
+            result.offset = _signedDifference(localTime, DW1000JangTDoA::clockSyncToReference(sync, localTime));
+            result.offsetDeviation = sqrt(sync.p11 + 2*dt*sync.p12 + dt*dt*sync.p22);
+        }
+        return result;
+    }
+
+    uint64_t predictPeerTime(const PeerClock* peer, uint64_t localTime) {
+        return DW1000JangTDoA::clockSyncToReference(peer->sync, localTime);
+    }
+
+    uint64_t unwrapPeerTime(const PeerClock* peer, uint64_t peerTime, uint8_t bits, uint64_t localTime) {
+        uint64_t predicted = predictPeerTime(peer, localTime);
+        uint64_t span = static_cast<uint64_t>(1) << bits;
+        int64_t difference = static_cast<int64_t>((peerTime - predicted) & (span - 1));
+        if(difference >= static_cast<int64_t>(span / 2)) {
+            difference -= static_cast<int64_t>(span);
+        }
+        return (predicted + TIME_OVERFLOW + difference) % TIME_OVERFLOW;
+    }
+
+    int64_t toLocalDuration(const PeerClock* peer, int64_t peerDuration) {
+        return peerDuration + static_cast<int64_t>(static_cast<double>(peerDuration) * peer->sync.drift);
+    }
+
+    boolean isConsistent(const PeerClock* peer, uint64_t peerTime, uint64_t localTime, uint32_t toleranceTicks) {
+        if(!peer->sync.initialized) {
+            return true;
+        }
+        int64_t error = _signedDifference(peerTime, predictPeerTime(peer, localTime));
+        return error <= static_cast<int64_t>(toleranceTicks) && -error <= static_cast<int64_t>(toleranceTicks);
+    }
+
+    void forget(PeerClock* peer) {
+        if(peer != nullptr) {
+            peer->active = false;
+        }
+    }
+
+    void clear() {
+        memset(_peers, 0, sizeof(_peers));
+    }
+}
@@ -0,0 +1,142 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <Arduino.h>
+#include "DW1000JangCompileOptions.hpp"
+#include "DW1000JangTDoA.hpp"
+
+namespace DW1000JangClocks {
+
+    /* Clock model of one peer, the peer clock is the reference of the filter */
+    typedef struct PeerClock {
+        uint16_t address;
+        DW1000JangTDoA::ClockSync sync;
+        uint16_t samples;
+        uint32_t lastUse;
+        boolean active;
+    } PeerClock;
+
+    typedef struct ClockEstimate {
+        boolean valid;
+        /* peer time - local time in DW1000 ticks, includes the time of flight of the timestamp pairs */
+        int64_t offset;
+        /* peer rate offset against the local clock, positive if the peer runs faster */
+        double ppm;
+        /* standard deviations of the two values above */
+        double offsetDeviation;
+        double ppmDeviation;
+    } ClockEstimate;
+
+    /**
+    Finds the clock model of a peer or starts a new one.
+    When the table is full the least recently updated peer is evicted.
+
+    @param [in] address short address of the peer
+
+    returns the clock model of the peer
+    */
+    PeerClock* track(uint16_t address);
+
+    /**
+    Finds the clock model of a peer
+
+    returns the model or nullptr if the peer is not tracked
+    */
+    PeerClock* find(uint16_t address);
+
+    /**
+    Feeds an event timestamped by both clocks, e.g. the TX timestamp carried in a frame and its local RX timestamp.
+    The time of flight ends up in the offset, which is fine as long as the peer does not move much between pairs.
+
+    @param [in] peer the clock model
+    @param [in] peerTime time of the event in the peer clock
+    @param [in] localTime time of the event in the local clock
+    */
+    void addTimestamps(PeerClock* peer, uint64_t peerTime, uint64_t localTime);
+
+    /**
+    Feeds the clock offset measured on a frame of the peer, see DW1000Jang::getReceivedClockOffset
+
+    @param [in] peer the clock model
+    @param [in] clockOffset (peer rate - local rate) / local rate
+    */
+    void addClockOffset(PeerClock* peer, double clockOffset);
+
+    /**
+    Current offset, drift and their confidence
+
+    @param [in] peer the clock model
+    @param [in] localTime the local time the offset is evaluated at
+
+    returns the estimate, valid is false before the first timestamp pair
+    */
+    ClockEstimate estimate(const PeerClock* peer, uint64_t localTime);
+
+    /**
+    Predicts the peer time of an event timestamped locally
+
+    returns the peer time (40 bits), localTime if no timestamp pair was fed yet
+    */
+    uint64_t predictPeerTime(const PeerClock* peer, uint64_t localTime);
+
+    /**
+    Restores the bits a frame field dropped from a peer timestamp, e.g. the 32 bit FinalMessage times that wrap
+    every 67 ms, by picking the 40 bit time with those low bits closest to the prediction of the model.
+    Before the first timestamp pair the closest to localTime is used, the offset is then only known modulo 2^bits.
+
+    @param [in] peer the clock model
+    @param [in] peerTime low bits of the time of the event in the peer clock
+    @param [in] bits number of valid bits of peerTime
+    @param [in] localTime time of the same event in the local clock
+
+    returns the peer time (40 bits)
+    */
+    uint64_t unwrapPeerTime(const PeerClock* peer, uint64_t peerTime, uint8_t bits, uint64_t localTime);
+
+    /**
+    Converts a duration measured by the peer to the local clock, e.g. the reply time of a single sided exchange
+    */
+    int64_t toLocalDuration(const PeerClock* peer, int64_t peerDuration);
+
+    /**
+    Checks a timestamp pair against the model before using it
+
+    @param [in] peer the clock model
+    @param [in] peerTime time of the event in the peer clock
+    @param [in] localTime time of the event in the local clock
+    @param [in] toleranceTicks accepted distance from the prediction
+
+    returns true if the pair fits the model or the model has no estimate yet
+    */
+    boolean isConsistent(const PeerClock* peer, uint64_t peerTime, uint64_t localTime, uint32_t toleranceTicks);
+
+    /* Stops tracking a peer */
+    void forget(PeerClock* peer);
+
+    /* Stops tracking all peers */
+    void clear();
+}
@@ -67,4 +67,34 @@
  * Some examples or debug code use this
  * Set false if you do not need it and have to save some space
  */
-#define DW1000JangCONFIGURATION_H_PRINTABLE false
\ No newline at end of file
+#define DW1000JangCONFIGURATION_H_PRINTABLE false
+
+/**
+ * Number of concurrent tag exchanges an anchor tracks (DW1000JangSessions), about 40 byte of ram each
+ * The least recently used exchange is dropped when a new tag polls a full table
+ */
+#define DW1000Jang_TAG_SESSIONS 8
+
+/**
+ * Number of peers whose clock offset and drift are tracked (DW1000JangClocks), about 50 byte of ram each
+ * The least recently updated peer is dropped when a new one is tracked on a full table
+ */
+#define DW1000Jang_PEER_CLOCKS 8
+
+/**
+ * Number of anchors the tag ranging scheduler keeps a motion model for (DW1000JangScheduler), about 50 byte of ram each
+ * The anchor ranged least recently is dropped when a new one is added to a full table
+ */
+#define DW1000Jang_SCHEDULED_ANCHORS 8
+
+/**
+ * Number of anchors a tag keeps in its neighbor table (DW1000JangRTLS::tagDiscoverAnchors), about 12 byte of ram each
+ * The neighbor seen least recently is dropped when a new anchor answers on a full table
+ */
+#define DW1000Jang_NEIGHBORS 8
+
+/**
+ * Number of RTLS frame layouts kept resident in the TX buffer (DW1000JangFrames::TransmitBuffer), about 45 byte of ram each
+ * Each layout sits at its own TX buffer offset, the layout sent least recently is replaced by a new one on a full table
+ */
+#define DW1000Jang_RESIDENT_FRAMES 4
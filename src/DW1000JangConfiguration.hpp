@@ -41,6 +41,17 @@ typedef struct device_configuration_t {
     PreambleCode preaCode;
 } device_configuration_t;
 
+/* bytes of the tuning registers (AGC, DRX, LDE, TX power, RF, PLL, SFD length) of a configuration */
+constexpr uint8_t LEN_CONFIGURATION_IMAGE = 41;
+
+/* A configuration with its tuning registers, see DW1000Jang::saveConfigurationImage */
+typedef struct configuration_image_t {
+    device_configuration_t config;
+    byte registers[LEN_CONFIGURATION_IMAGE];
+    /* one bit per tuning register held by registers */
+    uint32_t valid;
+} configuration_image_t;
+
 typedef struct interrupt_configuration_t {
     boolean interruptOnSent;
     boolean interruptOnReceived;
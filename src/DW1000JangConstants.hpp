@@ -51,6 +51,12 @@
 	constexpr float MICROSECONDS = 1;
 	constexpr float NANOSECONDS  = 1e-3;
 
+	// channel impulse response accumulator length in complex samples (~1ns each), shorter with 16MHz PRF
+	constexpr uint16_t ACCUMULATOR_SAMPLES_PRF16 = 992;
+	constexpr uint16_t ACCUMULATOR_SAMPLES_PRF64 = 1016;
+	// samples read per SPI transaction when streaming the accumulator
+	constexpr uint16_t ACCUMULATOR_CHUNK_SAMPLES = 16;
+
 /* preamble codes (CHAN_CTRL - RX & TX _CODE) - reg:0x1F, bits:31-27,26-22 */
 
 enum class PreambleCode : byte {
@@ -0,0 +1,146 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#include <Arduino.h>
+#include "DW1000JangFrames.hpp"
+#include "DW1000Jang.hpp"
+
+namespace DW1000JangFrames {
+
+    void Blink::writeHeader(byte frame[], byte sequenceNumber) {
+        FrameType::write(frame, BLINK);
+        SequenceNumber::write(frame, sequenceNumber);
+        DW1000Jang::getEUI(TagEui::at(frame));
+        EncodingHeader::write(frame, NO_BATTERY_STATUS | NO_EX_ID);
+        ExtHeader::write(frame, TAG_LISTENING_NOW);
+    }
+
+    void RangingInitiation::writeHeader(byte frame[], byte sequenceNumber, const byte tagEui[]) {
+        FrameType::write(frame, DATA);
+        AddressingMode::write(frame, SHORT_SRC_LONG_DEST);
+        SequenceNumber::write(frame, sequenceNumber);
+        DW1000Jang::getNetworkId(NetworkId::at(frame));
+        TagEui::copy(frame, tagEui);
+        DW1000Jang::getDeviceAddress(Source::at(frame));
+        FunctionCode::write(frame, RANGING_INITIATION);
+    }
+
+    TransmitBuffer::Slot TransmitBuffer::_slots[DW1000Jang_RESIDENT_FRAMES];
+    uint32_t TransmitBuffer::_uses = 0;
+    uint32_t TransmitBuffer::_revision = 0;
+
+    uint8_t TransmitBuffer::_slotFor(const void* layout) {
+        uint8_t oldest = 0;
+        for(uint8_t i = 0; i < DW1000Jang_RESIDENT_FRAMES; i++) {
+            if(_slots[i].layout == layout) {
+                return i;
+            }
+            if(_slots[i].lastUse < _slots[oldest].lastUse) {
+                oldest = i;
+            }
+        }
+        _slots[oldest].layout = layout;
+        _slots[oldest].length = 0;
+        return oldest;
+    }
+
+    boolean TransmitBuffer::_nextPatch(const Slot& slot, uint16_t bufferOffset, const byte frame[], uint8_t length,
+                                       uint8_t& start, uint8_t& end) {
+        while(start < length && start < slot.length && slot.image[start] == frame[start]) {
+            start++;
+        }
+        if(start == length) {
+            return false;
+        }
+        /* unchanged runs shorter than a header are cheaper to rewrite than to skip */
+        uint8_t gap = _headerCost(bufferOffset + start);
+        end = start + 1;
+        for(uint8_t j = end; j < length && j < end + gap; j++) {
+            if(j >= slot.length || slot.image[j] != frame[j]) {
+                end = j + 1;
+            }
+        }
+        return true;
+    }
+
+    boolean TransmitBuffer::_loadFull(uint8_t slot, const byte frame[], uint8_t length) {
+        if(!DW1000Jang::setTransmitDataAt(_bufferOffset(slot), const_cast<byte*>(frame), length)) {
+            _slots[slot].layout = nullptr;
+            return false;
+        }
+        memcpy(_slots[slot].image, frame, length);
+        _slots[slot].length = length;
+        return true;
+    }
+
+    boolean TransmitBuffer::load(const void* layout, const byte frame[], uint8_t length) {
+        if(_revision != DW1000Jang::getTransmitBufferRevision()) {
+            /* buffer rewritten behind our back, nothing is resident anymore */
+            for(uint8_t i = 0; i < DW1000Jang_RESIDENT_FRAMES; i++) {
+                _slots[i].layout = nullptr;
+                _slots[i].length = 0;
+                _slots[i].lastUse = 0;
+            }
+            _revision = DW1000Jang::getTransmitBufferRevision();
+        }
+
+        uint8_t index = _slotFor(layout);
+        Slot& slot = _slots[index];
+        slot.lastUse = ++_uses;
+        uint16_t bufferOffset = _bufferOffset(index);
+
+        /* patch only when it moves fewer bytes (headers included) than a full load */
+        uint16_t patchCost = 0;
+        uint8_t start = 0, end = 0;
+        while(_nextPatch(slot, bufferOffset, frame, length, start, end)) {
+            patchCost += _headerCost(bufferOffset + start) + (end - start);
+            start = end;
+        }
+        boolean loaded = true;
+        if(patchCost >= _headerCost(bufferOffset) + length) {
+            loaded = _loadFull(index, frame, length);
+        } else {
+            start = 0;
+            while(_nextPatch(slot, bufferOffset, frame, length, start, end)) {
+                if(!DW1000Jang::setTransmitDataAt(bufferOffset + start, const_cast<byte*>(&frame[start]), end - start)) {
+                    /* the resident copy is partly patched, rewrite it whole */
+                    loaded = _loadFull(index, frame, length);
+                    break;
+                }
+                memcpy(&slot.image[start], &frame[start], end - start);
+                start = end;
+            }
+            if(loaded && length > slot.length) {
+                slot.length = length;
+            }
+        }
+        return loaded && DW1000Jang::setTransmitLength(length, bufferOffset);
+    }
+
+    void ReceivedFrame::read() {
+        _length = DW1000Jang::getReceivedDataLength();
+        DW1000Jang::getReceivedData(_data, _length < MAX_RTLS_FRAME_LENGTH ? _length : MAX_RTLS_FRAME_LENGTH);
+    }
+}
@@ -0,0 +1,381 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <Arduino.h>
+#include "DW1000Jang.hpp"
+#include "DW1000JangRTLS.hpp"
+#include "DW1000JangCompileOptions.hpp"
+
+/* Largest frame used by the RTLS messages (superframe beacon), also the size of the receive buffer */
+constexpr uint8_t MAX_RTLS_FRAME_LENGTH = 36;
+
+namespace DW1000JangFrames {
+
+    /**
+    A little-endian field of Length bytes placed at Offset inside a frame.
+    Offsets and lengths are compile time constants so encoding and decoding work in place on the frame bytes.
+    */
+    template<uint8_t Offset, uint8_t Length>
+    struct Field {
+        static constexpr uint8_t offset() { return Offset; }
+        static constexpr uint8_t length() { return Length; }
+        static constexpr uint8_t end() { return Offset + Length; }
+
+        static byte* at(byte frame[]) {
+            return frame + Offset;
+        }
+
+        static void write(byte frame[], uint64_t value) {
+            for(uint8_t i = 0; i < Length; i++) {
+                frame[Offset + i] = static_cast<byte>((value >> (i*8)) & 0xFF);
+            }
+        }
+
+        static void copy(byte frame[], const byte source[]) {
+            memcpy(frame + Offset, source, Length);
+        }
+
+        static uint64_t read(const byte frame[]) {
+            uint64_t value = 0;
+            for(uint8_t i = 0; i < Length; i++) {
+                value |= (static_cast<uint64_t>(frame[Offset + i]) << (i*8));
+            }
+            return value;
+        }
+    };
+
+    /**
+    IEEE 802.15.4-2011 data frame with short destination and source addresses, followed by the RTLS function code.
+    Length is the total frame length without the two CRC bytes.
+    */
+    template<byte Code, uint8_t Length>
+    struct ShortFrame {
+        typedef Field<0, 1> FrameType;
+        typedef Field<1, 1> AddressingMode;
+        typedef Field<2, 1> SequenceNumber;
+        typedef Field<3, 2> NetworkId;
+        typedef Field<5, 2> Destination;
+        typedef Field<7, 2> Source;
+        typedef Field<9, 1> FunctionCode;
+
+        static constexpr uint8_t length() { return Length; }
+
+        static void writeHeader(byte frame[], byte sequenceNumber, const byte destination[]) {
+            FrameType::write(frame, DATA);
+            AddressingMode::write(frame, SHORT_SRC_AND_DEST);
+            SequenceNumber::write(frame, sequenceNumber);
+            DW1000Jang::getNetworkId(NetworkId::at(frame));
+            Destination::copy(frame, destination);
+            DW1000Jang::getDeviceAddress(Source::at(frame));
+            FunctionCode::write(frame, Code);
+        }
+
+        static boolean matches(const byte frame[], uint16_t frameLength) {
+            return frameLength >= Length && FunctionCode::read(frame) == Code;
+        }
+    };
+
+    /* Activity control frame (function code 0x10), the activity code follows the function code */
+    template<byte Activity, uint8_t Length>
+    struct ActivityFrame : ShortFrame<ACTIVITY_CONTROL, Length> {
+        typedef ShortFrame<ACTIVITY_CONTROL, Length> Base;
+        typedef Field<10, 1> ActivityCode;
+
+        static void writeHeader(byte frame[], byte sequenceNumber, const byte destination[]) {
+            Base::writeHeader(frame, sequenceNumber, destination);
+            ActivityCode::write(frame, Activity);
+        }
+
+        static boolean matches(const byte frame[], uint16_t frameLength) {
+            return Base::matches(frame, frameLength) && ActivityCode::read(frame) == Activity;
+        }
+    };
+
+    /* Any activity control frame, used to check the function code before looking at the activity */
+    typedef ShortFrame<ACTIVITY_CONTROL, 11> ActivityControl;
+
+    /*** Layouts of the TWR messages, refer to ISO/IEC 24730-62:2013 for details ***/
+
+    struct Blink {
+        typedef Field<0, 1> FrameType;
+        typedef Field<1, 1> SequenceNumber;
+        typedef Field<2, 8> TagEui;
+        typedef Field<10, 1> EncodingHeader;
+        typedef Field<11, 1> ExtHeader;
+
+        static constexpr uint8_t length() { return ExtHeader::end(); }
+
+        static void writeHeader(byte frame[], byte sequenceNumber);
+
+        static boolean matches(const byte frame[], uint16_t frameLength) {
+            return frameLength >= length() && FrameType::read(frame) == BLINK;
+        }
+    };
+
+    struct RangingInitiation {
+        typedef Field<0, 1> FrameType;
+        typedef Field<1, 1> AddressingMode;
+        typedef Field<2, 1> SequenceNumber;
+        typedef Field<3, 2> NetworkId;
+        typedef Field<5, 8> TagEui;
+        typedef Field<13, 2> Source;
+        typedef Field<15, 1> FunctionCode;
+        typedef Field<16, 2> TagShortAddress;
+
+        static constexpr uint8_t length() { return TagShortAddress::end(); }
+
+        static void writeHeader(byte frame[], byte sequenceNumber, const byte tagEui[]);
+
+        static boolean matches(const byte frame[], uint16_t frameLength) {
+            return frameLength >= length() && FunctionCode::read(frame) == RANGING_INITIATION;
+        }
+    };
+
+    /* Poll and post final carry no payload, the trailing bytes are kept for compatibility with deployed anchors */
+    struct Poll : ShortFrame<RANGING_TAG_POLL, 24> {};
+
+    struct PostFinal : ShortFrame<RANGING_TAG_POST_FINAL_RESPONSE_EMBEDDED, 24> {};
+
+    struct ResponseToPoll : ActivityFrame<RANGING_CONTINUE, 13> {
+        typedef Field<11, 2> Option;
+    };
+
+    /* Response sent with a delayed transmission, padded to the length of the poll */
+    struct DelayedResponseToPoll : ActivityFrame<RANGING_CONTINUE, 24> {};
+
+    struct FinalMessage : ShortFrame<RANGING_TAG_FINAL_RESPONSE_EMBEDDED, 22> {
+        typedef Field<10, 4> PollSent;
+        typedef Field<PollSent::end(), 4> ResponseReceived;
+        typedef Field<ResponseReceived::end(), 4> FinalSent;
+    };
+
+    /* Final message carrying the phase of the response to poll in milliradians */
+    struct PhaseFinalMessage : ShortFrame<RANGING_TAG_FINAL_RESPONSE_EMBEDDED, 26> {
+        typedef FinalMessage::PollSent PollSent;
+        typedef FinalMessage::ResponseReceived ResponseReceived;
+        typedef FinalMessage::FinalSent FinalSent;
+        typedef Field<FinalSent::end(), 4> PhaseResponse;
+    };
+
+    struct RangingConfirm : ActivityFrame<RANGING_CONFIRM, 13> {
+        typedef Field<11, 2> NextAnchor;
+    };
+
+    /* Ranging confirm reporting the computed range in millimeters */
+    struct RangeReport : ActivityFrame<RANGING_CONFIRM, 15> {
+        typedef RangingConfirm::NextAnchor NextAnchor;
+        typedef Field<NextAnchor::end(), 2> Range;
+    };
+
+    /* Range report also carrying the two-way carrier phase (poll + response) in milliradians, answers a PhaseFinalMessage */
+    struct PhaseRangeReport : ActivityFrame<RANGING_CONFIRM, 17> {
+        typedef RangeReport::NextAnchor NextAnchor;
+        typedef RangeReport::Range Range;
+        typedef Field<Range::end(), 2> Phase;
+    };
+
+    /* Range report of anchorRangeAcceptMultiTag, a PhaseRangeReport (phase 0 after a plain final) followed by the
+       channel class of the tag's previous final, so tags reading a RangeReport or a PhaseRangeReport still accept it */
+    struct ClassifiedRangeReport : ActivityFrame<RANGING_CONFIRM, 20> {
+        typedef PhaseRangeReport::NextAnchor NextAnchor;
+        typedef PhaseRangeReport::Range Range;
+        typedef PhaseRangeReport::Phase Phase;
+        /* 1 if the previous final was received without line of sight */
+        typedef Field<Phase::end(), 1> Nlos;
+        /* estimated NLOS bias of the range in millimeters */
+        typedef Field<Nlos::end(), 2> Bias;
+    };
+
+    struct ActivityFinished : ActivityFrame<ACTIVITY_FINISHED, 15> {
+        typedef Field<11, 2> BlinkRate;
+        typedef Field<BlinkRate::end(), 2> Range;
+    };
+
+    /* Beacon of the TDMA superframe, sent to the broadcast address */
+    struct SuperframeBeacon : ShortFrame<SUPERFRAME_BEACON, 15 + 2*MAX_SUPERFRAME_SLOTS> {
+        typedef Field<10, 2> SuperframeNumber;
+        typedef Field<SuperframeNumber::end(), 2> SlotDuration;
+        typedef Field<SlotDuration::end(), 1> SlotCount;
+        typedef Field<SlotCount::end(), 2*MAX_SUPERFRAME_SLOTS> SlotTags;
+    };
+
+    /* Beacon of the downlink TDoA mode, sent to the broadcast address. Slot 0 is the master */
+    struct TdoaBeacon : ShortFrame<TDOA_BEACON, 21> {
+        typedef Field<10, 1> Round;
+        typedef Field<Round::end(), 1> Slot;
+        /* master: transmission time, 40 bits */
+        typedef Field<Slot::end(), 5> TxTime;
+        /* anchors: time from the master beacon reception to the own transmission, in master clock ticks */
+        typedef Field<TxTime::end(), 4> ReplyTime;
+    };
+
+    /**
+    Builds a frame of the given layout in a buffer sized at compile time.
+    The constructor arguments are forwarded to the header writer of the layout, payload bytes start zeroed.
+    */
+    template<typename Layout>
+    struct Encoder {
+        byte data[Layout::length()];
+
+        template<typename... Args>
+        explicit Encoder(Args... args) {
+            memset(data, 0, Layout::length());
+            Layout::writeHeader(data, args...);
+        }
+
+        template<typename F>
+        void set(uint64_t value) {
+            static_assert(F::end() <= Layout::length(), "Field out of frame bounds");
+            F::write(data, value);
+        }
+
+        template<typename F>
+        byte* at() {
+            static_assert(F::end() <= Layout::length(), "Field out of frame bounds");
+            return F::at(data);
+        }
+
+        static constexpr uint8_t length() { return Layout::length(); }
+    };
+
+    /**
+    Keeps the last DW1000Jang_RESIDENT_FRAMES layouts sent resident in the TX buffer of the DW1000, each at its own
+    offset selected through TXBOFFS. The first send of a layout (or any send after the buffer was rewritten outside
+    of this class, reset or put to sleep) loads the whole frame, following sends of the same layout patch by
+    sub-address only the bytes that differ from its resident copy when that is cheaper than a full load, so
+    alternating layouts (Poll and Final, Response and Range Report) only rewrite sequence number and timestamps.
+    */
+    class TransmitBuffer {
+    public:
+        /* layout is any address unique to the frame layout, it selects the resident copy to patch.
+           Returns false if the frame could not be loaded, it must not be sent then */
+        static boolean load(const void* layout, const byte frame[], uint8_t length);
+
+    private:
+        typedef struct Slot {
+            const void* layout;
+            byte image[MAX_RTLS_FRAME_LENGTH];
+            uint8_t length;
+            uint32_t lastUse;
+        } Slot;
+
+        /* SPI header of a write to TX_BUFFER at offset, the cost of one more transaction in bytes */
+        static uint8_t _headerCost(uint16_t offset) { return offset < 128 ? 2 : 3; }
+        static uint16_t _bufferOffset(uint8_t slot) { return slot * MAX_RTLS_FRAME_LENGTH; }
+
+        /* slot holding layout, or the least recently used one emptied for it */
+        static uint8_t _slotFor(const void* layout);
+        /* next run to rewrite at or after start, false if the rest of the frame is resident */
+        static boolean _nextPatch(const Slot& slot, uint16_t bufferOffset, const byte frame[], uint8_t length,
+                                  uint8_t& start, uint8_t& end);
+        static boolean _loadFull(uint8_t slot, const byte frame[], uint8_t length);
+
+        static Slot _slots[DW1000Jang_RESIDENT_FRAMES];
+        static uint32_t _uses;
+        /* driver revision after the last write of this class, any other write moves it */
+        static uint32_t _revision;
+    };
+
+    template<typename Layout>
+    class TransmitTemplate {
+    public:
+        static boolean load(Encoder<Layout>& frame) {
+            static_assert(Layout::length() <= MAX_RTLS_FRAME_LENGTH, "Layout does not fit the transmit image");
+            return TransmitBuffer::load(&_layout, frame.data, Layout::length());
+        }
+
+    private:
+        /* only its address is used, as identity of the layout */
+        static const byte _layout;
+    };
+
+    template<typename Layout>
+    const byte TransmitTemplate<Layout>::_layout = 0;
+
+    /* Writes the frame to the TX buffer, patching the resident copy when possible. false: do not transmit */
+    template<typename Layout>
+    boolean setTransmitFrame(Encoder<Layout>& frame) {
+        return TransmitTemplate<Layout>::load(frame);
+    }
+
+    /**
+    Decoder over bytes already read from the RX buffer. Fields are read in place, nothing is copied.
+    */
+    template<typename Layout>
+    class View {
+    public:
+        View(byte data[], uint16_t length) : _data(data), _length(length) {}
+
+        boolean isValid() const {
+            return Layout::matches(_data, _length);
+        }
+
+        template<typename F>
+        uint64_t get() const {
+            static_assert(F::end() <= Layout::length(), "Field out of frame bounds");
+            return F::read(_data);
+        }
+
+        template<typename F>
+        byte* at() const {
+            static_assert(F::end() <= Layout::length(), "Field out of frame bounds");
+            return F::at(_data);
+        }
+
+    private:
+        byte* _data;
+        uint16_t _length;
+    };
+
+    /**
+    Fixed-size copy of the last received frame, read with a single SPI transaction.
+    Replaces the variable length arrays previously allocated on every receive.
+    */
+    class ReceivedFrame {
+    public:
+        /* Reads the frame length and data from the DW1000, frames longer than the buffer are truncated */
+        void read();
+
+        uint16_t length() const { return _length; }
+
+        template<typename Layout>
+        boolean is() const {
+            static_assert(Layout::length() <= MAX_RTLS_FRAME_LENGTH, "Layout does not fit the receive buffer");
+            return Layout::matches(_data, _length);
+        }
+
+        template<typename Layout>
+        View<Layout> as() {
+            static_assert(Layout::length() <= MAX_RTLS_FRAME_LENGTH, "Layout does not fit the receive buffer");
+            return View<Layout>(_data, _length);
+        }
+
+    private:
+        byte _data[MAX_RTLS_FRAME_LENGTH];
+        uint16_t _length = 0;
+    };
+}
@@ -28,43 +28,76 @@
 #include "DW1000JangUtils.hpp"
 #include "DW1000JangTime.hpp"
 #include "DW1000JangRanging.hpp"
+#include "DW1000JangFrames.hpp"
+#include "DW1000JangSessions.hpp"
+#include "DW1000JangClocks.hpp"
+#include "DW1000JangCIR.hpp"
+#include "DW1000JangTDoA.hpp"
+#include "DW1000JangScheduler.hpp"
 
 static byte SEQ_NUMBER = 0;
 
+/* Receiver opens this long before the expected response preamble, covers the receiver start up and clock drift */
+constexpr uint16_t RESPONSE_GUARD_US = 20;
+
+/* Last master beacon seen by this device, used to track the master clock rate in downlink TDoA */
+static uint64_t _tdoaMasterTx = 0;
+static uint64_t _tdoaMasterRx = 0;
+static boolean _tdoaMasterSeen = false;
+
+/* Frame wait timeout configured by the application, restored by the next reception that needs it after a response
+   window overrode it. _responseFrameWaitTimeout is the value written for the response window */
+static uint16_t _applicationFrameWaitTimeout = 0;
+static uint16_t _responseFrameWaitTimeout = 0;
+static boolean _frameWaitTimeoutOverridden = false;
+
+/* finalMessageDelay of the tags served by the anchor flows, see setFinalMessageDelay */
+static uint16_t _finalMessageDelay = 0;
+
+/* The last frame could not be loaded into the TX buffer and was not sent, see _transmit */
+static boolean _transmitSkipped = false;
+
+/* receiveFrame listens with the preamble sniff mode, see setSniffListening */
+static boolean _sniffListening = false;
+
+/* Discovery slot of this anchor (0: discovery blinks are not answered) and anchors found by this tag */
+static byte _discoverySlot = 0;
+static uint16_t _discoverySlotDuration = 0;
+static Neighbor _neighbors[DW1000Jang_NEIGHBORS];
+
+using namespace DW1000JangFrames;
+
 namespace DW1000JangRTLS 
 {
 
+    /* Loads the frame and starts its transmission. A frame that could not be loaded is not sent,
+       the following waitForTransmission and waitForResponse return at once */
+    template<typename Layout>
+    static void _transmit(Encoder<Layout>& frame, TransmitMode mode = TransmitMode::IMMEDIATE) {
+        _transmitSkipped = !setTransmitFrame(frame);
+        if(!_transmitSkipped) {
+            DW1000Jang::startTransmit(mode);
+        }
+    }
+
     byte increaseSequenceNumber(){
         return ++SEQ_NUMBER;
     }
 
     void transmitTwrShortBlink() {
-        byte Blink[] = {BLINK, SEQ_NUMBER++, 0,0,0,0,0,0,0,0, NO_BATTERY_STATUS | NO_EX_ID, TAG_LISTENING_NOW};
-        DW1000Jang::getEUI(&Blink[2]);
-        DW1000Jang::setTransmitData(Blink, sizeof(Blink));
-        DW1000Jang::startTransmit();
+        Encoder<Blink> blink(SEQ_NUMBER++);
+        _transmit(blink);
     }
 
     void transmitRangingInitiation(byte tag_eui[], byte tag_short_address[]) {
-        byte RangingInitiation[] = {DATA, SHORT_SRC_LONG_DEST, SEQ_NUMBER++, 0,0, 0,0,0,0,0,0,0,0,  0,0, RANGING_INITIATION, 0,0};
-        DW1000Jang::getNetworkId(&RangingInitiation[3]);
-        memcpy(&RangingInitiation[5], tag_eui, 8);
-        DW1000Jang::getDeviceAddress(&RangingInitiation[13]);
-        memcpy(&RangingInitiation[16], tag_short_address, 2);
-        DW1000Jang::setTransmitData(RangingInitiation, sizeof(RangingInitiation));
-        DW1000Jang::startTransmit();
+        Encoder<RangingInitiation> rangingInitiation(SEQ_NUMBER++, tag_eui);
+        RangingInitiation::TagShortAddress::copy(rangingInitiation.data, tag_short_address);
+        _transmit(rangingInitiation);
     }
 
     void transmitPoll(byte anchor_address[]){
-        byte Poll[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 
-        0,0 , RANGING_TAG_POLL,
-            0,0,0,0,0,0,0,0,0,0,0,0,0,0 };
-
-        DW1000Jang::getNetworkId(&Poll[3]);
-        memcpy(&Poll[5], anchor_address, 2);
-        DW1000Jang::getDeviceAddress(&Poll[7]);
-        DW1000Jang::setTransmitData(Poll, sizeof(Poll));
-        DW1000Jang::startTransmit();
+        Encoder<Poll> poll(SEQ_NUMBER++, anchor_address);
+        _transmit(poll);
     }
 
     void transmitPoll_v2(byte anchor_address[]){
@@ -76,26 +109,212 @@ namespace DW1000JangRTLS
         DW1000Jang::setDelayedTRX(futureTimeBytes);
         timeFinalMessageSent += DW1000Jang::getTxAntennaDelay();
 
-        byte Poll[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 
-        0,0 , RANGING_TAG_POLL,
-            0,0,0,0,0,0,0,0,0,0,0,0,0,0 };
+        Encoder<Poll> poll(SEQ_NUMBER++, anchor_address);
+        _transmit(poll, TransmitMode::DELAYED);
+    }
 
-        DW1000Jang::getNetworkId(&Poll[3]);
-        memcpy(&Poll[5], anchor_address, 2);
-        DW1000Jang::getDeviceAddress(&Poll[7]);
-        DW1000Jang::setTransmitData(Poll, sizeof(Poll));
-        DW1000Jang::startTransmit(TransmitMode::DELAYED);
+    void transmitPollAt(byte anchor_address[], uint64_t pollTime) {
+        byte futureTimeBytes[LENGTH_TIMESTAMP];
+        DW1000JangUtils::writeValueToBytes(futureTimeBytes, pollTime, LENGTH_TIMESTAMP);
+        DW1000Jang::setDelayedTRX(futureTimeBytes);
+
+        Encoder<Poll> poll(SEQ_NUMBER++, anchor_address);
+        _transmit(poll, TransmitMode::DELAYED);
     }
 
-    void transmitResponseToPoll(byte tag_short_address[]) {
-        byte pollAck[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 
-        0,0, ACTIVITY_CONTROL, RANGING_CONTINUE, 0, 0};
+    boolean transmitSuperframeBeacon(uint16_t superframe_number, uint16_t slot_duration, byte slot_count, uint16_t slot_tags[]) {
+        byte broadcast[] = {0xFF, 0xFF};
+        if(slot_count > MAX_SUPERFRAME_SLOTS) {
+            /* the tags past the limit would never get a slot, nothing is sent */
+            _transmitSkipped = true;
+            return false;
+        }
+
+        Encoder<SuperframeBeacon> beacon(SEQ_NUMBER++, broadcast);
+        beacon.set<SuperframeBeacon::SuperframeNumber>(superframe_number);
+        beacon.set<SuperframeBeacon::SlotDuration>(slot_duration);
+        beacon.set<SuperframeBeacon::SlotCount>(slot_count);
+        /* unassigned slots keep the broadcast address */
+        memset(beacon.at<SuperframeBeacon::SlotTags>(), 0xFF, SuperframeBeacon::SlotTags::length());
+        for(byte i = 0; i < slot_count; i++) {
+            DW1000JangUtils::writeValueToBytes(beacon.at<SuperframeBeacon::SlotTags>() + 2*i, slot_tags[i], 2);
+        }
+        _transmit(beacon);
+        return !_transmitSkipped;
+    }
+
+    void transmitTdoaMasterBeacon(byte round, uint16_t tx_delay) {
+        byte broadcast[] = {0xFF, 0xFF};
+        byte futureTimeBytes[LENGTH_TIMESTAMP];
+
+        uint64_t txTime = DW1000Jang::getSystemTimestamp();
+        txTime += DW1000JangTime::microsecondsToUWBTime(tx_delay);
+        /* the 9 least significant bits of DX_TIME are ignored */
+        txTime &= ~static_cast<uint64_t>(0x1FF);
+        DW1000JangUtils::writeValueToBytes(futureTimeBytes, txTime, LENGTH_TIMESTAMP);
+        DW1000Jang::setDelayedTRX(futureTimeBytes);
+        txTime = (txTime + DW1000Jang::getTxAntennaDelay()) % TIME_OVERFLOW;
+
+        Encoder<TdoaBeacon> beacon(SEQ_NUMBER++, broadcast);
+        beacon.set<TdoaBeacon::Round>(round);
+        beacon.set<TdoaBeacon::Slot>(0);
+        beacon.set<TdoaBeacon::TxTime>(txTime);
+        _transmit(beacon, TransmitMode::DELAYED);
+    }
+
+    /* Updates the master clock tracking with a received master beacon, returns true if the rate offset is known */
+    static boolean _trackTdoaMaster(View<TdoaBeacon> beacon, uint64_t timeReceived, double& rateOffset) {
+        uint64_t masterTx = beacon.get<TdoaBeacon::TxTime>();
+        boolean known = _tdoaMasterSeen;
+        if(known) {
+            rateOffset = DW1000JangTDoA::clockRateOffset(_tdoaMasterTx, masterTx, _tdoaMasterRx, timeReceived);
+        }
+        _tdoaMasterTx = masterTx;
+        _tdoaMasterRx = timeReceived;
+        _tdoaMasterSeen = true;
+        return known;
+    }
+
+    TdoaAnchorResult anchorTdoaRound(byte slot, uint16_t slot_duration) {
+        if(!DW1000JangRTLS::receiveFrame()) {
+            return {false, 0, 0};
+        }
+
+        ReceivedFrame frame;
+        frame.read();
+        View<TdoaBeacon> master = frame.as<TdoaBeacon>();
+        if(!master.isValid() || master.get<TdoaBeacon::Slot>() != 0) {
+            return {false, 0, 0};
+        }
+
+        uint64_t timeMasterReceived = DW1000Jang::getReceiveTimestamp();
+        byte round = static_cast<byte>(master.get<TdoaBeacon::Round>());
+        double rateOffset = 0;
+        if(!_trackTdoaMaster(master, timeMasterReceived, rateOffset)) {
+            return {false, round, 0};
+        }
+
+        byte broadcast[] = {0xFF, 0xFF};
+        byte futureTimeBytes[LENGTH_TIMESTAMP];
+        uint64_t txTime = timeMasterReceived + DW1000JangTime::microsecondsToUWBTime(static_cast<uint64_t>(slot) * slot_duration);
+        txTime &= ~static_cast<uint64_t>(0x1FF);
+        DW1000JangUtils::writeValueToBytes(futureTimeBytes, txTime, LENGTH_TIMESTAMP);
+        DW1000Jang::setDelayedTRX(futureTimeBytes);
+
+        int64_t replyTime = static_cast<int64_t>((txTime + DW1000Jang::getTxAntennaDelay() + TIME_OVERFLOW - timeMasterReceived) % TIME_OVERFLOW);
+
+        Encoder<TdoaBeacon> beacon(SEQ_NUMBER++, broadcast);
+        beacon.set<TdoaBeacon::Round>(round);
+        beacon.set<TdoaBeacon::Slot>(slot);
+        beacon.set<TdoaBeacon::ReplyTime>(static_cast<uint64_t>(DW1000JangTDoA::toRemoteDuration(replyTime, rateOffset)));
+        _transmit(beacon, TransmitMode::DELAYED);
+        DW1000JangRTLS::waitForTransmission();
+
+        return {true, round, rateOffset};
+    }
+
+    TdoaRoundResult tagTdoaRound(const DW1000JangTDoA::TdoaAnchor anchors[], uint8_t anchor_count) {
+        TdoaRoundResult result;
+        memset(&result, 0, sizeof(TdoaRoundResult));
+        if(anchor_count > DW1000JangTDoA::MAX_TDOA_ANCHORS) {
+            /* range_difference has no room for the extra anchors, the round fails before listening */
+            return result;
+        }
+
+        /* Round starts with the master beacon */
+        if(!DW1000JangRTLS::receiveFrame()) {
+            return result;
+        }
+        ReceivedFrame frame;
+        frame.read();
+        View<TdoaBeacon> master = frame.as<TdoaBeacon>();
+        if(!master.isValid() || master.get<TdoaBeacon::Slot>() != 0) {
+            return result;
+        }
+
+        uint64_t timeMasterReceived = DW1000Jang::getReceiveTimestamp();
+        result.round = static_cast<byte>(master.get<TdoaBeacon::Round>());
+        double rateOffset = 0;
+        if(!_trackTdoaMaster(master, timeMasterReceived, rateOffset)) {
+            return result;
+        }
+
+        boolean heardAnchor[DW1000JangTDoA::MAX_TDOA_ANCHORS] = {true};
+        uint8_t heard = 1;
+        while(heard < anchor_count && DW1000JangRTLS::receiveFrame()) {
+            frame.read();
+            View<TdoaBeacon> beacon = frame.as<TdoaBeacon>();
+            if(!beacon.isValid() || beacon.get<TdoaBeacon::Round>() != result.round) {
+                continue;
+            }
+            if(beacon.get<TdoaBeacon::Slot>() == 0) {
+                /* master of a later round, ours is over */
+                break;
+            }
+
+            uint16_t source = static_cast<uint16_t>(beacon.get<TdoaBeacon::Source>());
+            for(uint8_t i = 1; i < anchor_count; i++) {
+                if(anchors[i].address != source || heardAnchor[i]) {
+                    continue;
+                }
+                int64_t elapsed = static_cast<int64_t>((DW1000Jang::getReceiveTimestamp() + TIME_OVERFLOW - timeMasterReceived) % TIME_OVERFLOW);
+                int64_t timeDifference = DW1000JangTDoA::toRemoteDuration(elapsed, rateOffset) - static_cast<int64_t>(beacon.get<TdoaBeacon::ReplyTime>());
+
+                /* the master to anchor flight time is part of the measured difference */
+                double dx = anchors[i].x - anchors[0].x;
+                double dy = anchors[i].y - anchors[0].y;
+                result.range_difference[i] = timeDifference * DISTANCE_OF_RADIO - sqrt(dx*dx + dy*dy);
+                heardAnchor[i] = true;
+                heard++;
+                break;
+            }
+        }
+
+        result.count = heard;
+        result.success = heard == anchor_count;
+        return result;
+    }
+
+    UplinkBlinkResult anchorUplinkTdoa(DW1000JangTDoA::ClockSync* sync, double reference_distance) {
+        UplinkBlinkResult result;
+        memset(&result, 0, sizeof(UplinkBlinkResult));
+
+        if(!DW1000JangRTLS::receiveFrame()) {
+            return result;
+        }
+
+        ReceivedFrame frame;
+        frame.read();
+        uint64_t timeReceived = DW1000Jang::getReceiveTimestamp();
+
+        if(frame.is<TdoaBeacon>()) {
+            View<TdoaBeacon> beacon = frame.as<TdoaBeacon>();
+            if(sync != nullptr && beacon.get<TdoaBeacon::Slot>() == 0) {
+                uint64_t flightTime = static_cast<uint64_t>(reference_distance * DISTANCE_OF_RADIO_INV);
+                DW1000JangTDoA::clockSyncUpdate(*sync, beacon.get<TdoaBeacon::TxTime>(), (timeReceived + TIME_OVERFLOW - flightTime) % TIME_OVERFLOW);
+            }
+            return result;
+        }
+
+        if(!frame.is<Blink>()) {
+            return result;
+        }
+        if(sync != nullptr && !sync->initialized) {
+            /* no reference time yet */
+            return result;
+        }
 
-        DW1000Jang::getNetworkId(&pollAck[3]);
-        memcpy(&pollAck[5], tag_short_address, 2);
-        DW1000Jang::getDeviceAddress(&pollAck[7]);
-        DW1000Jang::setTransmitData(pollAck, sizeof(pollAck));
-        DW1000Jang::startTransmit();
+        View<Blink> blink = frame.as<Blink>();
+        memcpy(result.tag_eui, blink.at<Blink::TagEui>(), Blink::TagEui::length());
+        result.sequence = static_cast<byte>(blink.get<Blink::SequenceNumber>());
+        result.reference_time = sync == nullptr ? timeReceived : DW1000JangTDoA::clockSyncToReference(*sync, timeReceived);
+        result.success = true;
+        return result;
+    }
+
+    void transmitResponseToPoll(byte tag_short_address[]) {
+        Encoder<ResponseToPoll> pollAck(SEQ_NUMBER++, tag_short_address);
+        _transmit(pollAck);
     }
 
     uint64_t transmitResponseToPoll_v2(byte anchor_address[], uint16_t reply_delay) {
@@ -108,15 +327,8 @@ namespace DW1000JangRTLS
         DW1000Jang::setDelayedTRX(futureTimeBytes);
         timeFinalMessageSent += DW1000Jang::getTxAntennaDelay();
 
-        byte pollAck[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 
-        0,0, ACTIVITY_CONTROL, RANGING_CONTINUE,
-            0,0,0,0,0,0,0,0,0,0,0,0,0 };
-
-        DW1000Jang::getNetworkId(&pollAck[3]);
-        memcpy(&pollAck[5], anchor_address, 2);
-        DW1000Jang::getDeviceAddress(&pollAck[7]);
-        DW1000Jang::setTransmitData(pollAck, sizeof(pollAck));
-        DW1000Jang::startTransmit(TransmitMode::DELAYED);
+        Encoder<DelayedResponseToPoll> pollAck(SEQ_NUMBER++, anchor_address);
+        _transmit(pollAck, TransmitMode::DELAYED);
 
         return timeFinalMessageSent;
     }
@@ -131,15 +343,8 @@ namespace DW1000JangRTLS
         DW1000Jang::setDelayedTRX(futureTimeBytes);
         timeFinalMessageSent += DW1000Jang::getTxAntennaDelay();
 
-        byte pollAck[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 
-        0,0, ACTIVITY_CONTROL, RANGING_CONTINUE,
-            0,0,0,0,0,0,0,0,0,0,0,0,0 };
-
-        DW1000Jang::getNetworkId(&pollAck[3]);
-        memcpy(&pollAck[5], anchor_address, 2);
-        DW1000Jang::getDeviceAddress(&pollAck[7]);
-        DW1000Jang::setTransmitData(pollAck, sizeof(pollAck));
-        DW1000Jang::startTransmit(TransmitMode::DELAYED);
+        Encoder<DelayedResponseToPoll> pollAck(SEQ_NUMBER++, anchor_address);
+        _transmit(pollAck, TransmitMode::DELAYED);
     }
 
     void transmitFinalMessage(byte anchor_address[], uint16_t reply_delay, uint64_t timePollSent, uint64_t timeResponseToPollReceived) {
@@ -152,19 +357,11 @@ namespace DW1000JangRTLS
         DW1000Jang::setDelayedTRX(futureTimeBytes);
         timeFinalMessageSent += DW1000Jang::getTxAntennaDelay();
 
-        byte finalMessage[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 
-        0,0, RANGING_TAG_FINAL_RESPONSE_EMBEDDED, 
-            0,0,0,0,0,0,0,0,0,0,0,0 };
-
-        DW1000Jang::getNetworkId(&finalMessage[3]);
-        memcpy(&finalMessage[5], anchor_address, 2);
-        DW1000Jang::getDeviceAddress(&finalMessage[7]);
-
-        DW1000JangUtils::writeValueToBytes(finalMessage + 10, (uint32_t) timePollSent, 4);
-        DW1000JangUtils::writeValueToBytes(finalMessage + 14, (uint32_t) timeResponseToPollReceived, 4);
-        DW1000JangUtils::writeValueToBytes(finalMessage + 18, (uint32_t) timeFinalMessageSent, 4);
-        DW1000Jang::setTransmitData(finalMessage, sizeof(finalMessage));
-        DW1000Jang::startTransmit(TransmitMode::DELAYED);
+        Encoder<FinalMessage> finalMessage(SEQ_NUMBER++, anchor_address);
+        finalMessage.set<FinalMessage::PollSent>(timePollSent);
+        finalMessage.set<FinalMessage::ResponseReceived>(timeResponseToPollReceived);
+        finalMessage.set<FinalMessage::FinalSent>(timeFinalMessageSent);
+        _transmit(finalMessage, TransmitMode::DELAYED);
     }
 
     // Final Message를 보낼 때 Response Message를 수신한 timestamp를 기준으로 delay를 잡는 함수
@@ -178,20 +375,12 @@ namespace DW1000JangRTLS
         DW1000Jang::setDelayedTRX(futureTimeBytes);
         timeFinalMessageSent += DW1000Jang::getTxAntennaDelay();
 
-        byte finalMessage[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 
-        0,0, RANGING_TAG_FINAL_RESPONSE_EMBEDDED, 
-            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 };
-
-        DW1000Jang::getNetworkId(&finalMessage[3]);
-        memcpy(&finalMessage[5], anchor_address, 2);
-        DW1000Jang::getDeviceAddress(&finalMessage[7]);
-
-        DW1000JangUtils::writeValueToBytes(finalMessage + 10, (uint32_t) timePollSent, 4);
-        DW1000JangUtils::writeValueToBytes(finalMessage + 14, (uint32_t) timeResponseToPollReceived, 4);
-        DW1000JangUtils::writeValueToBytes(finalMessage + 18, (uint32_t) timeFinalMessageSent, 4);
-        DW1000JangUtils::writeValueToBytes(finalMessage + 22, static_cast<uint32_t>(phaseResponse * 1000), 4);
-        DW1000Jang::setTransmitData(finalMessage, sizeof(finalMessage));
-        DW1000Jang::startTransmit(TransmitMode::DELAYED);
+        Encoder<PhaseFinalMessage> finalMessage(SEQ_NUMBER++, anchor_address);
+        finalMessage.set<PhaseFinalMessage::PollSent>(timePollSent);
+        finalMessage.set<PhaseFinalMessage::ResponseReceived>(timeResponseToPollReceived);
+        finalMessage.set<PhaseFinalMessage::FinalSent>(timeFinalMessageSent);
+        finalMessage.set<PhaseFinalMessage::PhaseResponse>(static_cast<uint32_t>(phaseResponse * 1000));
+        _transmit(finalMessage, TransmitMode::DELAYED);
     }
 
     // Final Message를 보낼 때 현재 timestamp를 기준으로 delay를 잡는 함수
@@ -205,20 +394,12 @@ namespace DW1000JangRTLS
         DW1000Jang::setDelayedTRX(futureTimeBytes);
         timeFinalMessageSent += DW1000Jang::getTxAntennaDelay();
 
-        byte finalMessage[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 
-        0,0, RANGING_TAG_FINAL_RESPONSE_EMBEDDED, 
-            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 };
-
-        DW1000Jang::getNetworkId(&finalMessage[3]);
-        memcpy(&finalMessage[5], anchor_address, 2);
-        DW1000Jang::getDeviceAddress(&finalMessage[7]);
-
-        DW1000JangUtils::writeValueToBytes(finalMessage + 10, (uint32_t) timePollSent, 4);
-        DW1000JangUtils::writeValueToBytes(finalMessage + 14, (uint32_t) timeResponseToPollReceived, 4);
-        DW1000JangUtils::writeValueToBytes(finalMessage + 18, (uint32_t) timeFinalMessageSent, 4);
-        DW1000JangUtils::writeValueToBytes(finalMessage + 22, static_cast<uint32_t>(phaseResponse * 1000), 4);
-        DW1000Jang::setTransmitData(finalMessage, sizeof(finalMessage));
-        DW1000Jang::startTransmit(TransmitMode::DELAYED);
+        Encoder<PhaseFinalMessage> finalMessage(SEQ_NUMBER++, anchor_address);
+        finalMessage.set<PhaseFinalMessage::PollSent>(timePollSent);
+        finalMessage.set<PhaseFinalMessage::ResponseReceived>(timeResponseToPollReceived);
+        finalMessage.set<PhaseFinalMessage::FinalSent>(timeFinalMessageSent);
+        finalMessage.set<PhaseFinalMessage::PhaseResponse>(static_cast<uint32_t>(phaseResponse * 1000));
+        _transmit(finalMessage, TransmitMode::DELAYED);
     }
 
     // PostFinal Message를 보낼 때 Final Message를 송신한 timestamp를 기준으로 delay를 잡는 함수
@@ -232,15 +413,8 @@ namespace DW1000JangRTLS
         DW1000Jang::setDelayedTRX(futureTimeBytes);
         timeFinalMessageSent += DW1000Jang::getTxAntennaDelay();
 
-        byte finalMessage[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 
-        0,0, RANGING_TAG_POST_FINAL_RESPONSE_EMBEDDED, 
-            0,0,0,0,0,0,0,0,0,0,0,0,0,0 };
-
-        DW1000Jang::getNetworkId(&finalMessage[3]);
-        memcpy(&finalMessage[5], anchor_address, 2);
-        DW1000Jang::getDeviceAddress(&finalMessage[7]);
-        DW1000Jang::setTransmitData(finalMessage, sizeof(finalMessage));
-        DW1000Jang::startTransmit(TransmitMode::DELAYED);
+        Encoder<PostFinal> postFinalMessage(SEQ_NUMBER++, anchor_address);
+        _transmit(postFinalMessage, TransmitMode::DELAYED);
     }
 
     // PostFinal Message를 보낼 때 현재 timestamp를 기준으로 delay를 잡는 함수
@@ -254,46 +428,45 @@ namespace DW1000JangRTLS
         DW1000Jang::setDelayedTRX(futureTimeBytes);
         timeFinalMessageSent += DW1000Jang::getTxAntennaDelay();
 
-        byte finalMessage[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 
-        0,0, RANGING_TAG_POST_FINAL_RESPONSE_EMBEDDED, 
-            0,0,0,0,0,0,0,0,0,0,0,0,0,0 };
-
-        DW1000Jang::getNetworkId(&finalMessage[3]);
-        memcpy(&finalMessage[5], anchor_address, 2);
-        DW1000Jang::getDeviceAddress(&finalMessage[7]);
-        DW1000Jang::setTransmitData(finalMessage, sizeof(finalMessage));
-        DW1000Jang::startTransmit(TransmitMode::DELAYED);
+        Encoder<PostFinal> postFinalMessage(SEQ_NUMBER++, anchor_address);
+        _transmit(postFinalMessage, TransmitMode::DELAYED);
     }
 
     void transmitRangingConfirm(byte tag_short_address[], byte next_anchor[]) {
-        byte rangingConfirm[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 
-        0,0, ACTIVITY_CONTROL, RANGING_CONFIRM, next_anchor[0], next_anchor[1]};
-        
-        DW1000Jang::getNetworkId(&rangingConfirm[3]);
-        memcpy(&rangingConfirm[5], tag_short_address, 2);
-        DW1000Jang::getDeviceAddress(&rangingConfirm[7]);
-        DW1000Jang::setTransmitData(rangingConfirm, sizeof(rangingConfirm));
-        DW1000Jang::startTransmit();
+        Encoder<RangingConfirm> rangingConfirm(SEQ_NUMBER++, tag_short_address);
+        RangingConfirm::NextAnchor::copy(rangingConfirm.data, next_anchor);
+        _transmit(rangingConfirm);
     }
 
     void transmitRangingConfirm_v1(byte tag_short_address[], double distance) {
-        byte rangingConfirm[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 0,0, ACTIVITY_CONTROL, RANGING_CONFIRM, 0, 0, 0, 0};
-        DW1000Jang::getNetworkId(&rangingConfirm[3]);
-        memcpy(&rangingConfirm[5], tag_short_address, 2);
-        DW1000Jang::getDeviceAddress(&rangingConfirm[7]);
-        DW1000JangUtils::writeValueToBytes(&rangingConfirm[13], static_cast<uint16_t>((distance*1000)), 2);
-        DW1000Jang::setTransmitData(rangingConfirm, sizeof(rangingConfirm));
-        DW1000Jang::startTransmit();
+        Encoder<RangeReport> rangingConfirm(SEQ_NUMBER++, tag_short_address);
+        rangingConfirm.set<RangeReport::Range>(static_cast<uint16_t>((distance*1000)));
+        _transmit(rangingConfirm);
     }
 
     void transmitRangingConfirm_v2(byte tag_short_address[], byte next_anchor[], double distance) {
-        byte rangingConfirm[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 0,0, ACTIVITY_CONTROL, RANGING_CONFIRM, next_anchor[0], next_anchor[1],0,0};
-        DW1000Jang::getNetworkId(&rangingConfirm[3]);
-        memcpy(&rangingConfirm[5], tag_short_address, 2);
-        DW1000Jang::getDeviceAddress(&rangingConfirm[7]);
-        DW1000JangUtils::writeValueToBytes(&rangingConfirm[13], static_cast<uint16_t>((distance*1000)), 2);
-        DW1000Jang::setTransmitData(rangingConfirm, sizeof(rangingConfirm));
-        DW1000Jang::startTransmit();
+        Encoder<RangeReport> rangingConfirm(SEQ_NUMBER++, tag_short_address);
+        RangeReport::NextAnchor::copy(rangingConfirm.data, next_anchor);
+        rangingConfirm.set<RangeReport::Range>(static_cast<uint16_t>((distance*1000)));
+        _transmit(rangingConfirm);
+    }
+
+    void transmitPhaseRangeReport(byte tag_short_address[], byte next_anchor[], double distance, double phase) {
+        Encoder<PhaseRangeReport> rangingConfirm(SEQ_NUMBER++, tag_short_address);
+        PhaseRangeReport::NextAnchor::copy(rangingConfirm.data, next_anchor);
+        rangingConfirm.set<PhaseRangeReport::Range>(static_cast<uint16_t>((distance*1000)));
+        rangingConfirm.set<PhaseRangeReport::Phase>(static_cast<uint16_t>(phase * 1000));
+        _transmit(rangingConfirm);
+    }
+
+    void transmitClassifiedRangeReport(byte tag_short_address[], byte next_anchor[], double distance, double phase, boolean nlos, double bias) {
+        Encoder<ClassifiedRangeReport> rangingConfirm(SEQ_NUMBER++, tag_short_address);
+        ClassifiedRangeReport::NextAnchor::copy(rangingConfirm.data, next_anchor);
+        rangingConfirm.set<ClassifiedRangeReport::Range>(static_cast<uint16_t>((distance*1000)));
+        rangingConfirm.set<ClassifiedRangeReport::Phase>(static_cast<uint16_t>(phase * 1000));
+        rangingConfirm.set<ClassifiedRangeReport::Nlos>(nlos ? 1 : 0);
+        rangingConfirm.set<ClassifiedRangeReport::Bias>(bias < 65.535 ? static_cast<uint16_t>(bias * 1000) : 0xFFFF);
+        _transmit(rangingConfirm);
     }
 
     void transmitRangingConfirm_v3(byte tag_short_address[], double distance) {
@@ -304,40 +477,31 @@ namespace DW1000JangRTLS
 	    timeFinalMessageSent += DW1000JangTime::microsecondsToUWBTime(3000);
         DW1000JangUtils::writeValueToBytes(futureTimeBytes, timeFinalMessageSent, LENGTH_TIMESTAMP);
         DW1000Jang::setDelayedTRX(futureTimeBytes);
-        byte rangingConfirm[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 0,0, 0,0, ACTIVITY_CONTROL, RANGING_CONFIRM,0,0,0,0};
-        DW1000Jang::getNetworkId(&rangingConfirm[3]);
-        memcpy(&rangingConfirm[5], tag_short_address, 2);
-        DW1000Jang::getDeviceAddress(&rangingConfirm[7]);
-        DW1000JangUtils::writeValueToBytes(&rangingConfirm[13], static_cast<uint16_t>((distance*1000)), 2);
-        DW1000Jang::setTransmitData(rangingConfirm, sizeof(rangingConfirm));
-        DW1000Jang::startTransmit(TransmitMode::DELAYED);
+        Encoder<RangeReport> rangingConfirm(SEQ_NUMBER++, tag_short_address);
+        rangingConfirm.set<RangeReport::Range>(static_cast<uint16_t>((distance*1000)));
+        _transmit(rangingConfirm, TransmitMode::DELAYED);
     }
 
 
     void transmitActivityFinished(byte tag_short_address[], byte blink_rate[]) {
         /* I send the new blink rate to the tag */
-        byte rangingConfirm[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 0,0, ACTIVITY_CONTROL, ACTIVITY_FINISHED, blink_rate[0], blink_rate[1],0,0};
-        DW1000Jang::getNetworkId(&rangingConfirm[3]);
-        memcpy(&rangingConfirm[5], tag_short_address, 2);
-        DW1000Jang::getDeviceAddress(&rangingConfirm[7]);
-        DW1000Jang::setTransmitData(rangingConfirm, sizeof(rangingConfirm));
-        DW1000Jang::startTransmit();
+        Encoder<ActivityFinished> activityFinished(SEQ_NUMBER++, tag_short_address);
+        ActivityFinished::BlinkRate::copy(activityFinished.data, blink_rate);
+        _transmit(activityFinished);
     }
 
     void transmitActivityFinished_v2(byte tag_short_address[], byte blink_rate[], double distance) {
         /* I send the new blink rate to the tag */
-        byte rangingConfirm[] = {DATA, SHORT_SRC_AND_DEST, SEQ_NUMBER++, 0,0, 0,0, 0,0, ACTIVITY_CONTROL, ACTIVITY_FINISHED, blink_rate[0], blink_rate[1],0,0};
-        DW1000Jang::getNetworkId(&rangingConfirm[3]);
-        memcpy(&rangingConfirm[5], tag_short_address, 2);
-        DW1000Jang::getDeviceAddress(&rangingConfirm[7]);
-        DW1000JangUtils::writeValueToBytes(&rangingConfirm[13], static_cast<uint16_t>((distance*1000)), 2);
-        DW1000Jang::setTransmitData(rangingConfirm, sizeof(rangingConfirm));
-        DW1000Jang::startTransmit();
-    }
-
-    static uint32_t calculateNewBlinkRate(byte frame[]) {
-        uint32_t blinkRate = frame[11] + static_cast<uint32_t>(((frame[12] & 0x3F) << 8));
-        byte multiplier = ((frame[12] & 0xC0) >> 6);
+        Encoder<ActivityFinished> activityFinished(SEQ_NUMBER++, tag_short_address);
+        ActivityFinished::BlinkRate::copy(activityFinished.data, blink_rate);
+        activityFinished.set<ActivityFinished::Range>(static_cast<uint16_t>((distance*1000)));
+        _transmit(activityFinished);
+    }
+
+    static uint32_t calculateNewBlinkRate(View<ActivityFinished> frame) {
+        uint16_t blinkRateField = static_cast<uint16_t>(frame.get<ActivityFinished::BlinkRate>());
+        uint32_t blinkRate = blinkRateField & 0x3FFF;
+        byte multiplier = ((blinkRateField & 0xC000) >> 14);
         if(multiplier  == 0x01) {
             blinkRate *= 25;
         } else if(multiplier == 0x02) {
@@ -347,16 +511,59 @@ namespace DW1000JangRTLS
         return blinkRate;
     }
 
-    void waitForTransmission() {
+    /* false if the last frame was not sent, see _transmit */
+    static boolean _awaitTransmission() {
+        if(_transmitSkipped) {
+            _transmitSkipped = false;
+            return false;
+        }
         while(!DW1000Jang::isTransmitDone()) {
             #if defined(ESP8266)
             yield();
             #endif
         }
         DW1000Jang::clearTransmitStatus();
+        return true;
+    }
+
+    void waitForTransmission() {
+        _awaitTransmission();
+    }
+
+    /* Response windows and scheduled receptions keep the receiver fully on */
+    static void _stopSniffing() {
+        if(_sniffListening) {
+            DW1000Jang::disableSniffMode();
+        }
+    }
+
+    boolean setSniffListening(boolean enable) {
+        _sniffListening = enable;
+        if(!enable) {
+            DW1000Jang::disableSniffMode();
+            return true;
+        }
+        return DW1000Jang::enableSniffMode();
+    }
+
+    /* Gives the frame wait timeout back to the application, a no-op unless a response window overrode it */
+    static void _restoreFrameWaitTimeout() {
+        if(!_frameWaitTimeoutOverridden) {
+            return;
+        }
+        _frameWaitTimeoutOverridden = false;
+        /* the application set its own timeout since */
+        if(DW1000Jang::getReceiveFrameWaitTimeoutPeriod() != _responseFrameWaitTimeout) {
+            return;
+        }
+        DW1000Jang::setReceiveFrameWaitTimeoutPeriod(_applicationFrameWaitTimeout);
     }
 
     boolean receiveFrame() {
+        _restoreFrameWaitTimeout();
+        if(_sniffListening) {
+            DW1000Jang::enableSniffMode();
+        }
         DW1000Jang::startReceive(ReceiveMode::IMMEDIATE);
         while(!DW1000Jang::isReceiveDone()) {
             if(DW1000Jang::isReceiveTimeout() ) {
@@ -379,6 +586,8 @@ namespace DW1000JangRTLS
         DW1000JangUtils::writeValueToBytes(futureTimeBytes, time, LENGTH_TIMESTAMP);
         DW1000Jang::setDelayedTRX(futureTimeBytes);
 
+        _restoreFrameWaitTimeout();
+        _stopSniffing();
         DW1000Jang::startReceive(ReceiveMode::DELAYED);
         while(!DW1000Jang::isReceiveDone()) {
             if(DW1000Jang::isReceiveTimeout() ) {
@@ -401,6 +610,8 @@ namespace DW1000JangRTLS
         DW1000JangUtils::writeValueToBytes(futureTimeBytes, time, LENGTH_TIMESTAMP);
         DW1000Jang::setDelayedTRX(futureTimeBytes);
 
+        _restoreFrameWaitTimeout();
+        _stopSniffing();
         DW1000Jang::startReceive(ReceiveMode::DELAYED);
         while(!DW1000Jang::isReceiveDone()) {
             if(DW1000Jang::isReceiveTimeout() ) {
@@ -424,6 +635,8 @@ namespace DW1000JangRTLS
         DW1000JangUtils::writeValueToBytes(futureTimeBytes, time, LENGTH_TIMESTAMP);
         DW1000Jang::setDelayedTRX(futureTimeBytes);
 
+        _restoreFrameWaitTimeout();
+        _stopSniffing();
         DW1000Jang::startReceive(ReceiveMode::DELAYED);
         while(!DW1000Jang::isReceiveDone()) {
             if(DW1000Jang::isReceiveTimeout() ) {
@@ -438,39 +651,120 @@ namespace DW1000JangRTLS
         return true;
     }
 
-    static boolean waitForNextRangingStep() {
-        DW1000JangRTLS::waitForTransmission();
+    static uint16_t _onAirLength(uint16_t length) {
+        return DW1000Jang::isFrameCheckEnabled() ? length + 2 : length;
+    }
+
+    void expectResponse(uint16_t txLength, uint16_t replyDelay, uint16_t responseLength, uint16_t replyJitter) {
+        _stopSniffing();
+        if(replyDelay == 0) {
+            /* W4R_TIM of 0 would disable the turnaround, 1 unit is the shortest delay */
+            DW1000Jang::setWait4Response(1);
+            _restoreFrameWaitTimeout();
+            return;
+        }
+
+        DataRate rate = DW1000Jang::getDataRate();
+        uint32_t responsePreamble = DW1000JangTime::preambleDurationMicroseconds(rate, DW1000Jang::getPulseFrequency(), DW1000Jang::getPreambleLength());
+        uint32_t txTail = DW1000JangTime::payloadDurationMicroseconds(rate, _onAirLength(txLength));
+        uint32_t responseAirtime = responsePreamble + DW1000JangTime::payloadDurationMicroseconds(rate, _onAirLength(responseLength));
+
+        /* W4R_TIM counts from the end of the transmitted frame */
+        uint32_t rxDelay = txTail + responsePreamble + RESPONSE_GUARD_US;
+        rxDelay = replyDelay > rxDelay ? replyDelay - rxDelay : 0;
+        DW1000Jang::setWait4Response(DW1000JangTime::microsecondsToUUS(rxDelay) + 1);
+
+        uint32_t timeout = DW1000JangTime::microsecondsToUUS(responseAirtime + 2*RESPONSE_GUARD_US + replyJitter);
+        uint16_t current = DW1000Jang::getReceiveFrameWaitTimeoutPeriod();
+        if(!_frameWaitTimeoutOverridden || current != _responseFrameWaitTimeout) {
+            _applicationFrameWaitTimeout = current;
+            _frameWaitTimeoutOverridden = true;
+        }
+        _responseFrameWaitTimeout = timeout > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(timeout);
+        if(current != _responseFrameWaitTimeout) {
+            DW1000Jang::setReceiveFrameWaitTimeoutPeriod(_responseFrameWaitTimeout);
+        }
+    }
+
+    void setFinalMessageDelay(uint16_t finalMessageDelay) {
+        _finalMessageDelay = finalMessageDelay;
+    }
+
+    /* Disarms the response window of expectResponse for the following transmissions without any register write,
+       the overridden frame wait timeout stays until a reception needs another one (see _restoreFrameWaitTimeout) */
+    static void _disarmResponse() {
+        DW1000Jang::setWait4Response(0);
+    }
+
+    /* Cancels a delayed transmission started after its time, see DW1000Jang::isDelayedStartLate */
+    static boolean _cancelLateTransmission() {
+        if(!DW1000Jang::isDelayedStartLate()) {
+            return false;
+        }
+        DW1000Jang::forceTRxOff();
+        DW1000Jang::clearTransmitStatus();
+        _disarmResponse();
+        return true;
+    }
+
+    boolean waitForResponse() {
+        if(!_awaitTransmission()) {
+            _disarmResponse();
+            return false;
+        }
+        boolean received = true;
+        while(!DW1000Jang::isReceiveDone()) {
+            if(DW1000Jang::isReceiveTimeout() ) {
+                DW1000Jang::clearReceiveTimeoutStatus();
+                received = false;
+                break;
+            }
+            #if defined(ESP8266)
+            yield();
+            #endif
+        }
+        if(received) {
+            DW1000Jang::clearReceiveStatus();
+        }
+
+        _disarmResponse();
+        return received;
+    }
+
+    boolean waitForNextRangingStep() {
+        if(!_awaitTransmission()) return false;
         if(!DW1000JangRTLS::receiveFrame()) return false;
         return true;
     }
 
-    static boolean waitForNextRangingStep_v2(uint64_t timeDelay) {
-        DW1000JangRTLS::waitForTransmission();
+    boolean waitForNextRangingStep_v2(uint64_t timeDelay) {
+        if(!_awaitTransmission()) return false;
         if(!DW1000JangRTLS::receiveFrame_v2(timeDelay)) return false;
         return true;
     }
 
     static boolean waitForNextRangingStep2() {
-        DW1000JangRTLS::waitForTransmission();
+        if(!_awaitTransmission()) return false;
         if(!DW1000JangRTLS::receiveFrame2()) return false;
         return true;
     }
 
     RangeRequestResult tagRangeRequest() {
+        DW1000JangRTLS::expectResponse(Blink::length(), 0, RangingInitiation::length());
         DW1000JangRTLS::transmitTwrShortBlink();
         
-        if(!DW1000JangRTLS::waitForNextRangingStep()) return {false, 0};
+        if(!DW1000JangRTLS::waitForResponse()) return {false, 0};
 
-        size_t init_len = DW1000Jang::getReceivedDataLength();
-        byte init_recv[init_len];
-        DW1000Jang::getReceivedData(init_recv, init_len);
+        ReceivedFrame frame;
+        frame.read();
+        View<RangingInitiation> init_recv = frame.as<RangingInitiation>();
 
-        if(!(init_len > 17 && init_recv[15] == RANGING_INITIATION)) {
+        if(!init_recv.isValid()) {
             return { false, 0};
         }
 
-        DW1000Jang::setDeviceAddress(DW1000JangUtils::bytesAsValue(&init_recv[16], 2));
-        return { true, static_cast<uint16_t>(DW1000JangUtils::bytesAsValue(&init_recv[13], 2)) };
+        DW1000Jang::setDeviceAddress(init_recv.get<RangingInitiation::TagShortAddress>());
+        return { true, static_cast<uint16_t>(init_recv.get<RangingInitiation::Source>()) };
     }
 
     RangeAcceptResult anchorRangeAccept(NextActivity next, uint16_t value)
@@ -482,44 +776,42 @@ namespace DW1000JangRTLS
             returnValue = {false, 0};
         } else {
 
-            size_t poll_len = DW1000Jang::getReceivedDataLength();
-            byte poll_data[poll_len];
-            DW1000Jang::getReceivedData(poll_data, poll_len);
+            ReceivedFrame poll;
+            poll.read();
 
-            if(poll_len > 9 && poll_data[9] == RANGING_TAG_POLL) {
+            if(poll.is<Poll>()) {
                 uint64_t timePollReceived = DW1000Jang::getReceiveTimestamp();
-                DW1000JangRTLS::transmitResponseToPoll(&poll_data[7]);
-                DW1000JangRTLS::waitForTransmission();
-                uint64_t timeResponseToPoll = DW1000Jang::getTransmitTimestamp();
-                delayMicroseconds(1500);
+                DW1000JangRTLS::expectResponse(ResponseToPoll::length(), _finalMessageDelay, FinalMessage::length(), REPLY_PROCESSING_US);
+                DW1000JangRTLS::transmitResponseToPoll(poll.as<Poll>().at<Poll::Source>());
 
-                if(!DW1000JangRTLS::receiveFrame()) {
+                if(!DW1000JangRTLS::waitForResponse()) {
                     returnValue = {false, 0};
                 } else {
 
-                    size_t rfinal_len = DW1000Jang::getReceivedDataLength();
-                    byte rfinal_data[rfinal_len];
-                    DW1000Jang::getReceivedData(rfinal_data, rfinal_len);
-                    if(rfinal_len > 18 && rfinal_data[9] == RANGING_TAG_FINAL_RESPONSE_EMBEDDED) {
+                    ReceivedFrame frame;
+                    frame.read();
+                    View<FinalMessage> rfinal_data = frame.as<FinalMessage>();
+                    if(rfinal_data.isValid()) {
+                        uint64_t timeResponseToPoll = DW1000Jang::getTransmitTimestamp();
                         uint64_t timeFinalMessageReceive = DW1000Jang::getReceiveTimestamp();
 
                         byte finishValue[2];
                         DW1000JangUtils::writeValueToBytes(finishValue, value, 2);
 
                         if(next == NextActivity::RANGING_CONFIRM) {
-                            DW1000JangRTLS::transmitRangingConfirm(&rfinal_data[7], finishValue);
+                            DW1000JangRTLS::transmitRangingConfirm(rfinal_data.at<FinalMessage::Source>(), finishValue);
                         } else {
-                            DW1000JangRTLS::transmitActivityFinished(&rfinal_data[7], finishValue);
+                            DW1000JangRTLS::transmitActivityFinished(rfinal_data.at<FinalMessage::Source>(), finishValue);
                         }
                         
                         DW1000JangRTLS::waitForTransmission();
 
                         range = DW1000JangRanging::computeRangeAsymmetric(
-                            DW1000JangUtils::bytesAsValue(rfinal_data + 10, LENGTH_TIMESTAMP), // Poll send time
+                            rfinal_data.get<FinalMessage::PollSent>(), // Poll send time
                             timePollReceived, 
                             timeResponseToPoll, // Response to poll sent time
-                            DW1000JangUtils::bytesAsValue(rfinal_data + 14, LENGTH_TIMESTAMP), // Response to Poll Received
-                            DW1000JangUtils::bytesAsValue(rfinal_data + 18, LENGTH_TIMESTAMP), // Final Message send time
+                            rfinal_data.get<FinalMessage::ResponseReceived>(), // Response to Poll Received
+                            rfinal_data.get<FinalMessage::FinalSent>(), // Final Message send time
                             timeFinalMessageReceive // Final message receive time
                         );
 
@@ -538,45 +830,93 @@ namespace DW1000JangRTLS
         return returnValue;
     }
 
+    SuperframeSlot tagWaitForSuperframe() {
+        if(!DW1000JangRTLS::receiveFrame()) {
+            return {false, 0, 0, 0, 0};
+        }
+
+        ReceivedFrame frame;
+        frame.read();
+        View<SuperframeBeacon> beacon = frame.as<SuperframeBeacon>();
+        if(!beacon.isValid()) {
+            return {false, 0, 0, 0, 0};
+        }
+
+        uint64_t timeBeaconReceived = DW1000Jang::getReceiveTimestamp();
+        uint16_t superframe_number = static_cast<uint16_t>(beacon.get<SuperframeBeacon::SuperframeNumber>());
+        uint16_t slot_duration = static_cast<uint16_t>(beacon.get<SuperframeBeacon::SlotDuration>());
+        byte slot_count = static_cast<byte>(beacon.get<SuperframeBeacon::SlotCount>());
+        if(slot_count > MAX_SUPERFRAME_SLOTS) {
+            slot_count = MAX_SUPERFRAME_SLOTS;
+        }
+
+        byte address[2];
+        DW1000Jang::getDeviceAddress(address);
+        uint16_t own_address = static_cast<uint16_t>(DW1000JangUtils::bytesAsValue(address, 2));
+
+        byte slot = 0;
+        for(byte i = 0; i < slot_count; i++) {
+            if(DW1000JangUtils::bytesAsValue(beacon.at<SuperframeBeacon::SlotTags>() + 2*i, 2) == own_address) {
+                slot = i + 1;
+                break;
+            }
+        }
+        if(slot == 0) {
+            return {false, superframe_number, 0, 0, slot_duration};
+        }
+
+        /* Slot starts are counted from the beacon RMARKER, in the tag's own system time */
+        uint64_t slot_offset = DW1000JangTime::microsecondsToUWBTime(static_cast<uint64_t>(slot) * slot_duration);
+        uint64_t slot_start = (timeBeaconReceived + slot_offset) % TIME_OVERFLOW;
+
+        /* A delayed transmission in the past would wait for the 17 s clock wrap */
+        uint64_t lead = (slot_start + TIME_OVERFLOW - DW1000Jang::getSystemTimestamp()) % TIME_OVERFLOW;
+        if(lead < DW1000JangTime::microsecondsToUWBTime(SLOT_SCHEDULE_MARGIN_US) || lead > slot_offset) {
+            return {false, superframe_number, slot, slot_start, slot_duration};
+        }
+
+        return {true, superframe_number, slot, slot_start, slot_duration};
+    }
+
     static RangeResult tagFinishRange(uint16_t anchor, uint16_t replyDelayUs) 
     {
         RangeResult returnValue;
 
         byte target_anchor[2];
         DW1000JangUtils::writeValueToBytes(target_anchor, anchor, 2);
+        DW1000JangRTLS::expectResponse(Poll::length(), 0, ResponseToPoll::length());
         DW1000JangRTLS::transmitPoll(target_anchor);
         /* Start of poll control for range */
-        if(!DW1000JangRTLS::waitForNextRangingStep()) 
+        if(!DW1000JangRTLS::waitForResponse()) 
         {   returnValue = {false, false, 0, 0}; } 
         else 
         {
-            size_t cont_len = DW1000Jang::getReceivedDataLength();
-            byte cont_recv[cont_len];
-            DW1000Jang::getReceivedData(cont_recv, cont_len);
+            ReceivedFrame frame;
+            frame.read();
+            View<ResponseToPoll> cont_recv = frame.as<ResponseToPoll>();
 
-            if (cont_len > 10 && cont_recv[9] == ACTIVITY_CONTROL && cont_recv[10] == RANGING_CONTINUE) {
+            if (cont_recv.isValid()) {
                 /* Received Response to poll */
+                DW1000JangRTLS::expectResponse(FinalMessage::length(), 0, RangeReport::length());
                 DW1000JangRTLS::transmitFinalMessage(
-                    &cont_recv[7], 
+                    cont_recv.at<ResponseToPoll::Source>(), 
                     replyDelayUs, 
                     DW1000Jang::getTransmitTimestamp(), // Poll transmit time
                     DW1000Jang::getReceiveTimestamp()  // Response to poll receive time
                 );
 
-                if(!DW1000JangRTLS::waitForNextRangingStep()) 
+                if(!DW1000JangRTLS::waitForResponse()) 
                 {   returnValue = {false, false, 0, 0}; } 
                 else 
                 {
-                    size_t act_len = DW1000Jang::getReceivedDataLength();
-                    byte act_recv[act_len];
-                    DW1000Jang::getReceivedData(act_recv, act_len);
+                    frame.read();
 
-                    if(act_len > 10 && act_recv[9] == ACTIVITY_CONTROL) {
-                        if (act_len > 12 && act_recv[10] == RANGING_CONFIRM) {
-                            returnValue = {true, true, static_cast<uint16_t>(DW1000JangUtils::bytesAsValue(&act_recv[11], 2)), 0};
+                    if(frame.is<ActivityControl>()) {
+                        if (frame.is<RangingConfirm>()) {
+                            returnValue = {true, true, static_cast<uint16_t>(frame.as<RangingConfirm>().get<RangingConfirm::NextAnchor>()), 0};
                         } 
-                        else if(act_len > 12 && act_recv[10] == ACTIVITY_FINISHED) {
-                            returnValue = {true, false, 0, calculateNewBlinkRate(act_recv)};
+                        else if(frame.is<ActivityFinished>()) {
+                            returnValue = {true, false, 0, calculateNewBlinkRate(frame.as<ActivityFinished>())};
                         }
                     } 
                     else {
@@ -623,7 +963,7 @@ namespace DW1000JangRTLS
             if(result.success && result.new_blink_rate != 0) 
             {
                 keep_going = 0;
-                returnValue = { true, static_cast<uint16_t>(result.new_blink_rate)};
+                returnValue = { true, result.new_blink_rate};
             } 
             else 
             {
@@ -653,6 +993,157 @@ namespace DW1000JangRTLS
         return {false, 0};
     }
 
+    void setDiscoverySlot(byte slot, uint16_t slot_duration) {
+        _discoverySlot = slot;
+        _discoverySlotDuration = slot_duration;
+    }
+
+    static void _updateNeighbor(uint16_t address, float rxPower, uint32_t now) {
+        Neighbor* slot = nullptr;
+        for(uint8_t i = 0; i < DW1000Jang_NEIGHBORS; i++) {
+            Neighbor* neighbor = &_neighbors[i];
+            if(neighbor->active && neighbor->address == address) {
+                slot = neighbor;
+                break;
+            }
+            if(slot == nullptr || (slot->active && (!neighbor->active || static_cast<int32_t>(neighbor->last_seen - slot->last_seen) < 0))) {
+                slot = neighbor;
+            }
+        }
+        slot->address = address;
+        slot->rx_power = rxPower;
+        slot->last_seen = now;
+        slot->active = true;
+    }
+
+    DiscoveryResult tagDiscoverAnchors(byte slots, uint16_t slot_duration) {
+        DiscoveryResult result = {false, 0};
+
+        Encoder<Blink> blink(SEQ_NUMBER++);
+        blink.set<Blink::ExtHeader>(DISCOVERY_REQUEST);
+        _transmit(blink);
+        DW1000JangRTLS::waitForTransmission();
+
+        /* the frame wait timeout is set to what is left of the window before each reception */
+        uint16_t applicationTimeout = DW1000Jang::getReceiveFrameWaitTimeoutPeriod();
+        uint32_t window = static_cast<uint32_t>(slots + 1) * slot_duration;
+        uint32_t start = micros();
+        ReceivedFrame frame;
+        while(true) {
+            uint32_t elapsed = micros() - start;
+            if(elapsed >= window) {
+                break;
+            }
+            uint32_t timeout = DW1000JangTime::microsecondsToUUS(window - elapsed) + 1;
+            DW1000Jang::setReceiveFrameWaitTimeoutPeriod(timeout > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(timeout));
+            if(!DW1000JangRTLS::receiveFrame()) {
+                continue;
+            }
+            frame.read();
+            View<RangingInitiation> reply = frame.as<RangingInitiation>();
+            if(!reply.isValid()) {
+                continue;
+            }
+            _updateNeighbor(static_cast<uint16_t>(reply.get<RangingInitiation::Source>()), DW1000Jang::getReceivePower(), millis());
+            result.count++;
+        }
+        DW1000Jang::setReceiveFrameWaitTimeoutPeriod(applicationTimeout);
+
+        result.success = result.count > 0;
+        return result;
+    }
+
+    uint8_t getNeighborCount() {
+        uint8_t count = 0;
+        for(uint8_t i = 0; i < DW1000Jang_NEIGHBORS; i++) {
+            if(_neighbors[i].active) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    const Neighbor* getNeighbor(uint8_t index) {
+        for(uint8_t i = 0; i < DW1000Jang_NEIGHBORS; i++) {
+            if(_neighbors[i].active && index-- == 0) {
+                return &_neighbors[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void scheduleNeighbors(uint32_t max_age, uint32_t now) {
+        for(uint8_t i = 0; i < DW1000Jang_NEIGHBORS; i++) {
+            Neighbor& neighbor = _neighbors[i];
+            if(!neighbor.active) {
+                continue;
+            }
+            if(now - neighbor.last_seen > max_age) {
+                DW1000JangScheduler::removeAnchor(neighbor.address);
+                neighbor.active = false;
+            } else if(DW1000JangScheduler::find(neighbor.address) == nullptr) {
+                DW1000JangScheduler::addAnchor(neighbor.address);
+            }
+        }
+    }
+
+    /* mA * us * V = nJ */
+    static double _energyMicrojoules(double current, uint64_t durationUs) {
+        return current * durationUs * DW1000_SUPPLY_VOLTAGE / 1000.0;
+    }
+
+    DutyCycleResult tagDutyCycledLocalize(DutyCycleTag& tag, uint16_t finalMessageDelay) {
+        DutyCycleResult result;
+
+        if(tag.blink_rate == 0) {
+            tag.blink_rate = DEFAULT_BLINK_RATE_MS;
+        }
+
+        int32_t remaining = static_cast<int32_t>(tag.next_wake - millis());
+        if(tag.next_wake == 0 || remaining < 0) {
+            remaining = 0;
+        }
+        if(remaining > 0) {
+            if(tag.mcu_sleep != nullptr) {
+                tag.mcu_sleep(remaining);
+            } else {
+                delay(remaining);
+            }
+        }
+        result.sleep_time = remaining;
+
+        uint32_t wakeMillis = millis();
+        uint32_t wakeStart = micros();
+        RangeInfrastructureResult localize = {false, 0};
+        /* no exchange with a chip that did not wake up, the next period retries */
+        boolean awake = DW1000Jang::spiWakeup();
+        if(awake) {
+            localize = DW1000JangRTLS::tagTwrLocalize(finalMessageDelay);
+        }
+        DW1000Jang::deepSleep();
+        result.awake_time = micros() - wakeStart;
+        result.wakeup_time = awake ? DW1000Jang::getWakeupDuration() : result.awake_time;
+        result.success = localize.success;
+
+        if(localize.success && localize.new_blink_rate != 0) {
+            tag.blink_rate = localize.new_blink_rate;
+        }
+        result.blink_rate = tag.blink_rate;
+
+        tag.next_wake = (tag.next_wake == 0 ? wakeMillis : tag.next_wake) + tag.blink_rate;
+        if(static_cast<int32_t>(tag.next_wake - millis()) < 0) {
+            /* the exchange overran the period, restart the schedule */
+            tag.next_wake = millis() + tag.blink_rate;
+        }
+
+        uint32_t exchangeTime = result.awake_time > result.wakeup_time ? result.awake_time - result.wakeup_time : 0;
+        result.energy = _energyMicrojoules(DW1000_DEEPSLEEP_CURRENT_MA + tag.mcu_sleep_current, static_cast<uint64_t>(result.sleep_time) * 1000)
+            + _energyMicrojoules(DW1000_IDLE_CURRENT_MA + tag.mcu_active_current, result.wakeup_time)
+            + _energyMicrojoules(DW1000_RX_CURRENT_MA + tag.mcu_active_current, exchangeTime);
+
+        return result;
+    }
+
 
     //------------------------------------------ tuning function ---------------------------------------------------    
 
@@ -665,33 +1156,31 @@ namespace DW1000JangRTLS
             returnValue = {false, 0};
         } else {
 
-            size_t poll_len = DW1000Jang::getReceivedDataLength();
-            byte poll_data[poll_len];
-            DW1000Jang::getReceivedData(poll_data, poll_len);
+            ReceivedFrame poll;
+            poll.read();
 
-            if(poll_len > 9 && poll_data[9] == RANGING_TAG_POLL) {
+            if(poll.is<Poll>()) {
                 uint64_t timePollReceived = DW1000Jang::getReceiveTimestamp();
-                DW1000JangRTLS::transmitResponseToPoll(&poll_data[7]);
-                DW1000JangRTLS::waitForTransmission();
-                uint64_t timeResponseToPoll = DW1000Jang::getTransmitTimestamp();
-                delayMicroseconds(1500);
+                DW1000JangRTLS::expectResponse(ResponseToPoll::length(), _finalMessageDelay, FinalMessage::length(), REPLY_PROCESSING_US);
+                DW1000JangRTLS::transmitResponseToPoll(poll.as<Poll>().at<Poll::Source>());
 
-                if(!DW1000JangRTLS::receiveFrame()) {
+                if(!DW1000JangRTLS::waitForResponse()) {
                     returnValue = {false, 0};
                 } else {
 
-                    size_t rfinal_len = DW1000Jang::getReceivedDataLength();
-                    byte rfinal_data[rfinal_len];
-                    DW1000Jang::getReceivedData(rfinal_data, rfinal_len);
-                    if(rfinal_len > 18 && rfinal_data[9] == RANGING_TAG_FINAL_RESPONSE_EMBEDDED) {
+                    ReceivedFrame frame;
+                    frame.read();
+                    View<FinalMessage> rfinal_data = frame.as<FinalMessage>();
+                    if(rfinal_data.isValid()) {
+                        uint64_t timeResponseToPoll = DW1000Jang::getTransmitTimestamp();
                         uint64_t timeFinalMessageReceive = DW1000Jang::getReceiveTimestamp();
 
                         range = DW1000JangRanging::computeRangeAsymmetric(
-                            DW1000JangUtils::bytesAsValue(rfinal_data + 10, LENGTH_TIMESTAMP), // Poll send time
+                            rfinal_data.get<FinalMessage::PollSent>(), // Poll send time
                             timePollReceived, 
                             timeResponseToPoll, // Response to poll sent time
-                            DW1000JangUtils::bytesAsValue(rfinal_data + 14, LENGTH_TIMESTAMP), // Response to Poll Received
-                            DW1000JangUtils::bytesAsValue(rfinal_data + 18, LENGTH_TIMESTAMP), // Final Message send time
+                            rfinal_data.get<FinalMessage::ResponseReceived>(), // Response to Poll Received
+                            rfinal_data.get<FinalMessage::FinalSent>(), // Final Message send time
                             timeFinalMessageReceive // Final message receive time
                         );
 
@@ -702,9 +1191,9 @@ namespace DW1000JangRTLS
                         DW1000JangUtils::writeValueToBytes(finishValue, value, 2);
 
                         if(next == NextActivity::RANGING_CONFIRM) {
-                            DW1000JangRTLS::transmitRangingConfirm_v2(&rfinal_data[7], finishValue, range);
+                            DW1000JangRTLS::transmitRangingConfirm_v2(rfinal_data.at<FinalMessage::Source>(), finishValue, range);
                         } else {
-                            DW1000JangRTLS::transmitActivityFinished_v2(&rfinal_data[7], finishValue, range);
+                            DW1000JangRTLS::transmitActivityFinished_v2(rfinal_data.at<FinalMessage::Source>(), finishValue, range);
                         }
                         
                         DW1000JangRTLS::waitForTransmission();
@@ -721,44 +1210,201 @@ namespace DW1000JangRTLS
         return returnValue;
     }
 
+    /* Answers a discovery blink in this anchor's slot, a slot already passed is skipped and the tag blinks again */
+    static void _answerDiscovery(View<Blink> blink) {
+        if(_discoverySlot == 0 || blink.get<Blink::ExtHeader>() != DISCOVERY_REQUEST) {
+            return;
+        }
+        byte futureTimeBytes[LENGTH_TIMESTAMP];
+        uint64_t txTime = DW1000Jang::getReceiveTimestamp() + DW1000JangTime::microsecondsToUWBTime(static_cast<uint64_t>(_discoverySlot) * _discoverySlotDuration);
+        txTime &= ~static_cast<uint64_t>(0x1FF);
+        DW1000JangUtils::writeValueToBytes(futureTimeBytes, txTime, LENGTH_TIMESTAMP);
+        DW1000Jang::setDelayedTRX(futureTimeBytes);
+
+        /* no address is assigned, the tag keeps its own */
+        byte keep_address[] = {0xFF, 0xFF};
+        Encoder<RangingInitiation> rangingInitiation(SEQ_NUMBER++, blink.at<Blink::TagEui>());
+        RangingInitiation::TagShortAddress::copy(rangingInitiation.data, keep_address);
+        _transmit(rangingInitiation, TransmitMode::DELAYED);
+        if(_cancelLateTransmission()) {
+            return;
+        }
+        DW1000JangRTLS::waitForTransmission();
+    }
+
+    /* Result of a frame that completed no range */
+    static TagRangeAcceptResult _noTagRange(uint16_t tag) {
+        return {false, tag, 0, 0, false, 0};
+    }
+
+    static DW1000JangRanging::FirstPathEstimate _estimateFirstPath(const DW1000JangCIR::CirWindow& cirWindow) {
+        return DW1000JangRanging::estimateFirstPath(cirWindow.leadingEdge,
+            cirWindow.count < DW1000JangCIR::LEADING_EDGE_WINDOW ? cirWindow.count : DW1000JangCIR::LEADING_EDGE_WINDOW,
+            cirWindow.firstIndex, cirWindow.fpIndexFixedPoint);
+    }
+
+    static double _multiTagRange(View<FinalMessage> finalMessage, const DW1000JangSessions::TagSession* session, uint64_t timeFinalMessageReceive) {
+        return DW1000JangRanging::computeRangeAsymmetric(
+            finalMessage.get<FinalMessage::PollSent>(), // Poll send time
+            session->timePollReceived,
+            session->timeResponseToPollSent, // Response to poll sent time
+            finalMessage.get<FinalMessage::ResponseReceived>(), // Response to Poll Received
+            finalMessage.get<FinalMessage::FinalSent>(), // Final Message send time
+            timeFinalMessageReceive // Final message receive time
+        );
+    }
+
+    TagRangeAcceptResult anchorRangeAcceptMultiTag(NextActivity next, uint16_t value)
+    {
+        if(!DW1000JangRTLS::receiveFrame()) {
+            return _noTagRange(0);
+        }
+
+        ReceivedFrame frame;
+        frame.read();
+
+        /* a poll is answered with the receiver armed for the final, the frame received in that window (the final,
+           or the poll of another tag) is handled in turn */
+        while(frame.is<Poll>()) {
+            View<Poll> poll = frame.as<Poll>();
+            DW1000JangSessions::TagSession* session = DW1000JangSessions::open(
+                static_cast<uint16_t>(poll.get<Poll::Source>()),
+                static_cast<byte>(poll.get<Poll::SequenceNumber>())
+            );
+            /* the leading edge only, before the response so no accumulator read overlaps the window of the final */
+            session->timePollReceived = DW1000JangRanging::getFirstPathRefinement()
+                ? DW1000JangRanging::getRefinedReceiveTimestamp() : DW1000Jang::getReceiveTimestamp();
+            session->phasePoll = DW1000Jang::getReceivedPhase();
+            DW1000JangRTLS::expectResponse(ResponseToPoll::length(), _finalMessageDelay, FinalMessage::length(), REPLY_PROCESSING_US);
+            DW1000JangRTLS::transmitResponseToPoll(poll.at<Poll::Source>());
+            boolean received = DW1000JangRTLS::waitForResponse();
+            session->timeResponseToPollSent = DW1000Jang::getTransmitTimestamp();
+            if(!received) {
+                return _noTagRange(session->tag_short_address);
+            }
+            frame.read();
+        }
+
+        if(frame.is<Blink>()) {
+            _answerDiscovery(frame.as<Blink>());
+            return _noTagRange(0);
+        }
+
+        View<FinalMessage> rfinal_data = frame.as<FinalMessage>();
+        if(!rfinal_data.isValid()) {
+            return _noTagRange(0);
+        }
+
+        uint16_t tag = static_cast<uint16_t>(rfinal_data.get<FinalMessage::Source>());
+        DW1000JangSessions::TagSession* session = DW1000JangSessions::findByFinal(tag, static_cast<byte>(rfinal_data.get<FinalMessage::SequenceNumber>()));
+        if(session == nullptr) {
+            /* poll evicted or never received */
+            return _noTagRange(tag);
+        }
+
+        uint64_t timeFinalMessageReceive = DW1000Jang::getReceiveTimestamp();
+        /* read once for the bias correction and the assessment */
+        DW1000Jang::ReceiveDiagnostics diagnostics = DW1000Jang::getReceiveDiagnostics();
+        boolean phaseFinal = frame.is<PhaseFinalMessage>();
+        double phase = 0;
+        if(phaseFinal) {
+            double phaseResponse = static_cast<double>(frame.as<PhaseFinalMessage>().get<PhaseFinalMessage::PhaseResponse>() / 1000.0);
+            phase = fmod(session->phasePoll + phaseResponse, 2 * PI);
+        }
+
+        /* the exchange gives two timestamp pairs of the tag clock for free, the final only carries their low 32 bits */
+        DW1000JangClocks::PeerClock* tagClock = DW1000JangClocks::track(tag);
+        DW1000JangClocks::addTimestamps(tagClock,
+            DW1000JangClocks::unwrapPeerTime(tagClock, rfinal_data.get<FinalMessage::PollSent>(), 32, session->timePollReceived),
+            session->timePollReceived);
+        DW1000JangClocks::addTimestamps(tagClock,
+            DW1000JangClocks::unwrapPeerTime(tagClock, rfinal_data.get<FinalMessage::FinalSent>(), 32, timeFinalMessageReceive),
+            timeFinalMessageReceive);
+        DW1000JangClocks::addClockOffset(tagClock, DW1000Jang::getReceivedClockOffset());
+
+        double range = DW1000JangRanging::correctRange(
+            _multiTagRange(rfinal_data, session, timeFinalMessageReceive), diagnostics.receivePower());
+
+        byte finishValue[2];
+        DW1000JangUtils::writeValueToBytes(finishValue, value, 2);
+
+        if(next == NextActivity::RANGING_CONFIRM) {
+            DW1000JangRTLS::transmitClassifiedRangeReport(rfinal_data.at<FinalMessage::Source>(), finishValue, range, phase,
+                session->nlosLast, session->biasLast);
+        } else {
+            DW1000JangRTLS::transmitActivityFinished_v2(rfinal_data.at<FinalMessage::Source>(), finishValue, range);
+        }
+        DW1000JangRTLS::waitForTransmission();
+
+        /* judged once the tag got its report, a rejected range is not used here */
+        DW1000JangRanging::RangeQuality quality = DW1000JangRanging::assessReception(diagnostics);
+        if(quality.rejected) {
+            session->nlosLast = true;
+            session->biasLast = 0;
+            DW1000JangSessions::close(session);
+            return _noTagRange(tag);
+        }
+
+        /* a single accumulator read for the refinement and the channel class of the final */
+        DW1000JangCIR::CirWindow cirWindow;
+        DW1000JangCIR::readWindow(cirWindow);
+        /* the report carries the range of the hardware timestamp of the final, the refined one is kept here */
+        if(DW1000JangRanging::getFirstPathRefinement()) {
+            range = DW1000JangRanging::correctRange(
+                _multiTagRange(rfinal_data, session, DW1000JangRanging::correctReceiveTimestamp(timeFinalMessageReceive, _estimateFirstPath(cirWindow))),
+                diagnostics.receivePower());
+        }
+
+        /* In case of wrong read due to bad device calibration */
+        if(range <= 0)
+            range = 0.000001;
+
+        DW1000JangCIR::NlosClassification channel = DW1000JangCIR::classify(DW1000JangCIR::computeFeatures(cirWindow));
+        session->nlosLast = channel.nlos;
+        session->biasLast = channel.bias;
+        DW1000JangSessions::close(session);
+        return {true, tag, range, quality.weight, channel.nlos, channel.bias};
+    }
+
     static RangeResult_v2 tagFinishRange_v2(uint16_t anchor, uint16_t replyDelayUs) {
         RangeResult_v2 returnValue;
 
         byte target_anchor[2];
         DW1000JangUtils::writeValueToBytes(target_anchor, anchor, 2);
+        DW1000JangRTLS::expectResponse(Poll::length(), 0, ResponseToPoll::length());
         DW1000JangRTLS::transmitPoll(target_anchor);
         /* Start of poll control for range */
-        if(!DW1000JangRTLS::waitForNextRangingStep()) {
+        if(!DW1000JangRTLS::waitForResponse()) {
             returnValue = {false, false, 0, 0, 0};
         } else {
 
-            size_t cont_len = DW1000Jang::getReceivedDataLength();
-            byte cont_recv[cont_len];
-            DW1000Jang::getReceivedData(cont_recv, cont_len);
+            ReceivedFrame frame;
+            frame.read();
+            View<ResponseToPoll> cont_recv = frame.as<ResponseToPoll>();
 
-            if (cont_len > 10 && cont_recv[9] == ACTIVITY_CONTROL && cont_recv[10] == RANGING_CONTINUE) {
+            if (cont_recv.isValid()) {
                 /* Received Response to poll */
+                DW1000JangRTLS::expectResponse(FinalMessage::length(), 0, RangeReport::length());
                 DW1000JangRTLS::transmitFinalMessage(
-                    &cont_recv[7], 
+                    cont_recv.at<ResponseToPoll::Source>(), 
                     replyDelayUs, 
                     DW1000Jang::getTransmitTimestamp(), // Poll transmit time
                     DW1000Jang::getReceiveTimestamp()  // Response to poll receive time
                 );
 
-                if(!DW1000JangRTLS::waitForNextRangingStep()) {
+                if(!DW1000JangRTLS::waitForResponse()) {
                     returnValue = {false, false, 0, 0, 0};
                 } else {
 
-                    size_t act_len = DW1000Jang::getReceivedDataLength();
-                    byte act_recv[act_len];
-                    DW1000Jang::getReceivedData(act_recv, act_len);
-
+                    frame.read();
 
-                    if(act_len > 10 && act_recv[9] == ACTIVITY_CONTROL) {
-                        if (act_len > 12 && act_recv[10] == RANGING_CONFIRM) {
-                            returnValue = {true, true, static_cast<uint16_t>(DW1000JangUtils::bytesAsValue(&act_recv[11], 2)), 0, static_cast<double>(DW1000JangUtils::bytesAsValue(&act_recv[13],2) / 1000.0)};
-                        } else if(act_len > 12 && act_recv[10] == ACTIVITY_FINISHED) {
-                            returnValue = {true, false, 0, calculateNewBlinkRate(act_recv), static_cast<double>(DW1000JangUtils::bytesAsValue(&act_recv[13],2) / 1000.0)};
+                    if(frame.is<ActivityControl>()) {
+                        if (frame.is<RangeReport>()) {
+                            View<RangeReport> act_recv = frame.as<RangeReport>();
+                            returnValue = {true, true, static_cast<uint16_t>(act_recv.get<RangeReport::NextAnchor>()), 0, static_cast<double>(act_recv.get<RangeReport::Range>() / 1000.0)};
+                        } else if(frame.is<ActivityFinished>()) {
+                            View<ActivityFinished> act_recv = frame.as<ActivityFinished>();
+                            returnValue = {true, false, 0, calculateNewBlinkRate(act_recv), static_cast<double>(act_recv.get<ActivityFinished::Range>() / 1000.0)};
                         }
                     } else {
                         returnValue = {false, false, 0, 0, 0};
@@ -893,7 +1539,7 @@ namespace DW1000JangRTLS
 
                 if(result.success && result.new_blink_rate != 0) {
                     keep_going = 0;
-                    returnValue = { true, static_cast<uint16_t>(result.new_blink_rate), main_dist, b_dist, c_dist };
+                    returnValue = { true, result.new_blink_rate, main_dist, b_dist, c_dist };
                 } else {
                     if(!result.success) {
                         keep_going = 0;
@@ -929,86 +1575,222 @@ namespace DW1000JangRTLS
 //     double distance;
 // }New_structure;
 
-    New_structure Tag_Distance_Request(uint16_t anchor_address, uint16_t finalMessageDelay)
+    static New_structure tagDistanceExchange(uint16_t anchor_address, uint16_t finalMessageDelay, boolean scheduled, uint64_t pollTime)
     {
-        New_structure returnValue;
+        New_structure returnValue = {false, 0, false, 0};
 
         byte target_anchor[2];
         DW1000JangUtils::writeValueToBytes(target_anchor, anchor_address, 2);
-        DW1000JangRTLS::transmitPoll(target_anchor);
+        DW1000JangRTLS::expectResponse(Poll::length(), 0, ResponseToPoll::length());
+        if(scheduled) {
+            DW1000JangRTLS::transmitPollAt(target_anchor, pollTime);
+        } else {
+            DW1000JangRTLS::transmitPoll(target_anchor);
+        }
         /* Start of poll control for range */
-        if(!DW1000JangRTLS::waitForNextRangingStep()) {
+        if(!DW1000JangRTLS::waitForResponse()) {
 
             // Serial.println("response fail");
-            returnValue = {false, 0};
+            returnValue = {false, 0, false, 0};
         } 
 
         else 
         {
             // Serial.println("response success");
-            size_t cont_len = DW1000Jang::getReceivedDataLength();
-            byte cont_recv[cont_len];
-            DW1000Jang::getReceivedData(cont_recv, cont_len);
+            ReceivedFrame frame;
+            frame.read();
+            View<ResponseToPoll> cont_recv = frame.as<ResponseToPoll>();
 
-            if (cont_len > 10 && cont_recv[9] == ACTIVITY_CONTROL && cont_recv[10] == RANGING_CONTINUE) 
+            if (cont_recv.isValid()) 
             {
                 /* Received Response to poll */
+                DW1000JangRTLS::expectResponse(FinalMessage::length(), 0, ClassifiedRangeReport::length());
                 DW1000JangRTLS::transmitFinalMessage(
-                    &cont_recv[7], 
+                    cont_recv.at<ResponseToPoll::Source>(), 
                     finalMessageDelay, 
                     DW1000Jang::getTransmitTimestamp(), // Poll transmit time
                     DW1000Jang::getReceiveTimestamp()  // Response to poll receive time
                 );
-                DW1000JangRTLS::waitForTransmission();
                 // Serial.println("Final msg trans");
                 
 
-                if(!DW1000JangRTLS::receiveFrame()) {
+                if(!DW1000JangRTLS::waitForResponse()) {
                     // Serial.println("RANGE_CONFIRM_receive_fail");
-                    returnValue = {false, 0};
+                    returnValue = {false, 0, false, 0};
                 }
                 else 
                 {
                     
-                    size_t act_len = DW1000Jang::getReceivedDataLength();
-                    char act_recv[act_len];
-                    DW1000Jang::getReceivedData(act_recv, act_len);
+                    frame.read();
 
-                    // Serial.println(act_len);
+                    // Serial.println(frame.length());
                     
 
-                    if(act_len > 10 && act_recv[9] == ACTIVITY_CONTROL) 
+                    if(frame.is<ActivityControl>()) 
                     {
                         // Serial.println("RANGE_CONFIRM_receive_ok1");
-                        // Serial.println(act_recv[10]);
-                        if (act_len > 12 && act_recv[10] == RANGING_CONFIRM) 
+                        if (frame.is<RangeReport>()) 
                         {
                             // Serial.println("RANGE_CONFIRM_receive_ok2");
-                            double tmp = static_cast<double>(DW1000JangUtils::bytesAsValue(&act_recv[13],2) / 1000.0);
+                            double tmp = static_cast<double>(frame.as<RangeReport>().get<RangeReport::Range>() / 1000.0);
                             if(tmp > 65)
                                 tmp = 0;
                             
-                            returnValue = {true, tmp};
+                            returnValue = {true, tmp, false, 0};
+                            if(frame.is<ClassifiedRangeReport>()) {
+                                View<ClassifiedRangeReport> report = frame.as<ClassifiedRangeReport>();
+                                returnValue.nlos = report.get<ClassifiedRangeReport::Nlos>() != 0;
+                                returnValue.nlos_bias = static_cast<double>(report.get<ClassifiedRangeReport::Bias>() / 1000.0);
+                            }
                         } 
                         
                     } 
                     else 
                     {
                         // Serial.println("RANGE_CONFIRM_receive_nono");
-                        returnValue = {false, 0};
+                        returnValue = {false, 0, false, 0};
                     }
                 }
             } 
             else 
             {
-                returnValue = {false, 0};
+                returnValue = {false, 0, false, 0};
             } 
         }
     
         return returnValue;
     }
 
+    New_structure Tag_Distance_Request(uint16_t anchor_address, uint16_t finalMessageDelay)
+    {
+        return tagDistanceExchange(anchor_address, finalMessageDelay, false, 0);
+    }
+
+    New_structure Tag_Distance_Request(uint16_t anchor_address, uint16_t finalMessageDelay, uint64_t pollTime)
+    {
+        return tagDistanceExchange(anchor_address, finalMessageDelay, true, pollTime);
+    }
+
+
+
+    RangeBurstResult tagRangeBurst(uint16_t anchor_address, uint8_t exchanges)
+    {
+        RangeBurstResult result = {false, 0, 0, 0, 0, 0, 0, 0};
+        if(exchanges > MAX_BURST_EXCHANGES) {
+            exchanges = MAX_BURST_EXCHANGES;
+        }
+
+        /* Final RMARKER after the response RMARKER: rest of the response on air, turnaround on both sides, final preamble */
+        DataRate rate = DW1000Jang::getDataRate();
+        uint32_t finalDelay = DW1000JangTime::payloadDurationMicroseconds(rate, _onAirLength(ResponseToPoll::length()))
+            + DW1000JangTime::preambleDurationMicroseconds(rate, DW1000Jang::getPulseFrequency(), DW1000Jang::getPreambleLength())
+            + BURST_PROCESSING_US;
+
+        byte target_anchor[2];
+        DW1000JangUtils::writeValueToBytes(target_anchor, anchor_address, 2);
+
+        double ranges[MAX_BURST_EXCHANGES];
+        double weights[MAX_BURST_EXCHANGES];
+        double phaseRe = 0, phaseIm = 0;
+        uint8_t phaseCount = 0;
+        ReceivedFrame frame;
+
+        for(uint8_t i = 0; i < exchanges; i++) {
+            DW1000JangRTLS::expectResponse(Poll::length(), 0, ResponseToPoll::length());
+            DW1000JangRTLS::transmitPoll(target_anchor);
+            boolean responded = DW1000JangRTLS::waitForResponse();
+            uint64_t timePollSent = DW1000Jang::getTransmitTimestamp();
+            if(i == 0) {
+                result.first_poll_sent = timePollSent;
+            }
+            if(!responded) {
+                continue;
+            }
+            frame.read();
+            if(!frame.as<ResponseToPoll>().isValid()) {
+                continue;
+            }
+            /* the response crossed the same channel as the rest of the exchange */
+            DW1000JangRanging::RangeQuality quality = DW1000JangRanging::assessLastReception();
+            if(quality.rejected) {
+                continue;
+            }
+
+            double phaseResponse = DW1000Jang::getReceivedPhase();
+            DW1000JangRTLS::expectResponse(PhaseFinalMessage::length(), 0, ClassifiedRangeReport::length());
+            DW1000JangRTLS::transmitFinalMessage_v2(
+                frame.as<ResponseToPoll>().at<ResponseToPoll::Source>(),
+                finalDelay,
+                timePollSent, // Poll transmit time
+                DW1000Jang::getReceiveTimestamp(),  // Response to poll receive time
+                phaseResponse
+            );
+            /* the processing overran BURST_PROCESSING_US, the final would leave 17 s later */
+            if(_cancelLateTransmission()) {
+                continue;
+            }
+            if(!DW1000JangRTLS::waitForResponse()) {
+                continue;
+            }
+            frame.read();
+            if(!frame.is<RangeReport>()) {
+                continue;
+            }
+
+            weights[result.count] = quality.weight;
+            ranges[result.count++] = static_cast<double>(frame.as<RangeReport>().get<RangeReport::Range>() / 1000.0);
+            if(frame.is<PhaseRangeReport>()) {
+                double phase = static_cast<double>(frame.as<PhaseRangeReport>().get<PhaseRangeReport::Phase>() / 1000.0);
+                phaseRe += cos(phase);
+                phaseIm += sin(phase);
+                phaseCount++;
+            }
+        }
+
+        if(result.count == 0) {
+            return result;
+        }
+        result.success = true;
+
+        double sum = 0, weightSum = 0, weightSquares = 0;
+        for(uint8_t i = 0; i < result.count; i++) {
+            sum += weights[i] * ranges[i];
+            weightSum += weights[i];
+            weightSquares += weights[i] * weights[i];
+        }
+        result.mean = sum / weightSum;
 
+        /* unbiased variance with reliability weights, equal to the sample variance when all weights are equal */
+        double squares = 0;
+        for(uint8_t i = 0; i < result.count; i++) {
+            squares += weights[i] * (ranges[i] - result.mean) * (ranges[i] - result.mean);
+        }
+        double denominator = weightSum - weightSquares / weightSum;
+        result.variance = denominator > 0 ? squares / denominator : 0;
+
+        /* insertion sort, the burst is short */
+        for(uint8_t i = 1; i < result.count; i++) {
+            double value = ranges[i];
+            uint8_t j = i;
+            while(j > 0 && ranges[j - 1] > value) {
+                ranges[j] = ranges[j - 1];
+                j--;
+            }
+            ranges[j] = value;
+        }
+        result.median = (result.count % 2) ? ranges[result.count / 2]
+            : (ranges[result.count / 2 - 1] + ranges[result.count / 2]) / 2;
+
+        if(phaseCount > 0) {
+            /* averaging unit vectors avoids the wrap at 2 pi, their mean length tells how coherent the phases are */
+            result.phase = atan2(phaseIm, phaseRe);
+            if(result.phase < 0) {
+                result.phase += 2 * PI;
+            }
+            result.phase_coherence = sqrt(phaseRe*phaseRe + phaseIm*phaseIm) / phaseCount;
+        }
+        return result;
+    }
 
     RangeAcceptResult Anchor_Distance_Response()
     {
@@ -1022,37 +1804,35 @@ namespace DW1000JangRTLS
         else 
         {
 
-            size_t poll_len = DW1000Jang::getReceivedDataLength();
-            byte poll_data[poll_len];
-            DW1000Jang::getReceivedData(poll_data, poll_len);
+            ReceivedFrame poll;
+            poll.read();
 
-            if(poll_len > 9 && poll_data[9] == RANGING_TAG_POLL) 
+            if(poll.is<Poll>()) 
             {
                 uint64_t timePollReceived = DW1000Jang::getReceiveTimestamp();
-                DW1000JangRTLS::transmitResponseToPoll(&poll_data[7]);
-                DW1000JangRTLS::waitForTransmission();
-                uint64_t timeResponseToPoll = DW1000Jang::getTransmitTimestamp();
-                delayMicroseconds(1500);
+                DW1000JangRTLS::expectResponse(ResponseToPoll::length(), _finalMessageDelay, FinalMessage::length(), REPLY_PROCESSING_US);
+                DW1000JangRTLS::transmitResponseToPoll(poll.as<Poll>().at<Poll::Source>());
 
-                if(!DW1000JangRTLS::receiveFrame()) {
+                if(!DW1000JangRTLS::waitForResponse()) {
                     Serial.println("final_receive_fail");
                     returnValue = {false, 0};
                 }
                 else 
                 {
 
-                    size_t rfinal_len = DW1000Jang::getReceivedDataLength();
-                    byte rfinal_data[rfinal_len];
-                    DW1000Jang::getReceivedData(rfinal_data, rfinal_len);
-                    if(rfinal_len > 18 && rfinal_data[9] == RANGING_TAG_FINAL_RESPONSE_EMBEDDED) {
+                    ReceivedFrame frame;
+                    frame.read();
+                    View<FinalMessage> rfinal_data = frame.as<FinalMessage>();
+                    if(rfinal_data.isValid()) {
+                        uint64_t timeResponseToPoll = DW1000Jang::getTransmitTimestamp();
                         uint64_t timeFinalMessageReceive = DW1000Jang::getReceiveTimestamp();
 
                         range = DW1000JangRanging::computeRangeAsymmetric(
-                            DW1000JangUtils::bytesAsValue(rfinal_data + 10, LENGTH_TIMESTAMP), // Poll send time
+                            rfinal_data.get<FinalMessage::PollSent>(), // Poll send time
                             timePollReceived, 
                             timeResponseToPoll, // Response to poll sent time
-                            DW1000JangUtils::bytesAsValue(rfinal_data + 14, LENGTH_TIMESTAMP), // Response to Poll Received
-                            DW1000JangUtils::bytesAsValue(rfinal_data + 18, LENGTH_TIMESTAMP), // Final Message send time
+                            rfinal_data.get<FinalMessage::ResponseReceived>(), // Response to Poll Received
+                            rfinal_data.get<FinalMessage::FinalSent>(), // Final Message send time
                             timeFinalMessageReceive // Final message receive time
                         );
 
@@ -1060,7 +1840,7 @@ namespace DW1000JangRTLS
 
 
                         byte target_anchor[] = {0x00, 0x00};
-                        DW1000JangRTLS::transmitRangingConfirm_v2(&rfinal_data[7], target_anchor, range);
+                        DW1000JangRTLS::transmitRangingConfirm_v2(rfinal_data.at<FinalMessage::Source>(), target_anchor, range);
                         DW1000JangRTLS::waitForTransmission();
                         Serial.println("range_confirm_sent");
 
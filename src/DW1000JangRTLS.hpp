@@ -25,6 +25,8 @@
 #pragma once
 
 #include <Arduino.h>
+#include "DW1000JangTDoA.hpp"
+#include "DW1000JangCompileOptions.hpp"
 
 /* Frame control */
 constexpr byte BLINK = 0xC5;
@@ -47,6 +49,30 @@ constexpr byte RANGING_TAG_FINAL_RESPONSE_EMBEDDED = 0x23;
 constexpr byte RANGING_TAG_FINAL_RESPONSE_NO_EMBEDDED = 0x25;
 constexpr byte RANGING_TAG_FINAL_SEND_TIME = 0x27;
 constexpr byte RANGING_TAG_POST_FINAL_RESPONSE_EMBEDDED = 0x29;
+/* Not part of ISO/IEC 24730-62, used by the TDMA superframe */
+constexpr byte SUPERFRAME_BEACON = 0x30;
+/* Not part of ISO/IEC 24730-62, used by the downlink TDoA mode */
+constexpr byte TDOA_BEACON = 0x31;
+
+/* Superframe: slot 0 carries the coordinator beacon, slots 1..MAX_SUPERFRAME_SLOTS are assigned to tags */
+constexpr uint8_t MAX_SUPERFRAME_SLOTS = 10;
+/* Minimum lead time to schedule a delayed transmission at a slot start, later slots are skipped */
+constexpr uint16_t SLOT_SCHEDULE_MARGIN_US = 500;
+
+/* Burst ranging: exchanges stored per burst, and the time the two devices need to turn a frame around */
+constexpr uint8_t MAX_BURST_EXCHANGES = 16;
+constexpr uint16_t BURST_PROCESSING_US = 800;
+
+/* Upper bound of the processing between a reception and a reply delayed from the system time (e.g. transmitFinalMessage) */
+constexpr uint16_t REPLY_PROCESSING_US = 2000;
+
+/* Duty-cycled tag: typical DW1000 supply current in mA per state (datasheet, channel 5, 3.3 V) used for the energy estimate */
+constexpr double DW1000_DEEPSLEEP_CURRENT_MA = 0.0001;
+constexpr double DW1000_IDLE_CURRENT_MA = 18.0;
+constexpr double DW1000_RX_CURRENT_MA = 118.0;
+constexpr double DW1000_SUPPLY_VOLTAGE = 3.3;
+/* Period used until the infrastructure sends a blink rate */
+constexpr uint32_t DEFAULT_BLINK_RATE_MS = 1000;
 
 /* Activity code */
 constexpr byte ACTIVITY_FINISHED = 0x00;
@@ -67,6 +93,8 @@ constexpr byte NO_EX_ID = 0x40;
 /* BLINK Ext Header */
 constexpr byte BLINK_RATE_AND_LISTENING = 0x01;
 constexpr byte TAG_LISTENING_NOW = 0x02;
+/* Not part of ISO/IEC 24730-62, asks every anchor in range for a ranging initiation in its discovery slot */
+constexpr byte DISCOVERY_REQUEST = 0x04;
 
 enum class NextActivity {
     ACTIVITY_FINISHED,
@@ -76,6 +104,10 @@ enum class NextActivity {
 typedef struct New_structure {
     boolean success;
     double distance;
+    /* previous exchange seen without line of sight by an anchor running anchorRangeAcceptMultiTag, false for other anchors */
+    boolean nlos;
+    /* estimated positive bias of an NLOS range in meters, not subtracted from distance */
+    double nlos_bias;
 } New_structure;
 
 typedef struct RangeRequestResult {
@@ -100,22 +132,117 @@ typedef struct RangeResult_v2 {
 
 typedef struct RangeInfrastructureResult {
     boolean success;
-    uint16_t new_blink_rate;
+    uint32_t new_blink_rate;
 } RangeInfrastructureResult;
 
 typedef struct RangeInfrastructureResult_v2 {
     boolean success;
-    uint16_t new_blink_rate;
+    uint32_t new_blink_rate;
     double main_dist;
     double b_dist;
     double c_dist;
 } RangeInfrastructureResult_v2;
 
+typedef struct SuperframeSlot {
+    boolean success;
+    uint16_t superframe_number;
+    byte slot;
+    uint64_t slot_start;
+    uint16_t slot_duration;
+} SuperframeSlot;
+
+typedef struct TdoaAnchorResult {
+    boolean success;
+    byte round;
+    double rate_offset;
+} TdoaAnchorResult;
+
+typedef struct TdoaRoundResult {
+    boolean success;
+    byte round;
+    uint8_t count;
+    double range_difference[DW1000JangTDoA::MAX_TDOA_ANCHORS];
+} TdoaRoundResult;
+
+typedef struct UplinkBlinkResult {
+    boolean success;
+    byte tag_eui[8];
+    byte sequence;
+    uint64_t reference_time;
+} UplinkBlinkResult;
+
 typedef struct RangeAcceptResult {
     boolean success;
     double range;
 } RangeAcceptResult;
 
+typedef struct TagRangeAcceptResult {
+    boolean success;
+    uint16_t tag_short_address;
+    double range;
+    /* reception quality of the final message, see DW1000JangRanging::assessLastReception */
+    double weight;
+    /* channel of the final message classified from its impulse response, see DW1000JangCIR */
+    boolean nlos;
+    /* estimated positive bias of an NLOS range in meters, not subtracted from range */
+    double nlos_bias;
+} TagRangeAcceptResult;
+
+typedef struct RangeBurstResult {
+    boolean success;
+    /* completed exchanges */
+    uint8_t count;
+    /* statistics of the ranges in meters, the mean is weighted by the reception quality of each exchange */
+    double mean;
+    double median;
+    double variance;
+    /* circular mean of the two-way carrier phase in radians and its coherence (0..1, 0 if the anchor reports no phase) */
+    double phase;
+    double phase_coherence;
+    /* TX timestamp of the first poll, e.g. to measure the latency from a wake up */
+    uint64_t first_poll_sent;
+} RangeBurstResult;
+
+typedef struct Neighbor {
+    uint16_t address;
+    /* receive power of its last discovery reply in dBm */
+    float rx_power;
+    /* millis() of its last discovery reply */
+    uint32_t last_seen;
+    boolean active;
+} Neighbor;
+
+typedef struct DiscoveryResult {
+    boolean success;
+    /* anchors that answered this discovery */
+    uint8_t count;
+} DiscoveryResult;
+
+typedef struct DutyCycleTag {
+    /* period between fixes in ms, replaced by the blink rate of each ActivityFinished */
+    uint32_t blink_rate;
+    /* millis() of the next wake up, 0 wakes up at the first call */
+    uint32_t next_wake;
+    /* puts the MCU to sleep for the given ms (millis() must keep counting), delay() is used when nullptr */
+    void (*mcu_sleep)(uint32_t ms);
+    /* MCU supply current in mA while awake and while sleeping, 0 to estimate the DW1000 alone */
+    double mcu_active_current;
+    double mcu_sleep_current;
+} DutyCycleTag;
+
+typedef struct DutyCycleResult {
+    boolean success;
+    /* period until the next fix in ms */
+    uint32_t blink_rate;
+    /* time spent sleeping before this fix in ms */
+    uint32_t sleep_time;
+    /* DW1000 wake up time and time from the wake up to deep sleep in us */
+    uint32_t wakeup_time;
+    uint32_t awake_time;
+    /* estimated energy of the whole period (sleep included) in uJ */
+    double energy;
+} DutyCycleResult;
+
 namespace DW1000JangRTLS {
     /*** TWR functions used in ISO/IEC 24730-62:2013, refer to the standard or the decawave manual for details about TWR ***/
     byte increaseSequenceNumber();
@@ -137,14 +264,48 @@ namespace DW1000JangRTLS {
     void transmitRangingConfirm_v1(byte tag_short_address[], double distance);
     void transmitRangingConfirm_v2(byte tag_short_address[], byte next_anchor[], double distance);
     void transmitRangingConfirm_v3(byte tag_short_address[], double distance);
+    void transmitPhaseRangeReport(byte tag_short_address[], byte next_anchor[], double distance, double phase);
+    void transmitClassifiedRangeReport(byte tag_short_address[], byte next_anchor[], double distance, double phase, boolean nlos, double bias);
     void transmitActivityFinished_v2(byte tag_short_address[], byte blink_rate[], double distance);
 
+    /* Low power listening: receiveFrame duty cycles the receiver with the preamble sniff mode (DW1000Jang::enableSniffMode)
+        while response windows (expectResponse) and delayed receptions keep it fully on.
+       returns false if the current preamble is too short to be sniffed, receiveFrame then listens continuously.
+    */
+    boolean setSniffListening(boolean enable);
+
     boolean receiveFrame();
     boolean receiveFrame_v2(uint64_t timeDelay);
     boolean receiveFrame_v3(uint64_t timeDelay);
+    /* Waits for the end of the last transmission, returns at once if its frame could not be loaded and was not sent */
     void waitForTransmission();
     boolean waitForNextRangingStep();
     boolean waitForNextRangingStep_v2(uint64_t timeDelay);
+
+    /* Arms the hardware receive turnaround (WAIT4RESP) for the next transmission of txLength bytes.
+       replyDelay is the time in us between the RMARKER of the transmitted frame and the RMARKER of the response,
+        as scheduled by the peer with a delayed transmission. The receiver then opens right before the response preamble
+        and the frame wait timeout closes it once a response of responseLength bytes should have been received.
+       Use 0 as replyDelay when the peer answers as soon as it can: the receiver opens at the end of the transmission
+        and the configured frame wait timeout is kept.
+       W4R_TIM is only written when it changes, and the frame wait timeout of a response window is left in place after
+        the response so the reply path has no restore write: receiveFrame and a later expectResponse with replyDelay 0
+        give the application's timeout back.
+       replyJitter is how much later than replyDelay the response may come, e.g. REPLY_PROCESSING_US when the peer
+        schedules its reply from its system time after processing the frame rather than from the reception timestamp.
+    */
+    void expectResponse(uint16_t txLength, uint16_t replyDelay, uint16_t responseLength, uint16_t replyJitter = 0);
+
+    /* Sets the finalMessageDelay the tags pass to their ranging calls, so the anchor flows open the receiver for the
+        final just before it instead of right after the response. It must not exceed the shortest final delay of
+        the tags served (tagRangeBurst sends its final after about the response airtime and BURST_PROCESSING_US).
+       0 (default) when unknown.
+    */
+    void setFinalMessageDelay(uint16_t finalMessageDelay);
+
+    /* Waits for the end of the transmission and for the response armed with expectResponse, no receive command is issued.
+       false on timeout or if the frame could not be loaded and was not sent */
+    boolean waitForResponse();
     /*** End of TWR functions ***/
     
     /* Send a request range from tag to the rtls infrastructure */
@@ -159,6 +320,24 @@ namespace DW1000JangRTLS {
 
     RangeAcceptResult anchorRangeAccept_v2(NextActivity next, uint16_t value);
 
+    /* Multi-tag version of anchorRangeAccept_v2: handles one received frame and returns.
+       Polls open a session per tag (see DW1000JangSessions) and are answered right away with the receiver armed for
+        the final (expectResponse with the setFinalMessageDelay delay), the frame received in that window is handled
+        in the same call. Finals are matched to the session of their tag so exchanges of different tags can interleave.
+       success is true only when a final completed an exchange, the range is also sent back to the tag.
+       If DW1000JangRanging::setFirstPathRefinement is on, the poll timestamp is refined from its leading edge before
+        the response and the final's after the report, which carries the range of the hardware timestamp of the final
+        while the result has the refined one.
+       Each final also updates the clock model of its tag in DW1000JangClocks.
+       A final carrying the response phase (PhaseFinalMessage) is answered with the two-way phase as well.
+       The reception of the final is assessed once the report is sent: likely NLOS ranges are dropped here,
+        success is false and range and weight are 0. Accepted ranges carry the weight of their reception
+        and the LOS/NLOS class of the final, also computed after the report is sent.
+       The class is kept per tag, a RANGING_CONFIRM report (ClassifiedRangeReport) carries the class of the tag's
+        previous final (NLOS as well when it was dropped) so the tag can tell an NLOS anchor from a lost exchange.
+    */
+    TagRangeAcceptResult anchorRangeAcceptMultiTag(NextActivity next, uint16_t value);
+
     /* Used by tag to range after range request accept of the infrastructure 
        Target anchor is given after a range request success
        Finalmessagedelay is used in the process of TWR, a value of 1500 works on 8mhz-80mhz range devices,
@@ -175,9 +354,101 @@ namespace DW1000JangRTLS {
 
     RangeInfrastructureResult_v2 tagTwrLocalize_v2(uint16_t finalMessageDelay);
 
+    /* Runs tagTwrLocalize once per blink rate and keeps the DW1000 in deep sleep in between.
+       Sleeps until tag.next_wake, wakes the DW1000 up with spiWakeup, localizes and puts it back to sleep.
+        If the DW1000 does not wake up, success is false and the whole time awake counts as wake up time.
+       A blink rate sent by the infrastructure (transmitActivityFinished) replaces tag.blink_rate, the next wake up
+        stays aligned to the previous one unless the exchange overran the period.
+       The sleep configuration must have been applied and enable the wake up on SPI.
+       The energy is estimated from the measured times: the exchange is counted at the RX current
+        since the receiver is on whenever the tag does not transmit.
+    */
+    DutyCycleResult tagDutyCycledLocalize(DutyCycleTag& tag, uint16_t finalMessageDelay);
+
 
 //---------------------------- new function -------------------------------------------
     RangeAcceptResult Anchor_Distance_Response();
 
     New_structure Tag_Distance_Request(uint16_t target_anchor, uint16_t finalMessageDelay);
+
+    /* Performs exchanges back to back with the same anchor (answering with anchorRangeAcceptMultiTag) and averages them.
+       exchanges is capped to MAX_BURST_EXCHANGES, the final is sent as soon as both devices can turn the frames around.
+       Exchanges whose response was likely received without line of sight are abandoned before the final,
+        as are those whose final could not be scheduled in time (BURST_PROCESSING_US overrun).
+       success is true if at least one exchange completed.
+    */
+    RangeBurstResult tagRangeBurst(uint16_t target_anchor, uint8_t exchanges);
+
+//---------------------------- Anchor discovery -------------------------------------------
+    /* Used by anchors: answer discovery blinks in anchorRangeAcceptMultiTag with a ranging initiation sent
+        slot * slot_duration us after the blink (delayed transmission), so the replies of the anchors in range do not collide.
+       Give each anchor its own slot, e.g. its short address. Slot 0 stops answering (default).
+       A slot the anchor could not make in time is skipped rather than sent late.
+       The frame filter must accept blinks (allowReservedFive).
+    */
+    void setDiscoverySlot(byte slot, uint16_t slot_duration);
+
+    /* Used by tags: sends a discovery blink and listens to the replies of slots 1..slots, the tag address is kept.
+       Every anchor that answers is added to the neighbor table or refreshed with its receive power and the current time.
+       When the table (DW1000Jang_NEIGHBORS) is full the neighbor seen least recently is replaced.
+       success is true if at least one anchor answered.
+    */
+    DiscoveryResult tagDiscoverAnchors(byte slots, uint16_t slot_duration);
+
+    /* Number of neighbors in the table */
+    uint8_t getNeighborCount();
+
+    /* Neighbor at index (0..getNeighborCount()-1), nullptr out of range */
+    const Neighbor* getNeighbor(uint8_t index);
+
+    /* Makes DW1000JangScheduler range the neighbors seen within max_age ms: new ones are added, the others
+        are removed from the schedule and the table */
+    void scheduleNeighbors(uint32_t max_age, uint32_t now);
+
+//---------------------------- TDMA superframe -------------------------------------------
+    /* Sent by the coordinator anchor at the start of every superframe (slot 0).
+       slot_tags[i] is the short address of the tag owning slot i+1, slot_count is at most MAX_SUPERFRAME_SLOTS
+       (the number of slot addresses a beacon frame carries). The superframe lasts (slot_count + 1) * slot_duration us.
+       returns false and sends nothing if slot_count is larger, waitForTransmission then returns at once.
+    */
+    boolean transmitSuperframeBeacon(uint16_t superframe_number, uint16_t slot_duration, byte slot_count, uint16_t slot_tags[]);
+
+    /* Used by a tag to receive the beacon and find its slot. slot_start is the DW1000 system time of the slot start,
+       success is false if no beacon was received, the tag has no slot, or its slot starts too soon to be scheduled.
+    */
+    SuperframeSlot tagWaitForSuperframe();
+
+    /* Poll transmitted with a delayed transmission at the given DW1000 system time (e.g. a slot start) */
+    void transmitPollAt(byte anchor_address[], uint64_t pollTime);
+
+    /* Tag_Distance_Request with the poll sent at pollTime instead of immediately */
+    New_structure Tag_Distance_Request(uint16_t target_anchor, uint16_t finalMessageDelay, uint64_t pollTime);
+
+//---------------------------- Downlink TDoA -------------------------------------------
+    /* Sent by the master anchor to open a round (slot 0). The beacon leaves tx_delay us from now
+       with a delayed transmission, its transmission time is embedded so listeners can track the master clock rate.
+    */
+    void transmitTdoaMasterBeacon(byte round, uint16_t tx_delay);
+
+    /* Used by the other anchors: waits for the master beacon and answers in the given slot (1..MAX_TDOA_ANCHORS-1),
+        slot * slot_duration us after the master beacon. The reply time is embedded in master clock units.
+       The first master beacon only measures the clock rate, success is true once a beacon has been sent.
+    */
+    TdoaAnchorResult anchorTdoaRound(byte slot, uint16_t slot_duration);
+
+    /* Used by tags: listens to a whole round without transmitting.
+       anchors[0] must be the master, range_difference[i] = |p - anchors[i]| - |p - anchors[0]| is aligned to anchors[].
+       success is true when every anchor was heard, the first round after start up only measures the clock rate.
+       anchor_count is at most DW1000JangTDoA::MAX_TDOA_ANCHORS, the round fails at once (success false, count 0) otherwise.
+    */
+    TdoaRoundResult tagTdoaRound(const DW1000JangTDoA::TdoaAnchor anchors[], uint8_t anchor_count);
+
+//---------------------------- Uplink TDoA -------------------------------------------
+    /* Tags send transmitTwrShortBlink only. The reference anchor sends transmitTdoaMasterBeacon periodically
+       (more often than every 17 s), every anchor timestamps the blinks and reports them in the reference clock.
+       sync is the clock filter of the anchor, nullptr on the reference anchor itself.
+       reference_distance is the distance in meters between this anchor and the reference anchor.
+       Sync beacons are consumed silently, success is true when a blink was timestamped.
+    */
+    UplinkBlinkResult anchorUplinkTdoa(DW1000JangTDoA::ClockSync* sync, double reference_distance);
 }
\ No newline at end of file
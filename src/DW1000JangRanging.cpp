@@ -28,9 +28,37 @@
 #include "DW1000JangRanging.hpp"
 #include "DW1000JangConstants.hpp"
 #include "DW1000JangRTLS.hpp"
+#include "DW1000JangUtils.hpp"
 
 namespace DW1000JangRanging {
 
+    /* Reception quality thresholds, the weight ramps linearly between the two values of each pair */
+    constexpr float POWER_GAP_LOS_DB = 6.0;
+    constexpr float POWER_GAP_NLOS_DB = 10.0;
+    constexpr float FIRST_PATH_SNR_MIN = 2.0;
+    constexpr float FIRST_PATH_SNR_GOOD = 6.0;
+    constexpr int16_t PEAK_DELAY_LOS_TAPS = 3;
+    constexpr int16_t PEAK_DELAY_MULTIPATH_TAPS = 10;
+    /* weight left to a range whose strongest path is far behind the first path, multipath alone does not bias much */
+    constexpr double MULTIPATH_WEIGHT = 0.5;
+
+    /* First path refinement: window read around FP_INDEX and nominal lag of the pulse peak after the leading edge (ticks) */
+    constexpr uint16_t FIRST_PATH_WINDOW_BEFORE = 2;
+    constexpr uint16_t FIRST_PATH_WINDOW = 8;
+    constexpr int32_t FIRST_PATH_RISE = 64;
+
+    /* removed from every corrected range, see setRangeOffset */
+    static double _rangeOffset = 0;
+
+    /* see setFirstPathRefinement */
+    static boolean _firstPathRefinement = false;
+
+    static double _ramp(double value, double full, double none) {
+        if(value <= full) return 1.0;
+        if(value >= none) return 0.0;
+        return (none - value) / (none - full);
+    }
+
     /* asymmetric two-way ranging (more computation intense, less error prone) */
     double computeRangeAsymmetric(    
                                     uint64_t timePollSent, 
@@ -61,10 +89,14 @@ namespace DW1000JangRanging {
     }
 
     double correctRange(double range) {
+        return correctRange(range, DW1000Jang::getReceivePower());
+    }
+
+    double correctRange(double range, float receivePower) {
         double result = 0;
 
         Channel currentChannel = DW1000Jang::getChannel();
-        double rxPower = -(static_cast<double>(DW1000Jang::getReceivePower()));
+        double rxPower = -(static_cast<double>(receivePower));
         
         size_t index = DW1000Jang::getPulseFrequency() == PulseFrequency::FREQ_16MHZ ? 1 : 2;
         if(currentChannel == Channel::CHANNEL_4 || currentChannel == Channel::CHANNEL_7)
@@ -83,7 +115,113 @@ namespace DW1000JangRanging {
             }
         }
 
-        return result;
+        return result - _rangeOffset;
+    }
+
+    void setRangeOffset(double offset) {
+        _rangeOffset = offset;
+    }
+
+    double getRangeOffset() {
+        return _rangeOffset;
+    }
+
+    void setFirstPathRefinement(boolean enable) {
+        _firstPathRefinement = enable;
+    }
+
+    boolean getFirstPathRefinement() {
+        return _firstPathRefinement;
+    }
+
+
+    RangeQuality assessReception(float firstPathPower, float receivePower, float firstPathSnr, uint16_t firstPathIndex, uint16_t peakPathIndex) {
+        RangeQuality quality;
+        quality.powerGap = receivePower - firstPathPower;
+        quality.firstPathSnr = firstPathSnr;
+        quality.peakDelay = static_cast<int16_t>(peakPathIndex) - static_cast<int16_t>(firstPathIndex);
+        quality.rejected = quality.powerGap >= POWER_GAP_NLOS_DB || firstPathSnr <= FIRST_PATH_SNR_MIN;
+
+        if(quality.rejected) {
+            quality.weight = 0;
+            return quality;
+        }
+        double gapWeight = _ramp(quality.powerGap, POWER_GAP_LOS_DB, POWER_GAP_NLOS_DB);
+        /* inverted ramp, the weight grows with the snr */
+        double snrWeight = 1.0 - _ramp(firstPathSnr, FIRST_PATH_SNR_MIN, FIRST_PATH_SNR_GOOD);
+        double peakWeight = 1.0 - (1.0 - MULTIPATH_WEIGHT) * (1.0 - _ramp(quality.peakDelay, PEAK_DELAY_LOS_TAPS, PEAK_DELAY_MULTIPATH_TAPS));
+        quality.weight = gapWeight * snrWeight * peakWeight;
+        return quality;
     }
 
+    RangeQuality assessLastReception() {
+        DW1000Jang::ReceiveDiagnostics diagnostics = DW1000Jang::getReceiveDiagnostics();
+        return assessReception(diagnostics);
+    }
+
+    RangeQuality assessReception(DW1000Jang::ReceiveDiagnostics& diagnostics) {
+        return assessReception(
+            diagnostics.firstPathPower(),
+            diagnostics.receivePower(),
+            diagnostics.firstPathSnr(),
+            diagnostics.firstPathIndex(),
+            diagnostics.peakPathIndex
+        );
+    }
+
+    FirstPathEstimate estimateFirstPath(const int16_t samples[], uint16_t count, uint16_t firstIndex, uint16_t fpIndexFixedPoint) {
+        FirstPathEstimate estimate = {false, 0, 0};
+        if(count > FIRST_PATH_WINDOW) {
+            count = FIRST_PATH_WINDOW;
+        }
+
+        /* log2 of the squared magnitudes: the fit of a parabola is then exact for a gaussian shaped pulse,
+           a fit on the magnitudes themselves is biased by up to a quarter of a tap */
+        int32_t magnitude[FIRST_PATH_WINDOW];
+        for(uint16_t i = 0; i < count; i++) {
+            int32_t re = samples[2*i];
+            int32_t im = samples[2*i + 1];
+            magnitude[i] = DW1000JangUtils::log2Fixed(static_cast<uint32_t>(re*re) + static_cast<uint32_t>(im*im) + 1);
+        }
+
+        /* the peak is searched from the tap of the leading edge on, a tap is needed on each side for the fit */
+        uint16_t fpTap = fpIndexFixedPoint / 64;
+        uint16_t start = fpTap > firstIndex ? fpTap - firstIndex : 0;
+        if(start < 1) {
+            start = 1;
+        }
+        for(uint16_t k = start; k + 1 < count; k++) {
+            if(magnitude[k] < magnitude[k - 1] || magnitude[k] < magnitude[k + 1]) {
+                continue;
+            }
+            /* vertex of the parabola through the three taps, offset in 1/64 tap within [-32, 32] */
+            int32_t curvature = magnitude[k - 1] - 2*magnitude[k] + magnitude[k + 1];
+            int32_t offset = curvature != 0 ? (32 * (magnitude[k - 1] - magnitude[k + 1])) / curvature : 0;
+
+            estimate.valid = true;
+            estimate.peakIndex = static_cast<uint32_t>(firstIndex + k) * 64 + offset;
+            estimate.timestampCorrection = static_cast<int32_t>(estimate.peakIndex) - fpIndexFixedPoint - FIRST_PATH_RISE;
+            return estimate;
+        }
+        return estimate;
+    }
+
+    FirstPathEstimate estimateFirstPath() {
+        int16_t samples[2*FIRST_PATH_WINDOW];
+        uint16_t firstIndex;
+        uint16_t fpIndexFixedPoint = DW1000Jang::getFP_indexFixedPoint();
+        uint16_t count = DW1000Jang::getReceivedCIR(samples, FIRST_PATH_WINDOW_BEFORE, FIRST_PATH_WINDOW, &firstIndex);
+        return estimateFirstPath(samples, count, firstIndex, fpIndexFixedPoint);
+    }
+
+    uint64_t getRefinedReceiveTimestamp() {
+        return correctReceiveTimestamp(DW1000Jang::getReceiveTimestamp(), estimateFirstPath());
+    }
+
+    uint64_t correctReceiveTimestamp(uint64_t timestamp, const FirstPathEstimate& estimate) {
+        if(!estimate.valid) {
+            return timestamp;
+        }
+        return (timestamp + TIME_OVERFLOW + estimate.timestampCorrection) % TIME_OVERFLOW;
+    }
 }
@@ -25,9 +25,33 @@
 #pragma once
 
 #include <Arduino.h>
+#include "DW1000Jang.hpp"
 
 namespace DW1000JangRanging {
 
+    /* Line of sight assessment of a reception, from the first path diagnostics of the DW1000 */
+    typedef struct RangeQuality {
+        /* total receive power - first path power in dB, grows when the direct path is attenuated */
+        float powerGap;
+        /* first path amplitude over the noise standard deviation */
+        float firstPathSnr;
+        /* accumulator taps (~1ns) between the first path and the strongest path */
+        int16_t peakDelay;
+        /* likely NLOS or undetected first path, the range should be dropped */
+        boolean rejected;
+        /* 1 for a clean line of sight reception, lower for likely multipath, 0 when rejected */
+        double weight;
+    } RangeQuality;
+
+    /* Sub-sample position of the first path found in the impulse response */
+    typedef struct FirstPathEstimate {
+        boolean valid;
+        /* peak of the first path lobe in accumulator taps, 10.6 fixed point like FP_INDEX */
+        uint32_t peakIndex;
+        /* to add to the RX timestamp, in DW1000 ticks (1/64 tap) */
+        int32_t timestampCorrection;
+    } FirstPathEstimate;
+
     /** 
     Asymmetric two-way ranging algorithm (more computation intense, less error prone) 
     
@@ -56,4 +80,64 @@ namespace DW1000JangRanging {
     returns the unbiased range
     */
     double correctRange(double range);
+
+    /* Same as correctRange with the receive power already known (see DW1000Jang::ReceiveDiagnostics) */
+    double correctRange(double range, float receivePower);
+
+    /**
+    Sets a constant bias removed by correctRange on top of the receive power bias, e.g. the temperature drift
+    tracked by DW1000JangCalibration::updateTemperatureCompensation
+
+    @param [in] offset bias in meters, positive if the ranges are too long
+    */
+    void setRangeOffset(double offset);
+
+    double getRangeOffset();
+
+    /**
+    Judges the last reception before its range is used.
+    A large gap between the total and the first path power (> 6dB, rejected over 10dB) means the direct path is blocked,
+    a weak first path over noise means the leading edge detection may have locked on a later path,
+    a strongest path far behind the first one means dense multipath.
+    Call it right after the reception, before the receiver is enabled again.
+
+    returns the assessment, weight combines the three criteria
+    */
+    RangeQuality assessLastReception();
+
+    /**
+    Refines the first path of the last reception: the first peak of the impulse response at or after FP_INDEX is located
+    with a parabolic fit of the log magnitude over three taps, in integer arithmetic. The RX timestamp is then moved by the distance between
+    that peak and the leading edge of the chip minus the nominal rise time of a line of sight pulse,
+    so a noisy leading edge detection no longer moves the timestamp. Call it before the receiver is enabled again.
+
+    returns the estimate, valid is false if no peak was found next to FP_INDEX
+    */
+    FirstPathEstimate estimateFirstPath();
+
+    /* Same as estimateFirstPath from an impulse response window already read (see DW1000Jang::getReceivedCIR) */
+    FirstPathEstimate estimateFirstPath(const int16_t samples[], uint16_t count, uint16_t firstIndex, uint16_t fpIndexFixedPoint);
+
+    /* RX timestamp of the last reception corrected by estimateFirstPath, the raw timestamp if no peak was found */
+    uint64_t getRefinedReceiveTimestamp();
+
+    /* Moves an RX timestamp by an estimate of estimateFirstPath, e.g. from a DW1000JangCIR::CirWindow already read */
+    uint64_t correctReceiveTimestamp(uint64_t timestamp, const FirstPathEstimate& estimate);
+
+    /**
+    Opt-in refinement of the RX timestamps of the library flows with getRefinedReceiveTimestamp, off by default.
+    Only anchorRangeAcceptMultiTag applies it: the leading edge of the poll is read before its immediate response,
+     the accumulator of the final once the report is sent.
+    The other flows put their RX timestamps in the frame sent right after the reception, often a delayed transmission,
+     and keep the hardware timestamps so the reply is never delayed by an accumulator read.
+    */
+    void setFirstPathRefinement(boolean enable);
+
+    boolean getFirstPathRefinement();
+
+    /* Same as assessLastReception from diagnostics already read, e.g. also logged with the range */
+    RangeQuality assessReception(DW1000Jang::ReceiveDiagnostics& diagnostics);
+
+    /* Same as assessLastReception from values already read */
+    RangeQuality assessReception(float firstPathPower, float receivePower, float firstPathSnr, uint16_t firstPathIndex, uint16_t peakPathIndex);
 }
\ No newline at end of file
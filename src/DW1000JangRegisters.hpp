@@ -133,8 +133,10 @@ constexpr uint16_t LEN_SYS_TIME = 5;
 constexpr uint16_t RX_TIME = 0x15;
 constexpr uint16_t LEN_RX_TIME = 14;
 constexpr uint16_t RX_STAMP_SUB = 0x00;
+constexpr uint16_t FP_INDEX_SUB = 0x05;
 constexpr uint16_t FP_AMPL1_SUB = 0x07;
 constexpr uint16_t LEN_RX_STAMP = 5;
+constexpr uint16_t LEN_FP_INDEX = 2;
 constexpr uint16_t LEN_FP_AMPL1 = 2;
 
 // RX frame quality
@@ -243,13 +245,21 @@ constexpr uint16_t LEN_DRX_TUNE4H = 2;
 constexpr uint16_t LEN_DRX_CAR_INT = 3;
 constexpr uint16_t LEN_RXPACC_NOSAT = 2;
 
+// ACC_MEM (channel impulse response accumulator, reads start with a dummy byte)
+constexpr uint16_t ACC_MEM = 0x25;
+constexpr uint16_t LEN_ACC_MEM = 4064;
+
 // LDE_CFG1 (for re-tuning only)
 constexpr uint16_t LDE_IF = 0x2E;
 constexpr uint16_t LDE_CFG1_SUB = 0x0806;
+constexpr uint16_t LDE_PPINDX_SUB = 0x1000;
+constexpr uint16_t LDE_PPAMPL_SUB = 0x1002;
 constexpr uint16_t LDE_RXANTD_SUB = 0x1804;
 constexpr uint16_t LDE_CFG2_SUB = 0x1806;
 constexpr uint16_t LDE_REPC_SUB = 0x2804;
 constexpr uint16_t LEN_LDE_CFG1 = 1;
+constexpr uint16_t LEN_LDE_PPINDX = 2;
+constexpr uint16_t LEN_LDE_PPAMPL = 2;
 constexpr uint16_t LEN_LDE_CFG2 = 2;
 constexpr uint16_t LEN_LDE_REPC = 2;
 constexpr uint16_t LEN_LDE_RXANTD = 2;
@@ -267,6 +277,10 @@ constexpr uint16_t LEN_EVC_PTO = 2;
 constexpr uint16_t LEN_EVC_FWTO = 2;
 constexpr uint16_t LEN_DIAG_TMC = 2;
 
+// RX_SNIFF, bits 3:0 on time (PACs, plus one), bits 15:8 off time (~1us units)
+constexpr uint16_t RX_SNIFF = 0x1D;
+constexpr uint16_t LEN_RX_SNIFF = 4;
+
 // TX_POWER (for re-tuning only)
 constexpr uint16_t TX_POWER = 0x1E;
 constexpr uint16_t LEN_TX_POWER = 4;
@@ -337,6 +351,7 @@ constexpr uint16_t PMSC = 0x36;
 constexpr uint16_t PMSC_CTRL0_SUB = 0x00;
 constexpr uint16_t GPDCE_BIT = 18;
 constexpr uint16_t KHZCLKEN_BIT = 23;
+constexpr uint16_t PLL2_SEQ_EN_BIT = 24;
 constexpr uint16_t PMSC_SOFTRESET_SUB = 0x03;
 constexpr uint16_t PMSC_CTRL1_SUB = 0x04;
 constexpr uint16_t ATXSLP_BIT = 11;
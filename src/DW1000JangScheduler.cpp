@@ -0,0 +1,214 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#include <Arduino.h>
+#include "DW1000JangScheduler.hpp"
+
+namespace DW1000JangScheduler {
+
+    /* Alpha-beta gains of the range filter (Benedict-Bordner, beta = alpha^2 / (2 - alpha): a faster, slightly underdamped
+       response than the critically damped beta = 2 - alpha - 2 sqrt(1 - alpha)) and of the residual variance */
+    constexpr double RANGE_ALPHA = 0.5;
+    constexpr double RANGE_BETA = 0.167;
+    constexpr double VARIANCE_GAIN = 0.2;
+
+    namespace {
+        ScheduledAnchor _anchors[DW1000Jang_SCHEDULED_ANCHORS];
+
+        SchedulerConfiguration _config = {
+            100,     // min_interval
+            5000,    // max_interval
+            2000,    // exchange_airtime
+            100000,  // airtime_budget, 10% of the channel
+            0.1,     // range_step
+            0.05     // range_noise
+        };
+
+        boolean _before(uint32_t a, uint32_t b) {
+            return static_cast<int32_t>(a - b) < 0;
+        }
+
+        /* Intervals are divided by, a min_interval of 0 still gives 1 ms */
+        uint32_t _clampInterval(double interval) {
+            uint32_t shortest = _config.min_interval > 0 ? _config.min_interval : 1;
+            if(interval < shortest) {
+                return shortest;
+            }
+            if(interval > _config.max_interval) {
+                return _config.max_interval;
+            }
+            return static_cast<uint32_t>(interval);
+        }
+    }
+
+    void configure(const SchedulerConfiguration& config) {
+        _config = config;
+    }
+
+    ScheduledAnchor* addAnchor(uint16_t address) {
+        ScheduledAnchor* slot = nullptr;
+        for(uint8_t i = 0; i < DW1000Jang_SCHEDULED_ANCHORS; i++) {
+            ScheduledAnchor* anchor = &_anchors[i];
+            if(anchor->active && anchor->address == address) {
+                return anchor;
+            }
+            if(slot == nullptr || (slot->active && (!anchor->active || _before(anchor->lastRange, slot->lastRange)))) {
+                slot = anchor;
+            }
+        }
+        memset(slot, 0, sizeof(ScheduledAnchor));
+        slot->address = address;
+        slot->interval = _clampInterval(_config.min_interval);
+        slot->lastRange = millis();
+        slot->nextRange = slot->lastRange;
+        slot->active = true;
+        return slot;
+    }
+
+    ScheduledAnchor* find(uint16_t address) {
+        for(uint8_t i = 0; i < DW1000Jang_SCHEDULED_ANCHORS; i++) {
+            if(_anchors[i].active && _anchors[i].address == address) {
+                return &_anchors[i];
+            }
+        }
+        return nullptr;
+    }
+
+    double speed() {
+        double fastest = 0;
+        for(uint8_t i = 0; i < DW1000Jang_SCHEDULED_ANCHORS; i++) {
+            if(_anchors[i].active && _anchors[i].samples > 1 && fabs(_anchors[i].rate) > fastest) {
+                fastest = fabs(_anchors[i].rate);
+            }
+        }
+        return fastest;
+    }
+
+    void addRange(uint16_t address, double range, uint32_t now) {
+        ScheduledAnchor* anchor = find(address);
+        if(anchor == nullptr) {
+            anchor = addAnchor(address);
+        }
+
+        double noise = _config.range_noise * _config.range_noise;
+        if(anchor->samples == 0) {
+            anchor->range = range;
+            anchor->rate = 0;
+            anchor->variance = noise;
+        } else {
+            double dt = static_cast<double>(now - anchor->lastRange) / 1000.0;
+            if(dt < 0.001) {
+                dt = 0.001;
+            }
+            double predicted = anchor->range + anchor->rate * dt;
+            double residual = range - predicted;
+            anchor->range = predicted + RANGE_ALPHA * residual;
+            anchor->rate += RANGE_BETA * residual / dt;
+            anchor->variance += VARIANCE_GAIN * (residual * residual - anchor->variance);
+        }
+        if(anchor->samples < UINT16_MAX) {
+            anchor->samples++;
+        }
+        anchor->lastRange = now;
+
+        /* motion the filter did not explain, spread over the last interval */
+        double unexplained = anchor->variance > noise ? sqrt(anchor->variance - noise) : 0;
+        double drift = speed() + unexplained * 1000.0 / anchor->interval;
+        double interval = drift > 0 ? _config.range_step / drift * 1000.0 : _config.max_interval;
+        if(interval > 2.0 * anchor->interval) {
+            interval = 2.0 * anchor->interval;
+        }
+        anchor->interval = _clampInterval(interval);
+        anchor->nextRange = now + anchor->interval;
+
+        /* the tag speed applies to every anchor: the ones scheduled for a slower tag are pulled in */
+        double tagSpeed = speed();
+        if(tagSpeed <= 0) {
+            return;
+        }
+        uint32_t fastest = _clampInterval(_config.range_step / tagSpeed * 1000.0);
+        for(uint8_t i = 0; i < DW1000Jang_SCHEDULED_ANCHORS; i++) {
+            ScheduledAnchor& other = _anchors[i];
+            if(!other.active || &other == anchor || other.interval <= fastest) {
+                continue;
+            }
+            other.interval = fastest;
+            uint32_t due = other.lastRange + fastest;
+            if(_before(due, other.nextRange)) {
+                other.nextRange = _before(due, now) ? now : due;
+            }
+        }
+    }
+
+    void addFailure(uint16_t address, uint32_t now) {
+        ScheduledAnchor* anchor = find(address);
+        if(anchor != nullptr) {
+            anchor->nextRange = now + anchor->interval;
+        }
+    }
+
+    ScheduledRange next(uint32_t now) {
+        ScheduledRange result = {false, 0, _config.max_interval};
+
+        /* air time asked by all anchors per second, in us */
+        double demand = 0;
+        for(uint8_t i = 0; i < DW1000Jang_SCHEDULED_ANCHORS; i++) {
+            if(_anchors[i].active) {
+                demand += 1000.0 / _anchors[i].interval * _config.exchange_airtime;
+            }
+        }
+        double stretch = demand > _config.airtime_budget && _config.airtime_budget > 0 ? demand / _config.airtime_budget : 1.0;
+
+        int32_t mostOverdue = 0;
+        for(uint8_t i = 0; i < DW1000Jang_SCHEDULED_ANCHORS; i++) {
+            const ScheduledAnchor& anchor = _anchors[i];
+            if(!anchor.active) {
+                continue;
+            }
+            uint32_t due = anchor.nextRange + static_cast<uint32_t>((stretch - 1.0) * anchor.interval);
+            int32_t overdue = static_cast<int32_t>(now - due);
+            if(overdue >= 0) {
+                if(!result.due || overdue > mostOverdue) {
+                    result = {true, anchor.address, 0};
+                    mostOverdue = overdue;
+                }
+            } else if(!result.due && static_cast<uint32_t>(-overdue) < result.wait) {
+                result.wait = -overdue;
+            }
+        }
+        return result;
+    }
+
+    void removeAnchor(uint16_t address) {
+        ScheduledAnchor* anchor = find(address);
+        if(anchor != nullptr) {
+            anchor->active = false;
+        }
+    }
+
+    void clear() {
+        memset(_anchors, 0, sizeof(_anchors));
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "DW1000JangCompileOptions.hpp"
+
+namespace DW1000JangScheduler {
+
+    typedef struct SchedulerConfiguration {
+        /* bounds of the interval between two ranges with the same anchor, in ms, the interval is at least 1 ms */
+        uint32_t min_interval;
+        uint32_t max_interval;
+        /* air time of one exchange and air time allowed to all exchanges per second, in us */
+        uint32_t exchange_airtime;
+        uint32_t airtime_budget;
+        /* range change in meters the schedule lets happen between two updates */
+        double range_step;
+        /* standard deviation in meters of the ranges of a static tag */
+        double range_noise;
+    } SchedulerConfiguration;
+
+    /* Motion model and schedule of one anchor, the range is tracked by an alpha-beta filter */
+    typedef struct ScheduledAnchor {
+        uint16_t address;
+        /* filtered range in m, range rate in m/s and variance of the filter residual in m^2 */
+        double range;
+        double rate;
+        double variance;
+        /* millis() of the last range and of the next one, interval in ms */
+        uint32_t lastRange;
+        uint32_t nextRange;
+        uint32_t interval;
+        uint16_t samples;
+        boolean active;
+    } ScheduledAnchor;
+
+    typedef struct ScheduledRange {
+        /* true if an anchor is due now */
+        boolean due;
+        uint16_t address;
+        /* ms until the next anchor is due, 0 if one is due */
+        uint32_t wait;
+    } ScheduledRange;
+
+    /**
+    Sets the rate bounds, the air time budget and the motion thresholds, clears no anchor
+    */
+    void configure(const SchedulerConfiguration& config);
+
+    /**
+    Adds an anchor to the schedule, it is due right away.
+    When the table is full the anchor ranged least recently is replaced.
+
+    @param [in] address short address of the anchor
+
+    returns the schedule of the anchor
+    */
+    ScheduledAnchor* addAnchor(uint16_t address);
+
+    /**
+    Finds the schedule of an anchor
+
+    returns the schedule or nullptr if the anchor is not scheduled
+    */
+    ScheduledAnchor* find(uint16_t address);
+
+    /**
+    Feeds a range and reschedules its anchor.
+    The interval follows the time the range needs to change by range_step at the current speed of the tag
+    (fastest range rate over the anchors) plus the motion the filter could not explain (residual above range_noise).
+    It shortens right away and at most doubles per update, so a tag that stops is ranged less and less often.
+    A faster tag speed also shortens the interval of the other anchors.
+
+    @param [in] address short address of the anchor
+    @param [in] range range in meters
+    @param [in] now millis() of the range
+    */
+    void addRange(uint16_t address, double range, uint32_t now);
+
+    /**
+    Reschedules an anchor whose exchange failed, it is retried after its current interval
+    */
+    void addFailure(uint16_t address, uint32_t now);
+
+    /**
+    Picks the anchor to range: the most overdue one. When the anchors ask for more than the air time budget
+    every interval is stretched by the same factor.
+
+    @param [in] now millis()
+
+    returns the anchor, or the time to wait if none is due
+    */
+    ScheduledRange next(uint32_t now);
+
+    /* Estimated tag speed in m/s, lower bound from the range rates */
+    double speed();
+
+    /* Stops scheduling an anchor */
+    void removeAnchor(uint16_t address);
+
+    /* Removes all anchors */
+    void clear();
+}
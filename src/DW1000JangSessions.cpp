@@ -0,0 +1,97 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#include <Arduino.h>
+#include "DW1000JangSessions.hpp"
+
+namespace DW1000JangSessions {
+
+    namespace {
+        TagSession _sessions[DW1000Jang_TAG_SESSIONS];
+        /* Monotonic use counter, cheaper and more deterministic than millis() for LRU ordering */
+        uint32_t _useCounter = 0;
+
+        void _touch(TagSession* session) {
+            session->lastUse = ++_useCounter;
+        }
+    }
+
+    TagSession* open(uint16_t tag_short_address, byte poll_sequence) {
+        TagSession* slot = nullptr;
+        for(uint8_t i = 0; i < DW1000Jang_TAG_SESSIONS; i++) {
+            TagSession* session = &_sessions[i];
+            /* the slot of the tag, open or closed */
+            if(session->lastUse != 0 && session->tag_short_address == tag_short_address) {
+                slot = session;
+                break;
+            }
+            if(slot == nullptr || (slot->active && !session->active)
+                || (slot->active == session->active && session->lastUse < slot->lastUse)) {
+                slot = session;
+            }
+        }
+        boolean sameTag = slot->lastUse != 0 && slot->tag_short_address == tag_short_address;
+        boolean nlosLast = sameTag && slot->nlosLast;
+        double biasLast = sameTag ? slot->biasLast : 0;
+        memset(slot, 0, sizeof(TagSession));
+        slot->tag_short_address = tag_short_address;
+        slot->poll_sequence = poll_sequence;
+        slot->nlosLast = nlosLast;
+        slot->biasLast = biasLast;
+        slot->active = true;
+        _touch(slot);
+        return slot;
+    }
+
+    TagSession* findByFinal(uint16_t tag_short_address, byte final_sequence) {
+        for(uint8_t i = 0; i < DW1000Jang_TAG_SESSIONS; i++) {
+            TagSession* session = &_sessions[i];
+            if(session->active && session->tag_short_address == tag_short_address
+                && static_cast<byte>(session->poll_sequence + 1) == final_sequence) {
+                _touch(session);
+                return session;
+            }
+        }
+        return nullptr;
+    }
+
+    void close(TagSession* session) {
+        if(session != nullptr) {
+            session->active = false;
+        }
+    }
+
+    void clear() {
+        memset(_sessions, 0, sizeof(_sessions));
+    }
+
+    uint8_t count() {
+        uint8_t n = 0;
+        for(uint8_t i = 0; i < DW1000Jang_TAG_SESSIONS; i++) {
+            if(_sessions[i].active) n++;
+        }
+        return n;
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <Arduino.h>
+#include "DW1000JangCompileOptions.hpp"
+
+namespace DW1000JangSessions {
+
+    /* State of a two-way ranging exchange between the poll and the final message of one tag */
+    typedef struct TagSession {
+        uint16_t tag_short_address;
+        byte poll_sequence;
+        uint64_t timePollReceived;
+        uint64_t timeResponseToPollSent;
+        double phasePoll;
+        /* channel class of the tag's previous final, sent back in the next range report. Kept across the
+           exchanges of the tag as long as its slot is not evicted */
+        boolean nlosLast;
+        double biasLast;
+        uint32_t lastUse;
+        boolean active;
+    } TagSession;
+
+    /**
+    Opens the session of a tag that just sent a poll.
+    A tag has at most one open session: a new poll restarts it. A tag keeps its slot between exchanges, otherwise the
+    least recently used closed slot is taken, and when every slot is open the least recently used session is evicted.
+
+    @param [in] tag_short_address short address of the tag
+    @param [in] poll_sequence sequence number of the poll
+
+    returns the session to fill with the exchange timestamps
+    */
+    TagSession* open(uint16_t tag_short_address, byte poll_sequence);
+
+    /**
+    Finds the session a final message belongs to, the final must follow the poll of the session
+
+    @param [in] tag_short_address short address of the tag
+    @param [in] final_sequence sequence number of the final message
+
+    returns the session or nullptr if the tag has no pending exchange
+    */
+    TagSession* findByFinal(uint16_t tag_short_address, byte final_sequence);
+
+    /* Frees the slot of a completed or aborted exchange */
+    void close(TagSession* session);
+
+    /* Closes all sessions */
+    void clear();
+
+    /* Number of open sessions */
+    uint8_t count();
+}
@@ -0,0 +1,195 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#include <Arduino.h>
+#include "DW1000JangTDoA.hpp"
+#include "DW1000JangConstants.hpp"
+
+namespace DW1000JangTDoA {
+
+    /* Gauss-Newton stops when the update is below 1 mm or after this many iterations */
+    constexpr uint8_t MAX_ITERATIONS = 10;
+    constexpr double CONVERGENCE_M = 0.001;
+
+    /* Clock filter noise: timestamp noise (~0.3 ns), phase and drift random walk per tick of elapsed reference time */
+    constexpr double SYNC_MEASUREMENT_VARIANCE = 400.0;
+    constexpr double SYNC_PHASE_NOISE = 1.6e-8;
+    constexpr double SYNC_DRIFT_NOISE = 1.6e-27;
+    /* crystal tolerance used as initial drift uncertainty */
+    constexpr double SYNC_INITIAL_DRIFT_VARIANCE = 20e-6 * 20e-6;
+
+    static int64_t _elapsed(uint64_t from, uint64_t to) {
+        return static_cast<int64_t>((to + TIME_OVERFLOW - from) % TIME_OVERFLOW);
+    }
+
+    double clockRateOffset(uint64_t remotePrevious, uint64_t remoteNow, uint64_t localPrevious, uint64_t localNow) {
+        int64_t remote = _elapsed(remotePrevious, remoteNow);
+        int64_t local = _elapsed(localPrevious, localNow);
+        if(remote == 0) {
+            return 0;
+        }
+        return static_cast<double>(local - remote) / static_cast<double>(remote);
+    }
+
+    int64_t toRemoteDuration(int64_t localDuration, double rateOffset) {
+        double correction = static_cast<double>(localDuration) * rateOffset / (1.0 + rateOffset);
+        return localDuration - static_cast<int64_t>(correction);
+    }
+
+    void clockSyncReset(ClockSync& sync) {
+        memset(&sync, 0, sizeof(ClockSync));
+    }
+
+    void clockSyncUpdate(ClockSync& sync, uint64_t referenceTime, uint64_t localTime) {
+        if(!sync.initialized) {
+            sync.initialized = true;
+            sync.referenceTime = referenceTime;
+            sync.localTime = localTime;
+            sync.p11 = SYNC_MEASUREMENT_VARIANCE;
+            sync.p12 = 0;
+            if(sync.p22 == 0) {
+                /* no drift measurement yet */
+                sync.drift = 0;
+                sync.p22 = SYNC_INITIAL_DRIFT_VARIANCE;
+            }
+            return;
+        }
+
+        /* predict: x = F x with F = [1 dt; 0 1], the phase prediction is folded in the integer local time */
+        int64_t elapsed = _elapsed(sync.referenceTime, referenceTime);
+        double dt = static_cast<double>(elapsed);
+        uint64_t predicted = (sync.localTime + elapsed + static_cast<int64_t>(dt * sync.drift)) % TIME_OVERFLOW;
+
+        double p11 = sync.p11 + 2*dt*sync.p12 + dt*dt*sync.p22 + SYNC_PHASE_NOISE*dt;
+        double p12 = sync.p12 + dt*sync.p22;
+        double p22 = sync.p22 + SYNC_DRIFT_NOISE*dt;
+
+        /* update with the measured phase error */
+        int64_t innovation = static_cast<int64_t>((localTime + TIME_OVERFLOW - predicted) % TIME_OVERFLOW);
+        if(innovation > TIME_OVERFLOW / 2) {
+            innovation -= TIME_OVERFLOW;
+        }
+        double s = p11 + SYNC_MEASUREMENT_VARIANCE;
+        double k1 = p11 / s;
+        double k2 = p12 / s;
+
+        int64_t phaseCorrection = static_cast<int64_t>(k1 * innovation);
+        sync.localTime = (predicted + TIME_OVERFLOW + phaseCorrection) % TIME_OVERFLOW;
+        sync.referenceTime = referenceTime;
+        sync.drift += k2 * innovation;
+
+        sync.p11 = (1 - k1) * p11;
+        sync.p12 = (1 - k1) * p12;
+        sync.p22 = p22 - k2 * p12;
+    }
+
+    void clockSyncUpdateDrift(ClockSync& sync, double drift, double variance) {
+        if(sync.p22 == 0) {
+            sync.drift = drift;
+            sync.p22 = variance;
+            return;
+        }
+
+        /* measurement of the second state only, H = [0 1] */
+        double s = sync.p22 + variance;
+        double k1 = sync.p12 / s;
+        double k2 = sync.p22 / s;
+        double innovation = drift - sync.drift;
+
+        sync.drift += k2 * innovation;
+        if(sync.initialized) {
+            /* the drift error also moved the phase estimate since the last event */
+            int64_t phaseCorrection = static_cast<int64_t>(k1 * innovation);
+            sync.localTime = (sync.localTime + TIME_OVERFLOW + phaseCorrection) % TIME_OVERFLOW;
+        }
+
+        sync.p11 -= k1 * sync.p12;
+        sync.p12 -= k1 * sync.p22;
+        sync.p22 -= k2 * sync.p22;
+    }
+
+    uint64_t clockSyncToReference(const ClockSync& sync, uint64_t localTime) {
+        if(!sync.initialized) {
+            return localTime;
+        }
+        int64_t elapsed = _elapsed(sync.localTime, localTime);
+        if(elapsed > TIME_OVERFLOW / 2) {
+            /* timestamp older than the last synchronization */
+            elapsed -= TIME_OVERFLOW;
+        }
+        return (sync.referenceTime + TIME_OVERFLOW + toRemoteDuration(elapsed, sync.drift)) % TIME_OVERFLOW;
+    }
+
+    TdoaPosition solvePosition(const TdoaAnchor anchors[], const double rangeDifference[], uint8_t count, double x0, double y0) {
+        if(count < 3) {
+            return {false, x0, y0};
+        }
+
+        double x = x0;
+        double y = y0;
+        for(uint8_t iteration = 0; iteration < MAX_ITERATIONS; iteration++) {
+            double dx0 = x - anchors[0].x;
+            double dy0 = y - anchors[0].y;
+            double d0 = sqrt(dx0*dx0 + dy0*dy0);
+            if(d0 < 1e-6) d0 = 1e-6;
+
+            /* normal equations JtJ * delta = -Jt * r */
+            double a11 = 0, a12 = 0, a22 = 0, b1 = 0, b2 = 0;
+            for(uint8_t i = 1; i < count; i++) {
+                double dxi = x - anchors[i].x;
+                double dyi = y - anchors[i].y;
+                double di = sqrt(dxi*dxi + dyi*dyi);
+                if(di < 1e-6) di = 1e-6;
+
+                double jx = dxi/di - dx0/d0;
+                double jy = dyi/di - dy0/d0;
+                double r = (di - d0) - rangeDifference[i];
+
+                a11 += jx*jx;
+                a12 += jx*jy;
+                a22 += jy*jy;
+                b1 -= jx*r;
+                b2 -= jy*r;
+            }
+
+            double det = a11*a22 - a12*a12;
+            if(fabs(det) < 1e-9) {
+                return {false, x, y};
+            }
+            double stepX = (a22*b1 - a12*b2) / det;
+            double stepY = (a11*b2 - a12*b1) / det;
+            x += stepX;
+            y += stepY;
+
+            if(isnan(x) || isnan(y)) {
+                return {false, x0, y0};
+            }
+            if(fabs(stepX) < CONVERGENCE_M && fabs(stepY) < CONVERGENCE_M) {
+                return {true, x, y};
+            }
+        }
+        return {false, x, y};
+    }
+}
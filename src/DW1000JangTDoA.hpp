@@ -0,0 +1,130 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2018 Michele Biondi, Andrea Salvatori
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace DW1000JangTDoA {
+
+    /* Anchors heard in one downlink round, the master included */
+    constexpr uint8_t MAX_TDOA_ANCHORS = 8;
+
+    typedef struct TdoaAnchor {
+        uint16_t address;
+        double x;
+        double y;
+    } TdoaAnchor;
+
+    typedef struct TdoaPosition {
+        boolean success;
+        double x;
+        double y;
+    } TdoaPosition;
+
+    /**
+    Offset and drift of a local clock against a reference clock, tracked by a two state Kalman filter.
+    The offset is kept as an integer pair of times so 32 bit double targets lose no tick precision,
+    only the drift and the covariance are floating point.
+    */
+    typedef struct ClockSync {
+        boolean initialized;
+        uint64_t referenceTime;
+        /* filtered local time corresponding to referenceTime */
+        uint64_t localTime;
+        /* (local rate - reference rate) / reference rate */
+        double drift;
+        /* covariance of the phase error (ticks^2), cross term and drift, p22 is 0 until the drift is known */
+        double p11;
+        double p12;
+        double p22;
+    } ClockSync;
+
+    /**
+    Fractional rate offset of a local clock against a remote one, (local - remote) / remote, from two events
+    timestamped by both clocks. Timestamps are 40 bit DW1000 times, the wrap is handled.
+
+    @param [in] remotePrevious remote timestamp of the first event
+    @param [in] remoteNow remote timestamp of the second event
+    @param [in] localPrevious local timestamp of the first event
+    @param [in] localNow local timestamp of the second event
+
+    returns the rate offset, e.g. 10e-6 for a local clock 10 ppm faster
+    */
+    double clockRateOffset(uint64_t remotePrevious, uint64_t remoteNow, uint64_t localPrevious, uint64_t localNow);
+
+    /**
+    Converts a duration measured by the local clock to the remote clock.
+    Only the small correction is computed in floating point, so the result keeps tick precision on 32 bit double targets.
+
+    @param [in] localDuration the duration in DW1000 ticks of the local clock
+    @param [in] rateOffset rate offset of the local clock, see clockRateOffset
+
+    returns the duration in ticks of the remote clock
+    */
+    int64_t toRemoteDuration(int64_t localDuration, double rateOffset);
+
+    /* Clears the filter, the next synchronization event restarts it */
+    void clockSyncReset(ClockSync& sync);
+
+    /**
+    Feeds a synchronization event to the filter.
+
+    @param [in] sync the filter state
+    @param [in] referenceTime time of the event in the reference clock (e.g. beacon transmission time)
+    @param [in] localTime time of the same event in the local clock (e.g. beacon reception time minus the flight time)
+    */
+    void clockSyncUpdate(ClockSync& sync, uint64_t referenceTime, uint64_t localTime);
+
+    /**
+    Feeds a direct drift measurement to the filter, e.g. from the carrier integrator of a frame of the reference.
+    Can be used before the first synchronization event, the drift is then kept for when the offset gets known.
+
+    @param [in] sync the filter state
+    @param [in] drift measured (local rate - reference rate) / reference rate
+    @param [in] variance variance of the measurement
+    */
+    void clockSyncUpdateDrift(ClockSync& sync, double drift, double variance);
+
+    /**
+    Converts a local timestamp to the reference clock with the current estimate
+
+    returns the reference time (40 bits), localTime if the filter has no estimate yet
+    */
+    uint64_t clockSyncToReference(const ClockSync& sync, uint64_t localTime);
+
+    /**
+    Solves the 2D position from range differences with Gauss-Newton iterations.
+
+    @param [in] anchors positions of the anchors, anchors[0] is the reference
+    @param [in] rangeDifference rangeDifference[i] = |p - anchors[i]| - |p - anchors[0]| in meters, index 0 is ignored
+    @param [in] count number of anchors (at least 3)
+    @param [in] x0 initial guess, e.g. the last position
+    @param [in] y0 initial guess
+
+    returns the position, success is false if the geometry does not converge
+    */
+    TdoaPosition solvePosition(const TdoaAnchor anchors[], const double rangeDifference[], uint8_t count, double x0, double y0);
+}
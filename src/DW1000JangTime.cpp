@@ -30,4 +30,61 @@ namespace DW1000JangTime {
     uint64_t microsecondsToUWBTime(uint64_t microSeconds) {
         return static_cast<uint64_t>(microSeconds * TIME_RES_INV);
     }
+
+    /* Durations in picoseconds, refer to the DW1000 User Manual (2.18), section 9.3 and the IEEE 802.15.4-2011 UWB PHY */
+    static uint32_t _preambleSymbolPs(PulseFrequency prf) {
+        return prf == PulseFrequency::FREQ_16MHZ ? 993590 : 1017630;
+    }
+
+    static uint32_t _dataSymbolPs(DataRate rate) {
+        switch(rate) {
+            case DataRate::RATE_110KBPS:
+                return 8205130;
+            case DataRate::RATE_850KBPS:
+                return 1025640;
+            default:
+                return 128210;
+        }
+    }
+
+    static uint16_t _preambleSymbols(PreambleLength preamble) {
+        switch(preamble) {
+            case PreambleLength::LEN_64:
+                return 64;
+            case PreambleLength::LEN_128:
+                return 128;
+            case PreambleLength::LEN_256:
+                return 256;
+            case PreambleLength::LEN_512:
+                return 512;
+            case PreambleLength::LEN_1024:
+                return 1024;
+            case PreambleLength::LEN_1536:
+                return 1536;
+            case PreambleLength::LEN_2048:
+                return 2048;
+            default:
+                return 4096;
+        }
+    }
+
+    uint32_t preambleDurationMicroseconds(DataRate rate, PulseFrequency prf, PreambleLength preamble) {
+        uint16_t sfdSymbols = rate == DataRate::RATE_110KBPS ? 64 : 8;
+        uint64_t ps = static_cast<uint64_t>(_preambleSymbols(preamble) + sfdSymbols) * _preambleSymbolPs(prf);
+        return static_cast<uint32_t>((ps + 999999) / 1000000);
+    }
+
+    uint32_t payloadDurationMicroseconds(DataRate rate, uint16_t length) {
+        /* PHR is 21 bits, sent at 110 kbps for the 110 kbps mode and at 850 kbps otherwise */
+        uint32_t phrPs = 21 * (rate == DataRate::RATE_110KBPS ? _dataSymbolPs(DataRate::RATE_110KBPS) : _dataSymbolPs(DataRate::RATE_850KBPS));
+        /* 48 Reed-Solomon parity bits every 330 data bits */
+        uint32_t bits = static_cast<uint32_t>(length) * 8;
+        bits += 48 * ((bits + 329) / 330);
+        uint64_t ps = phrPs + static_cast<uint64_t>(bits) * _dataSymbolPs(rate);
+        return static_cast<uint32_t>((ps + 999999) / 1000000);
+    }
+
+    uint32_t microsecondsToUUS(uint32_t microSeconds) {
+        return (microSeconds * 39) / 40;
+    }
 }
\ No newline at end of file
@@ -25,7 +25,30 @@
 #pragma once
 
 #include <Arduino.h>
+#include "DW1000JangConstants.hpp"
 
 namespace DW1000JangTime {
     uint64_t microsecondsToUWBTime(uint64_t microSeconds);
+
+    /**
+    Duration of the preamble and SFD, i.e. from the start of the frame on air to its RMARKER.
+
+    @param [in] rate data rate of the frame
+    @param [in] prf pulse repetition frequency of the frame
+    @param [in] preamble preamble length of the frame
+    returns the duration in microseconds (rounded up)
+    */
+    uint32_t preambleDurationMicroseconds(DataRate rate, PulseFrequency prf, PreambleLength preamble);
+
+    /**
+    Duration of the PHR and data part (with Reed-Solomon parity), i.e. from the RMARKER to the end of the frame.
+
+    @param [in] rate data rate of the frame
+    @param [in] length frame length in bytes, CRC included
+    returns the duration in microseconds (rounded up)
+    */
+    uint32_t payloadDurationMicroseconds(DataRate rate, uint16_t length);
+
+    /* Converts microseconds to the ~1.026us units (512/499.2 MHz) used by W4R_TIM and RX_FWTO */
+    uint32_t microsecondsToUUS(uint32_t microSeconds);
 }
\ No newline at end of file
@@ -137,5 +137,14 @@ namespace DW1000JangUtils {
 		}
 		memcpy(bytes, eui_byte, LEN_EUI);
 	}
-	
+
+	int32_t log2Fixed(uint32_t value) {
+		uint8_t exponent = 31;
+		while(exponent > 0 && !(value & (static_cast<uint32_t>(1) << exponent))) {
+			exponent--;
+		}
+		uint32_t fraction = ((value << (31 - exponent)) >> 15) & 0xFFFF;
+		uint32_t correction = (((fraction * (65536 - fraction)) >> 16) * 22713) >> 16;
+		return static_cast<int32_t>(exponent) * 256 + static_cast<int32_t>((fraction + correction) >> 8);
+	}
 }
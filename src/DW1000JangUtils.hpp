@@ -107,4 +107,13 @@ namespace DW1000JangUtils {
     @param [out] eui_byte The eui bytes
     */
 	void convertToByte(const char string[], byte* eui_byte);
+
+    /**
+    Integer log2, the mantissa uses log2(1+f) ~ f + 0.3466 f (1-f) (error below 0.01)
+
+    @param [in] value the value, 0 gives 0
+
+    returns log2(value) in 8 bit fixed point
+    */
+    int32_t log2Fixed(uint32_t value);
 }